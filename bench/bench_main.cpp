@@ -0,0 +1,336 @@
+// Native micro-benchmarks for the parse and digest code in lib/RouterParse,
+// run over the recorded responses in fixtures.h:
+//
+//   pio run -e native -t exec                  (all benchmarks)
+//   .pio/build/native/program status           (only names containing "status")
+//
+// Each benchmark repeats until it has run for at least BENCH_MIN_TIME_S and
+// reports time per operation, throughput over the input bytes and heap
+// allocations per operation (operator new plus ArduinoJson document
+// allocations). Before timing, the results are checked once against the
+// fixtures so a broken parser cannot post a fast number.
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <new>
+#include <string>
+
+#include "JsonWriter.h"
+#include "ScanTable.h"
+#include "SignalHistory.h"
+#include "StatusDigest.h"
+#include "fixtures.h"
+
+namespace {
+
+const double BENCH_MIN_TIME_S = 0.25;
+const size_t BENCH_SCAN_CAPACITY = 64;   // SCAN_MAX_NETWORKS in config.h.example
+const size_t BENCH_CHUNK_SIZE = 1436;    // JSON_WRITER_CHUNK_SIZE in config.h.example
+const size_t BENCH_HISTORY_CAPACITY = 360;  // HISTORY_CAPACITY in config.h.example
+const size_t BENCH_HISTORY_POINTS = 120;    // HISTORY_DEFAULT_POINTS in config.h.example
+
+unsigned long allocationCount = 0;
+
+struct CountingAllocator {
+  void* allocate(size_t size) {
+    allocationCount++;
+    return malloc(size);
+  }
+  void deallocate(void* pointer) { free(pointer); }
+  void* reallocate(void* pointer, size_t size) {
+    allocationCount++;
+    return realloc(pointer, size);
+  }
+};
+
+using BenchJsonDocument = BasicJsonDocument<CountingAllocator>;
+
+// Sink that only counts, so the writer's own cost is measured
+struct CountingSink : JsonSink {
+  size_t bytes = 0;
+  size_t writes = 0;
+  void write(const char* data, size_t length) override {
+    bytes += length;
+    writes++;
+  }
+};
+
+const char* benchFilter = nullptr;
+int failures = 0;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// Prevents the compiler from dropping a computed value
+template <typename T>
+void keep(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+void printHeader() {
+  printf("%-24s %12s %12s %10s %12s\n", "Benchmark", "Time/op", "Iterations", "MB/s", "Allocs/op");
+  printf("%-24s %12s %12s %10s %12s\n", "------------------------", "-------", "----------", "----", "---------");
+}
+
+template <typename Fn>
+void bench(const char* name, size_t bytesPerOp, Fn&& fn) {
+  if (benchFilter != nullptr && strstr(name, benchFilter) == nullptr) {
+    return;
+  }
+  using Clock = std::chrono::steady_clock;
+  fn();  // Warm-up
+
+  unsigned long iterations = 1;
+  while (true) {
+    unsigned long allocationsBefore = allocationCount;
+    Clock::time_point start = Clock::now();
+    for (unsigned long i = 0; i < iterations; i++) {
+      fn();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (seconds >= BENCH_MIN_TIME_S || iterations >= (1UL << 30)) {
+      double nsPerOp = seconds * 1e9 / iterations;
+      double mbPerS = bytesPerOp > 0 ? bytesPerOp * iterations / seconds / 1e6 : 0;
+      double allocsPerOp = static_cast<double>(allocationCount - allocationsBefore) / iterations;
+      printf("%-24s %9.0f ns %12lu %10.1f %12.1f\n", name, nsPerOp, iterations, mbPerS, allocsPerOp);
+      return;
+    }
+    iterations *= seconds < BENCH_MIN_TIME_S / 10 ? 10 : 2;
+  }
+}
+
+// Feed the CSV line by line, the way the FTP fetcher does
+void parseScanCsv(ScanTable& table) {
+  char line[SCAN_CSV_LINE_MAX];
+  size_t length = 0;
+  scanTableClear(table);
+  for (const char* p = FIXTURE_SCAN_CSV; *p != '\0'; p++) {
+    if (*p == '\n') {
+      line[length] = '\0';
+      scanTableParseCsvLine(table, line);
+      length = 0;
+    } else if (length < sizeof(line) - 1) {
+      line[length++] = *p;
+    }
+  }
+}
+
+void parseRestScan(ScanTable& table) {
+  StaticJsonDocument<128> filter;
+  filter[0]["address"] = true;
+  filter[0]["ssid"] = true;
+  filter[0]["channel"] = true;
+  filter[0]["sig"] = true;
+  filter[0]["privacy"] = true;
+  BenchJsonDocument doc(8192);
+  deserializeJson(doc, FIXTURE_REST_SCAN, DeserializationOption::Filter(filter));
+  scanTableClear(table);
+  for (JsonObjectConst entry : doc.as<JsonArrayConst>()) {
+    scanTableAddRestEntry(table, entry);
+  }
+}
+
+size_t writeScanJson(const ScanTable& table, CountingSink& sink) {
+  BasicJsonWriter<BENCH_CHUNK_SIZE> json(sink);
+  char mac[18];
+  json.raw("[", 1);
+  for (size_t i = 0; i < table.count; i++) {
+    const ScanNetwork& network = table.entries[i];
+    if (i > 0) json.raw(",", 1);
+    formatMacAddress(network.bssid, mac);
+    json.raw("{\"ssid\":").string(network.ssid);
+    json.raw(",\"mac\":").string(mac);
+    json.raw(",\"signal\":").number(static_cast<long>(network.signal));
+    json.raw(",\"frequency\":").number(static_cast<unsigned long>(network.frequency));
+    json.raw(",\"privacy\":").boolean(network.flags & SCAN_FLAG_PRIVACY);
+    json.raw("}", 1);
+  }
+  json.raw("]", 1);
+  json.flush();
+  return sink.bytes;
+}
+
+size_t markKnown(ScanTable& table, JsonArrayConst profiles) {
+  const size_t prefixLength = strlen("wifi-manager:ssid=");
+  size_t marked = 0;
+  for (JsonObjectConst profile : profiles) {
+    const char* comment = profile["comment"] | "";
+    if (strncmp(comment, "wifi-manager:ssid=", prefixLength) == 0) {
+      marked += scanTableMarkKnown(table, comment + prefixLength);
+    }
+  }
+  return marked;
+}
+
+size_t parseProfiles(BenchJsonDocument& doc) {
+  StaticJsonDocument<256> filter;
+  filter[0][".id"] = true;
+  filter[0]["name"] = true;
+  filter[0]["comment"] = true;
+  filter[0]["mode"] = true;
+  filter[0]["authentication-types"] = true;
+  filter[0]["wpa2-pre-shared-key"] = true;
+  deserializeJson(doc, FIXTURE_SECURITY_PROFILES, DeserializationOption::Filter(filter));
+  return doc.size();
+}
+
+// Parse the five status responses and digest them, as fetchStatusSnapshot() does
+void digestStatus(std::string& output) {
+  BenchJsonDocument interfaces(2048);
+  BenchJsonDocument registrations(1024);
+  BenchJsonDocument addresses(1024);
+  BenchJsonDocument routes(1024);
+  StaticJsonDocument<256> dns;
+  deserializeJson(interfaces, FIXTURE_INTERFACES);
+  deserializeJson(registrations, FIXTURE_REGISTRATIONS);
+  deserializeJson(addresses, FIXTURE_ADDRESSES);
+  deserializeJson(routes, FIXTURE_ROUTES);
+  deserializeJson(dns, FIXTURE_DNS);
+
+  StaticJsonDocument<768> out;
+  out["connected"] = false;
+  const char* active = statusDigestLink(interfaces.as<JsonArrayConst>(), registrations.as<JsonArrayConst>(), out);
+  if (active[0] != '\0') {
+    statusDigestAddress(addresses.as<JsonArrayConst>(), active, out);
+    statusDigestGateway(routes.as<JsonArrayConst>(), active, out);
+    statusDigestDns(dns["servers"] | "", out);
+  }
+  output.clear();
+  serializeJson(out, output);
+}
+
+// A full history, one sample every 30 s with a link drop in the middle
+void fillHistory(SignalHistory& history) {
+  signalHistoryClear(history);
+  for (size_t i = 0; i < history.capacity + 10; i++) {
+    bool linked = i < 150 || i > 160;
+    HistorySample sample = {static_cast<uint16_t>(i * 30), linked ? static_cast<int8_t>(-60 - i % 8) : HISTORY_NO_SIGNAL,
+                            linked ? static_cast<uint8_t>(80 + i % 10) : HISTORY_NO_CCQ, 65, 58};
+    signalHistoryAdd(history, sample);
+  }
+}
+
+void verifyFixtures() {
+  static ScanTableBuffer<BENCH_SCAN_CAPACITY> table;
+  parseScanCsv(table);
+  printf("scan csv:   %zu networks (%zu dropped)\n", table.count, table.dropped);
+  check(table.count > 40, "CSV parse finds the networks");
+
+  CountingSink sink;
+  size_t jsonBytes = writeScanJson(table, sink);
+  printf("scan json:  %zu bytes in %zu writes\n", jsonBytes, sink.writes);
+  check(jsonBytes > table.count * 60, "scan table JSON is written");
+
+  BenchJsonDocument profiles(4096);
+  check(parseProfiles(profiles) == 14, "all security profiles parsed");
+  size_t known = markKnown(table, profiles.as<JsonArrayConst>());
+  printf("known:      %zu networks match a managed profile\n", known);
+  check(known > 0, "known networks are flagged");
+
+  parseRestScan(table);
+  printf("rest scan:  %zu networks\n", table.count);
+  check(table.count > 30, "REST scan parse finds the networks");
+  check((table.entries[0].flags & SCAN_FLAG_PRIVACY_UNKNOWN) != 0, "REST scan marks privacy unknown");
+
+  BenchJsonDocument registrations(1024);
+  deserializeJson(registrations, FIXTURE_REGISTRATIONS);
+  HistorySample sample = statusDigestLinkSample(registrations.as<JsonArrayConst>(), "wlan1");
+  printf("link:       %d dBm, ccq %u, %u/%u Mbps\n", sample.signal, sample.ccq, sample.txRate, sample.rxRate);
+  check(sample.signal == -61 && sample.ccq == 87, "link sample reads signal and CCQ");
+  check(sample.txRate == 65 && sample.rxRate == 59, "link sample reads the rates");
+
+  static SignalHistoryBuffer<BENCH_HISTORY_CAPACITY> history;
+  fillHistory(history);
+  HistoryBucket buckets[BENCH_HISTORY_POINTS];
+  uint16_t now = static_cast<uint16_t>((history.capacity + 9) * 30);
+  size_t bucketCount = signalHistoryDownsample(history, now, 0, buckets, BENCH_HISTORY_POINTS);
+  printf("history:    %zu samples -> %zu buckets\n", history.count, bucketCount);
+  check(bucketCount == BENCH_HISTORY_POINTS && buckets[bucketCount - 1].ageS == 0, "history downsamples to the newest sample");
+  check(signalHistoryDownsample(history, now, 300, buckets, BENCH_HISTORY_POINTS) == 11, "history window keeps the last samples");
+
+  std::string status;
+  digestStatus(status);
+  printf("status:     %s\n\n", status.c_str());
+  check(status.find("\"connected\":true") != std::string::npos, "status digest sees the link");
+  check(status.find("\"ip\":\"192.168.178.34\"") != std::string::npos, "status digest picks the dynamic address");
+  check(status.find("\"gateway\":\"192.168.178.1\"") != std::string::npos, "status digest finds the gateway");
+  check(status.find("\"dns\":[\"192.168.178.1\",\"9.9.9.9\",\"1.1.1.1\"]") != std::string::npos,
+        "status digest splits the DNS servers");
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocationCount++;
+  void* pointer = malloc(size);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  free(pointer);
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    benchFilter = argv[1];
+  }
+  verifyFixtures();
+  if (failures > 0) {
+    return 1;
+  }
+
+  static ScanTableBuffer<BENCH_SCAN_CAPACITY> table;
+  printHeader();
+  bench("csv_parse", sizeof(FIXTURE_SCAN_CSV) - 1, [&] {
+    parseScanCsv(table);
+    keep(table.count);
+  });
+  bench("rest_scan_parse", sizeof(FIXTURE_REST_SCAN) - 1, [&] {
+    parseRestScan(table);
+    keep(table.count);
+  });
+
+  parseScanCsv(table);
+  CountingSink sizing;
+  size_t jsonBytes = writeScanJson(table, sizing);
+  bench("json_write_table", jsonBytes, [&] {
+    CountingSink sink;
+    keep(writeScanJson(table, sink));
+  });
+
+  uint8_t binary[4096];
+  bench("binary_encode", 0, [&] { keep(scanTableToBinary(table, binary, sizeof(binary), "2ghz-b/g/n")); });
+
+  BenchJsonDocument profiles(4096);
+  bench("profiles_parse", sizeof(FIXTURE_SECURITY_PROFILES) - 1, [&] { keep(parseProfiles(profiles)); });
+  bench("known_match", 0, [&] { keep(markKnown(table, profiles.as<JsonArrayConst>())); });
+
+  static SignalHistoryBuffer<BENCH_HISTORY_CAPACITY> history;
+  fillHistory(history);
+  HistoryBucket buckets[BENCH_HISTORY_POINTS];
+  uint16_t now = static_cast<uint16_t>((history.capacity + 9) * 30);
+  bench("history_downsample", 0, [&] { keep(signalHistoryDownsample(history, now, 0, buckets, BENCH_HISTORY_POINTS)); });
+
+  std::string status;
+  status.reserve(512);
+  size_t statusInput = sizeof(FIXTURE_INTERFACES) + sizeof(FIXTURE_REGISTRATIONS) + sizeof(FIXTURE_ADDRESSES) +
+                       sizeof(FIXTURE_ROUTES) + sizeof(FIXTURE_DNS) - 5;
+  bench("status_digest", statusInput, [&] {
+    digestStatus(status);
+    keep(status.size());
+  });
+  return 0;
+}
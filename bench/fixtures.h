@@ -0,0 +1,83 @@
+#pragma once
+
+// Representative RouterOS 7 responses for the native micro-benchmarks:
+// a save-file scan CSV, the REST scan, and the lists behind /api/status and
+// the profile index. Regenerate from a real router with
+//   /interface wireless scan wlan1 duration=5 save-file=scan.csv
+//   curl -u user:pass http://<router>/rest/<path>?.proplist=...
+
+const char FIXTURE_SCAN_CSV[] = R"FIXTURE(B8:69:F4:A5:4D:CA,'',2412/20/gn,-74,-104,privacy,30,MikroTik
+B8:69:F4:1D:6D:13,'Vodafone-5A2C',5180/20/ac,-55,-104,privacy,49,MikroTik
+B8:69:F4:D9:1E:3F,'Cafe "Central"',2462/20/gn,-43,-104,privacy,61,MikroTik
+B8:69:F4:CB:19:71,'FRITZ!Box 7590 XQ',2412/20/gn,-58,-104,privacy,46,MikroTik
+B8:69:F4:3C:9D:5C,'Telekom_FON',2462/20/gn,-52,-104,privacy,52,MikroTik
+B8:69:F4:20:1E:69,'UPC1234567',2437/20/gn,-89,-104,privacy,15,MikroTik
+B8:69:F4:E8:B9:99,'Cafe "Central"',2462/20/gn,-89,-104,privacy,15,MikroTik
+B8:69:F4:99:FD:AF,'TP-Link_9F3E',5180/20/ac,-47,-104,privacy,57,MikroTik
+B8:69:F4:54:AF:4D,'UPC1234567',5745/20/ac,-44,-104,privacy,60,MikroTik
+B8:69:F4:A0:AE:B3,'UPC1234567',2437/20/gn,-44,-104,,60,MikroTik
+B8:69:F4:8A:F2:21,'FRITZ!Box 7590 XQ',2437/20/gn,-81,-104,privacy,23,MikroTik
+B8:69:F4:E4:91:C5,'',2437/20/gn,-41,-104,,63,MikroTik
+B8:69:F4:B5:56:3B,'UPC1234567',5220/20/ac,-48,-104,privacy,56,MikroTik
+B8:69:F4:CB:C8:FE,'Vodafone-5A2C',5240/20/ac,-75,-104,privacy,29,MikroTik
+B8:69:F4:46:DC:8E,'Hotspot',2462/20/gn,-64,-104,,40,MikroTik
+B8:69:F4:4D:2A:5A,'eduroam',5200/20/ac,-40,-104,privacy,64,MikroTik
+B8:69:F4:5D:86:90,'HomeNet',5500/20/ac,-63,-104,privacy,41,MikroTik
+B8:69:F4:A3:40:1B,'TP-Link_9F3E',2462/20/gn,-91,-104,privacy,13,MikroTik
+B8:69:F4:CB:CC:C9,'Telekom_FON',5240/20/ac,-43,-104,privacy,61,MikroTik
+B8:69:F4:6A:E1:53,'Telekom_FON',5180/20/ac,-46,-104,privacy,58,MikroTik
+B8:69:F4:4D:33:BA,'HomeNet',5200/20/ac,-79,-104,privacy,25,MikroTik
+B8:69:F4:81:B1:BA,'UPC1234567',5240/20/ac,-69,-104,privacy,35,MikroTik
+B8:69:F4:9F:2B:49,'',5220/20/ac,-87,-104,privacy,17,MikroTik
+B8:69:F4:52:0B:69,'iPhone von Anna',5500/20/ac,-41,-104,privacy,63,MikroTik
+B8:69:F4:98:2E:85,'iPhone von Anna',2437/20/gn,-89,-104,privacy,15,MikroTik
+B8:69:F4:A8:72:63,'Cafe "Central"',2462/20/gn,-91,-104,privacy,13,MikroTik
+B8:69:F4:FC:B6:0E,'HomeNet',2437/20/gn,-56,-104,privacy,48,MikroTik
+B8:69:F4:B0:E4:B2,'iPhone von Anna',5180/20/ac,-54,-104,privacy,50,MikroTik
+B8:69:F4:AC:68:F7,'HomeNet',5745/20/ac,-62,-104,privacy,42,MikroTik
+B8:69:F4:2B:3D:C6,'o2-WLAN42',5200/20/ac,-67,-104,privacy,37,MikroTik
+B8:69:F4:AA:2C:CA,'TP-Link_9F3E',5180/20/ac,-86,-104,privacy,18,MikroTik
+B8:69:F4:41:0E:4D,'TP-Link_9F3E',2412/20/gn,-79,-104,,25,MikroTik
+B8:69:F4:F2:B3:4F,'eduroam',5745/20/ac,-81,-104,privacy,23,MikroTik
+B8:69:F4:47:DE:63,'',2412/20/gn,-41,-104,privacy,63,MikroTik
+B8:69:F4:95:7B:A6,'MikroTik-3F21A0',2412/20/gn,-43,-104,,61,MikroTik
+B8:69:F4:B5:EA:D7,'eduroam',2462/20/gn,-72,-104,privacy,32,MikroTik
+B8:69:F4:E1:5D:02,'eduroam',5240/20/ac,-79,-104,privacy,25,MikroTik
+B8:69:F4:1F:A6:F7,'Telekom_FON',2412/20/gn,-55,-104,privacy,49,MikroTik
+B8:69:F4:15:32:E7,'HomeNet',2412/20/gn,-68,-104,privacy,36,MikroTik
+B8:69:F4:66:8D:E7,'UPC1234567',2412/20/gn,-84,-104,privacy,20,MikroTik
+B8:69:F4:84:67:E5,'eduroam',5240/20/ac,-68,-104,privacy,36,MikroTik
+B8:69:F4:7B:DB:25,'o2-WLAN42',2412/20/gn,-89,-104,privacy,15,MikroTik
+B8:69:F4:BB:49:81,'eduroam',2412/20/gn,-87,-104,,17,MikroTik
+B8:69:F4:CB:F9:53,'Cafe "Central"',5240/20/ac,-72,-104,privacy,32,MikroTik
+B8:69:F4:D7:64:B6,'',5745/20/ac,-63,-104,privacy,41,MikroTik
+B8:69:F4:EA:E1:09,'WLAN-AB12CD',5500/20/ac,-58,-104,privacy,46,MikroTik
+B8:69:F4:20:39:75,'Telekom_FON',5220/20/ac,-42,-104,,62,MikroTik
+B8:69:F4:5C:8A:42,'Hotspot',2462/20/gn,-56,-104,privacy,48,MikroTik
+B8:69:F4:FD:A7:2D,'MikroTik-3F21A0',5745/20/ac,-51,-104,privacy,53,MikroTik
+B8:69:F4:25:89:08,'Vodafone-5A2C',2412/20/gn,-78,-104,,26,MikroTik
+B8:69:F4:22:87:3E,'TP-Link_9F3E',5500/20/ac,-66,-104,,38,MikroTik
+B8:69:F4:89:42:16,'Cafe "Central"',2412/20/gn,-56,-104,privacy,48,MikroTik
+B8:69:F4:67:9F:9C,'o2-WLAN42',5500/20/ac,-83,-104,privacy,21,MikroTik
+B8:69:F4:B1:09:80,'FRITZ!Box 7590 XQ',5745/20/ac,-72,-104,privacy,32,MikroTik
+B8:69:F4:61:F3:7D,'TP-Link_9F3E',5745/20/ac,-67,-104,privacy,37,MikroTik
+B8:69:F4:C9:9D:6E,'',2437/20/gn,-52,-104,,52,MikroTik
+B8:69:F4:47:CF:B1,'FRITZ!Box 7590 XQ',2412/20/gn,-44,-104,privacy,60,MikroTik
+B8:69:F4:82:DC:53,'FRITZ!Box 7590 XQ',5240/20/ac,-72,-104,privacy,32,MikroTik
+B8:69:F4:90:7C:96,'FRITZ!Box 7590 XQ',5200/20/ac,-57,-104,privacy,47,MikroTik
+B8:69:F4:86:BA:A8,'Nachbar',5220/20/ac,-53,-104,privacy,51,MikroTik
+)FIXTURE";
+
+const char FIXTURE_REST_SCAN[] = R"FIXTURE([{".id":"*8","address":"B8:69:F4:A5:4D:CA","ssid":"","channel":"2412/20/gn","sig":"-74","nf":"-104","snr":"30","radio-name":"","routeros-version":""},{".id":"*ABB","address":"B8:69:F4:1D:6D:13","ssid":"Vodafone-5A2C","channel":"5180/20/ac","sig":"-55","nf":"-104","snr":"49","radio-name":"","routeros-version":""},{".id":"*C36","address":"B8:69:F4:D9:1E:3F","ssid":"Cafe \"Central\"","channel":"2462/20/gn","sig":"-43","nf":"-104","snr":"61","radio-name":"","routeros-version":""},{".id":"*2AF","address":"B8:69:F4:CB:19:71","ssid":"FRITZ!Box 7590 XQ","channel":"2412/20/gn","sig":"-58","nf":"-104","snr":"46","radio-name":"","routeros-version":""},{".id":"*F30","address":"B8:69:F4:3C:9D:5C","ssid":"Telekom_FON","channel":"2462/20/gn","sig":"-52","nf":"-104","snr":"52","radio-name":"","routeros-version":""},{".id":"*8EC","address":"B8:69:F4:20:1E:69","ssid":"UPC1234567","channel":"2437/20/gn","sig":"-89","nf":"-104","snr":"15","radio-name":"","routeros-version":""},{".id":"*66E","address":"B8:69:F4:E8:B9:99","ssid":"Cafe \"Central\"","channel":"2462/20/gn","sig":"-89","nf":"-104","snr":"15","radio-name":"","routeros-version":""},{".id":"*7F1","address":"B8:69:F4:99:FD:AF","ssid":"TP-Link_9F3E","channel":"5180/20/ac","sig":"-47","nf":"-104","snr":"57","radio-name":"","routeros-version":""},{".id":"*28","address":"B8:69:F4:54:AF:4D","ssid":"UPC1234567","channel":"5745/20/ac","sig":"-44","nf":"-104","snr":"60","radio-name":"","routeros-version":""},{".id":"*2E8","address":"B8:69:F4:A0:AE:B3","ssid":"UPC1234567","channel":"2437/20/gn","sig":"-44","nf":"-104","snr":"60","radio-name":"","routeros-version":""},{".id":"*874","address":"B8:69:F4:8A:F2:21","ssid":"FRITZ!Box 7590 XQ","channel":"2437/20/gn","sig":"-81","nf":"-104","snr":"23","radio-name":"","routeros-version":""},{".id":"*2DF","address":"B8:69:F4:E4:91:C5","ssid":"","channel":"2437/20/gn","sig":"-41","nf":"-104","snr":"63","radio-name":"","routeros-version":""},{".id":"*49A","address":"B8:69:F4:B5:56:3B","ssid":"UPC1234567","channel":"5220/20/ac","sig":"-48","nf":"-104","snr":"56","radio-name":"","routeros-version":""},{".id":"*CC8","address":"B8:69:F4:CB:C8:FE","ssid":"Vodafone-5A2C","channel":"5240/20/ac","sig":"-75","nf":"-104","snr":"29","radio-name":"","routeros-version":""},{".id":"*155","address":"B8:69:F4:46:DC:8E","ssid":"Hotspot","channel":"2462/20/gn","sig":"-64","nf":"-104","snr":"40","radio-name":"","routeros-version":""},{".id":"*C9B","address":"B8:69:F4:4D:2A:5A","ssid":"eduroam","channel":"5200/20/ac","sig":"-40","nf":"-104","snr":"64","radio-name":"","routeros-version":""},{".id":"*B8","address":"B8:69:F4:5D:86:90","ssid":"HomeNet","channel":"5500/20/ac","sig":"-63","nf":"-104","snr":"41","radio-name":"","routeros-version":""},{".id":"*996","address":"B8:69:F4:A3:40:1B","ssid":"TP-Link_9F3E","channel":"2462/20/gn","sig":"-91","nf":"-104","snr":"13","radio-name":"","routeros-version":""},{".id":"*9BC","address":"B8:69:F4:CB:CC:C9","ssid":"Telekom_FON","channel":"5240/20/ac","sig":"-43","nf":"-104","snr":"61","radio-name":"","routeros-version":""},{".id":"*773","address":"B8:69:F4:6A:E1:53","ssid":"Telekom_FON","channel":"5180/20/ac","sig":"-46","nf":"-104","snr":"58","radio-name":"","routeros-version":""},{".id":"*2B4","address":"B8:69:F4:4D:33:BA","ssid":"HomeNet","channel":"5200/20/ac","sig":"-79","nf":"-104","snr":"25","radio-name":"","routeros-version":""},{".id":"*4F7","address":"B8:69:F4:81:B1:BA","ssid":"UPC1234567","channel":"5240/20/ac","sig":"-69","nf":"-104","snr":"35","radio-name":"","routeros-version":""},{".id":"*C76","address":"B8:69:F4:9F:2B:49","ssid":"","channel":"5220/20/ac","sig":"-87","nf":"-104","snr":"17","radio-name":"","routeros-version":""},{".id":"*A6F","address":"B8:69:F4:52:0B:69","ssid":"iPhone von Anna","channel":"5500/20/ac","sig":"-41","nf":"-104","snr":"63","radio-name":"","routeros-version":""},{".id":"*FD0","address":"B8:69:F4:98:2E:85","ssid":"iPhone von Anna","channel":"2437/20/gn","sig":"-89","nf":"-104","snr":"15","radio-name":"","routeros-version":""},{".id":"*4C8","address":"B8:69:F4:A8:72:63","ssid":"Cafe \"Central\"","channel":"2462/20/gn","sig":"-91","nf":"-104","snr":"13","radio-name":"","routeros-version":""},{".id":"*917","address":"B8:69:F4:FC:B6:0E","ssid":"HomeNet","channel":"2437/20/gn","sig":"-56","nf":"-104","snr":"48","radio-name":"","routeros-version":""},{".id":"*4A1","address":"B8:69:F4:B0:E4:B2","ssid":"iPhone von Anna","channel":"5180/20/ac","sig":"-54","nf":"-104","snr":"50","radio-name":"","routeros-version":""},{".id":"*166","address":"B8:69:F4:AC:68:F7","ssid":"HomeNet","channel":"5745/20/ac","sig":"-62","nf":"-104","snr":"42","radio-name":"","routeros-version":""},{".id":"*DBC","address":"B8:69:F4:2B:3D:C6","ssid":"o2-WLAN42","channel":"5200/20/ac","sig":"-67","nf":"-104","snr":"37","radio-name":"","routeros-version":""},{".id":"*475","address":"B8:69:F4:AA:2C:CA","ssid":"TP-Link_9F3E","channel":"5180/20/ac","sig":"-86","nf":"-104","snr":"18","radio-name":"","routeros-version":""},{".id":"*83","address":"B8:69:F4:41:0E:4D","ssid":"TP-Link_9F3E","channel":"2412/20/gn","sig":"-79","nf":"-104","snr":"25","radio-name":"","routeros-version":""},{".id":"*75B","address":"B8:69:F4:F2:B3:4F","ssid":"eduroam","channel":"5745/20/ac","sig":"-81","nf":"-104","snr":"23","radio-name":"","routeros-version":""},{".id":"*2B9","address":"B8:69:F4:47:DE:63","ssid":"","channel":"2412/20/gn","sig":"-41","nf":"-104","snr":"63","radio-name":"","routeros-version":""},{".id":"*FF","address":"B8:69:F4:95:7B:A6","ssid":"MikroTik-3F21A0","channel":"2412/20/gn","sig":"-43","nf":"-104","snr":"61","radio-name":"","routeros-version":""},{".id":"*156","address":"B8:69:F4:B5:EA:D7","ssid":"eduroam","channel":"2462/20/gn","sig":"-72","nf":"-104","snr":"32","radio-name":"","routeros-version":""},{".id":"*442","address":"B8:69:F4:E1:5D:02","ssid":"eduroam","channel":"5240/20/ac","sig":"-79","nf":"-104","snr":"25","radio-name":"","routeros-version":""},{".id":"*B8A","address":"B8:69:F4:1F:A6:F7","ssid":"Telekom_FON","channel":"2412/20/gn","sig":"-55","nf":"-104","snr":"49","radio-name":"","routeros-version":""},{".id":"*35B","address":"B8:69:F4:15:32:E7","ssid":"HomeNet","channel":"2412/20/gn","sig":"-68","nf":"-104","snr":"36","radio-name":"","routeros-version":""},{".id":"*C0D","address":"B8:69:F4:66:8D:E7","ssid":"UPC1234567","channel":"2412/20/gn","sig":"-84","nf":"-104","snr":"20","radio-name":"","routeros-version":""}])FIXTURE";
+
+const char FIXTURE_INTERFACES[] = R"FIXTURE([{".id":"*1","name":"wlan1","mode":"station","ssid":"HomeNet","band":"2ghz-b/g/n","security-profile":"wifi-manager-homenet","station-roaming":"enabled","disabled":"false","running":"true"},{".id":"*2","name":"wlan2","mode":"ap-bridge","ssid":"Guest","band":"5ghz-a/n/ac","security-profile":"default","station-roaming":"disabled","disabled":"true","running":"false"},{".id":"*3","name":"ether-wlan-uplink","mode":"station","ssid":"","band":"","security-profile":"default","station-roaming":"disabled","disabled":"false","running":"false"}])FIXTURE";
+
+const char FIXTURE_REGISTRATIONS[] = R"FIXTURE([{"interface":"wlan1","ssid":"HomeNet","radio-name":"FRITZ!Box","signal-strength":"-61@HT20-7","signal-to-noise":"43","tx-rate":"65Mbps-20MHz/1S","rx-rate":"58.5Mbps-20MHz/1S","tx-ccq":"87"}])FIXTURE";
+
+const char FIXTURE_ADDRESSES[] = R"FIXTURE([{"address":"192.168.10.5/24","network":"192.168.10.0","interface":"bridge","actual-interface":"bridge","dynamic":"false"},{"address":"192.168.178.34/24","network":"192.168.178.0","interface":"wlan1","actual-interface":"wlan1","dynamic":"true"}])FIXTURE";
+
+const char FIXTURE_ROUTES[] = R"FIXTURE([{"dst-address":"0.0.0.0/0","gateway":"192.168.178.1","immediate-gw":"192.168.178.1%wlan1","active":"true"},{"dst-address":"0.0.0.0/0","gateway":"10.0.0.1","immediate-gw":"","active":"false"}])FIXTURE";
+
+const char FIXTURE_DNS[] = R"FIXTURE({"servers":"192.168.178.1, 9.9.9.9,1.1.1.1"})FIXTURE";
+
+const char FIXTURE_SECURITY_PROFILES[] = R"FIXTURE([{".id":"*10","name":"wifi-manager-0","comment":"wifi-manager:ssid=HomeNet","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*11","name":"wifi-manager-1","comment":"wifi-manager:ssid=FRITZ!Box 7590 XQ","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*12","name":"wifi-manager-2","comment":"wifi-manager:ssid=Vodafone-5A2C","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*13","name":"wifi-manager-3","comment":"wifi-manager:ssid=Telekom_FON","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*14","name":"wifi-manager-4","comment":"wifi-manager:ssid=eduroam","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*15","name":"wifi-manager-5","comment":"wifi-manager:ssid=Guest","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*16","name":"wifi-manager-6","comment":"wifi-manager:ssid=o2-WLAN42","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*17","name":"wifi-manager-7","comment":"wifi-manager:ssid=Cafe \"Central\"","mode":"dynamic-keys","authentication-types":"wpa2-psk","wpa2-pre-shared-key":""},{".id":"*30","name":"profile0","comment":"","mode":"none","authentication-types":"","wpa2-pre-shared-key":""},{".id":"*31","name":"profile1","comment":"","mode":"none","authentication-types":"","wpa2-pre-shared-key":""},{".id":"*32","name":"profile2","comment":"","mode":"none","authentication-types":"","wpa2-pre-shared-key":""},{".id":"*33","name":"profile3","comment":"","mode":"none","authentication-types":"","wpa2-pre-shared-key":""},{".id":"*34","name":"profile4","comment":"","mode":"none","authentication-types":"","wpa2-pre-shared-key":""},{".id":"*35","name":"profile5","comment":"","mode":"none","authentication-types":"","wpa2-pre-shared-key":""}])FIXTURE";
@@ -1,14 +1,27 @@
 /**
  * MikroTik WiFi Manager - Frontend JavaScript
+ *
+ * Status view: loaded by index.html after common.js. The scan and connect
+ * part lives in scan.js, which is fetched once the status is on screen.
  */
 
+// Router target chosen with ?target= on the page URL; the backend answers
+// every API call for that target (default: the first one)
+const SELECTED_TARGET = new URLSearchParams(window.location.search).get('target');
+
+function apiPath(path) {
+    if (!SELECTED_TARGET) return path;
+    const separator = path.includes('?') ? '&' : '?';
+    return path + separator + 'target=' + encodeURIComponent(SELECTED_TARGET);
+}
+
 const API = {
     async get(path) {
-        const response = await fetch(path);
+        const response = await fetch(apiPath(path));
         return await response.json();
     },
     async post(path, data) {
-        const response = await fetch(path, {
+        const response = await fetch(apiPath(path), {
             method: 'POST',
             headers: {'Content-Type': 'application/json'},
             body: JSON.stringify(data)
@@ -17,8 +30,6 @@ const API = {
     }
 };
 
-const SUPPORTED_LANGUAGES = ['en', 'de'];
-
 const DEFAULT_TRANSLATIONS = {
     "status.title": "Connection Status",
     "status.text.connected": "Connected",
@@ -31,6 +42,7 @@ const DEFAULT_TRANSLATIONS = {
     "button.forget": "Forget",
     "nav.home": "Dashboard",
     "nav.config": "Configuration",
+    "nav.target": "Router",
     "config.title": "Device Configuration",
     "config.section.wifi": "Wi-Fi Settings",
     "config.section.mikrotik": "MikroTik Settings",
@@ -43,6 +55,7 @@ const DEFAULT_TRANSLATIONS = {
     "config.label.mikrotikPassword": "MikroTik Password",
     "config.label.mikrotikToken": "MikroTik Token",
     "config.label.mikrotikInterface": "MikroTik WLAN Interface",
+    "config.label.mikrotikInterface2": "Second radio for dual-band scans (optional)",
     "config.label.band2": "2.4 GHz Band",
     "config.label.band5": "5 GHz Band",
     "config.label.scanDuration": "Scan duration (seconds)",
@@ -96,96 +109,6 @@ const DEFAULT_TRANSLATIONS = {
     "detail.dns": "DNS servers"
 };
 
-let translations = { ...DEFAULT_TRANSLATIONS };
-let currentLanguage = 'en';
-
-function t(key, params = {}) {
-    const template = translations[key] ?? DEFAULT_TRANSLATIONS[key] ?? key;
-    return template.replace(/\{(\w+)\}/g, (_, prop) => {
-        return params[prop] !== undefined ? params[prop] : `{${prop}}`;
-    });
-}
-
-async function loadTranslations(language) {
-    if (!SUPPORTED_LANGUAGES.includes(language)) {
-        return false;
-    }
-
-    try {
-        const response = await fetch(`/i18n/${language}.json`, { cache: 'no-cache' });
-        if (!response.ok) {
-            return false;
-        }
-        const data = await response.json();
-        translations = { ...DEFAULT_TRANSLATIONS, ...data };
-        currentLanguage = language;
-        return true;
-    } catch (error) {
-        console.warn('Failed to load translations for', language, error);
-        return false;
-    }
-}
-
-async function initTranslations() {
-    const fallback = 'en';
-    const browserLang = (navigator.language || fallback).split('-')[0].toLowerCase();
-    const candidates = [];
-    if (SUPPORTED_LANGUAGES.includes(browserLang)) {
-        candidates.push(browserLang);
-    }
-    if (!candidates.includes(fallback)) {
-        candidates.push(fallback);
-    }
-
-    for (const lang of candidates) {
-        const loaded = await loadTranslations(lang);
-        if (loaded) {
-            break;
-        }
-    }
-
-    document.documentElement.lang = currentLanguage;
-}
-
-function applyTranslationsToDOM() {
-    document.querySelectorAll('[data-i18n]').forEach((el) => {
-        el.textContent = t(el.dataset.i18n);
-    });
-
-    document.querySelectorAll('[data-i18n-placeholder]').forEach((el) => {
-        el.setAttribute('placeholder', t(el.dataset.i18nPlaceholder));
-    });
-
-    document.querySelectorAll('[data-i18n-aria-label]').forEach((el) => {
-        el.setAttribute('aria-label', t(el.dataset.i18nAriaLabel));
-    });
-}
-
-// Utility functions
-function simpleHash(text) {
-    // Simple string hash to create unique profile names
-    let hash = 0;
-    for (let i = 0; i < text.length; i++) {
-        const char = text.charCodeAt(i);
-        hash = ((hash << 5) - hash) + char;
-        hash = hash & hash; // Convert to 32bit integer
-    }
-    // Convert to positive hex (6 characters)
-    return Math.abs(hash).toString(16).padStart(6, '0').substring(0, 6);
-}
-
-function generateProfileName(ssid) {
-    if (!ssid) return Promise.resolve('client-ssid');
-    let base = ssid.trim().toLowerCase();
-    base = base.replace(/[^a-zA-Z0-9_-]+/g, '-');
-    base = base.replace(/^-+|-+$/g, '') || 'ssid';
-    base = base.substring(0, 24);
-
-    // Append hash to ensure uniqueness
-    const hash = simpleHash(ssid);
-    return Promise.resolve(`client-${base}-${hash}`);
-}
-
 function prefixToNetmask(prefix) {
     if (!prefix) return null;
     const prefixNum = parseInt(String(prefix).split('/')[0], 10);
@@ -199,79 +122,6 @@ function prefixToNetmask(prefix) {
     ].join('.');
 }
 
-function asBoolean(value) {
-    if (typeof value === 'boolean') return value;
-    if (value === null || value === undefined) return false;
-    if (typeof value === 'number') return value !== 0;
-    if (typeof value === 'string') {
-        const normalized = value.trim().toLowerCase();
-        return ['true', 'yes', 'on', '1', 'running', 'enabled'].includes(normalized);
-    }
-    return false;
-}
-
-function interpretSecurityFromProfile(profile) {
-    if (!profile) return null;
-    const mode = profile.mode;
-    const authTypes = profile['authentication-types'] || '';
-    return !(mode === 'none' || !authTypes);
-}
-
-function parseCSV(csvText) {
-    const networks = [];
-    const lines = csvText.split('\n');
-
-    for (const line of lines) {
-        if (!line.trim()) continue;
-
-        // Parse CSV fields (comma-separated, with optional quotes)
-        const fields = [];
-        let field = '';
-        let inQuote = false;
-
-        for (let i = 0; i < line.length; i++) {
-            const char = line[i];
-
-            if (char === "'" || char === '"') {
-                inQuote = !inQuote;
-            } else if (char === ',' && !inQuote) {
-                fields.push(field.trim().replace(/^['"]|['"]$/g, ''));
-                field = '';
-            } else {
-                field += char;
-            }
-        }
-        fields.push(field.trim().replace(/^['"]|['"]$/g, ''));
-
-        // Require at least 4 fields: MAC, SSID, channel, signal
-        if (fields.length >= 4) {
-            const ssid = fields[1];
-            if (ssid && ssid.length > 0) {
-                const channel = fields[2] || '';
-                const frequency = channel.indexOf('/') > 0
-                    ? parseInt(channel.substring(0, channel.indexOf('/')), 10)
-                    : 0;
-
-                // Privacy flag (index 5)
-                const privacyField = (fields[5] || '').toLowerCase();
-                const privacy = privacyField === 'privacy';
-
-                networks.push({
-                    ssid: ssid,
-                    mac: fields[0],
-                    address: fields[0],  // Alias
-                    signal: parseInt(fields[3], 10) || 0,
-                    sig: parseInt(fields[3], 10) || 0,  // Alias
-                    frequency: frequency,
-                    privacy: privacy
-                });
-            }
-        }
-    }
-
-    return networks;
-}
-
 let state = {
     currentBand: null,  // Populated from backend config
     selectedNetwork: null,
@@ -282,131 +132,101 @@ let state = {
     allowAutoScan: false,
     config: null,       // Band configuration from backend
     isConnected: false,
-    isConnecting: false
+    isConnecting: false,
+    statusVersion: null, // X-Status-Version of the last rendered /api/status
+    lastStatus: null    // Replayed to scan.js when it arrives after the first status
 };
 
 const AUTO_SCAN_INTERVAL = 10000;
+const STATUS_POLL_INTERVAL = 5000;
+const EVENTS_RETRY_INTERVAL = 30000;
+const SCAN_EVENT_RECHECK_MS = 5000;
+const SCAN_MODULE_SRC = '/scan.js';
+
+// Hooks installed by scan.js (null until it has loaded)
+let scanView = null;
+
+// Push channel (/api/events). While the stream is open, status updates and
+// scan results arrive without polling; the polling paths stay as fallback.
+const Events = {
+    source: null,
+    connected: false,
+    scanWaiters: new Set(),
+
+    start() {
+        if (!window.EventSource || this.source) return;
+        const source = new EventSource(apiPath('/api/events'));
+        this.source = source;
+
+        source.onopen = () => {
+            this.connected = true;
+        };
+        source.onerror = () => {
+            this.connected = false;
+            this.releaseScanWaiters(null);
+            // CLOSED: refused (503, old firmware) - poll for a while, then try again.
+            // Otherwise the browser reconnects on its own.
+            if (source.readyState === EventSource.CLOSED) {
+                source.close();
+                this.source = null;
+                setTimeout(() => this.start(), EVENTS_RETRY_INTERVAL);
+            }
+        };
 
-function enableAutoScan(skipImmediate = false) {
-    if (!state.allowAutoScan) return;
-    if (state.isConnected) return;
-    if (state.autoScanTimer) return;
-    state.autoScanTimer = setInterval(() => {
-        if (!state.isScanning && !state.isConnected) {
-            scan(true);
-        }
-    }, AUTO_SCAN_INTERVAL);
-    if (!state.isScanning && !skipImmediate) {
-        scan(true);
-    }
-}
-
-function disableAutoScan() {
-    if (state.autoScanTimer) {
-        clearInterval(state.autoScanTimer);
-        state.autoScanTimer = null;
-    }
-}
-
-function ensureBandStore(band) {
-    if (!state.networks[band]) {
-        state.networks[band] = [];
-    }
-    return state.networks[band];
-}
-
-function getNetworksForBand(band) {
-    return ensureBandStore(band);
-}
-
-function getNetworksForCurrentBand() {
-    return getNetworksForBand(state.currentBand);
-}
-
-function getNetworkKey(network) {
-    if (!network) return '';
-    const ssid = network.ssid || '';
-    const mac = (network.mac || '').toLowerCase();
-    return `${ssid}__${mac}`;
-}
-
-function normalizeNetworkEntry(entry, band) {
-    if (!entry || !entry.ssid) {
-        return null;
-    }
-    let signal = entry.signal;
-    if (signal === undefined || signal === null) {
-        signal = entry.sig ?? entry.strength ?? entry.rssi ?? null;
-    }
-    if (typeof signal !== 'number') {
-        const parsed = parseInt(signal, 10);
-        signal = Number.isFinite(parsed) ? parsed : 0;
-    }
-    const macAddress = entry.mac || entry.address || entry.bssid || '';
-
-    // Interpret security state (frontend logic)
-    let security = entry.security;
-    if (security === undefined || security === null) {
-        // Check privacy flag
-        if (entry.privacy !== undefined && entry.privacy !== null) {
-            security = asBoolean(entry.privacy);
-        }
-        // Fallback: derive from profile information
-        else if (entry.profile) {
-            security = interpretSecurityFromProfile(entry.profile);
-        }
-    }
-
-    const profileObj = entry.profile ?? null;
-    const profileName = entry.profileName ?? (profileObj && profileObj.name) ?? '';
-
-    return {
-        ssid: entry.ssid,
-        mac: macAddress,
-        signal: Number.isFinite(signal) ? signal : 0,
-        frequency: entry.frequency ?? entry.freq ?? null,
-        security: security,
-        known: !!entry.known,
-        profile: profileObj,
-        profileName,
-        band,
-        lastUpdated: Date.now()
-    };
-}
+        source.addEventListener('status', (event) => {
+            const status = Events.parse(event);
+            if (status) {
+                state.statusVersion = null;
+                renderStatus(status);
+            }
+        });
+        source.addEventListener('scan', (event) => {
+            const progress = Events.parse(event);
+            if (progress && progress.status !== 'pending') {
+                this.releaseScanWaiters(progress);
+            }
+        });
+        source.addEventListener('scan-result', (event) => {
+            const result = Events.parse(event);
+            if (!result) return;
+            if (this.scanWaiters.size > 0) {
+                this.releaseScanWaiters(result);
+            } else if (scanView && result.band && state.networks[result.band]) {
+                // Background scan: nobody waits, just refresh that band
+                scanView.onScanResult(result);
+            }
+        });
+    },
 
-function mergeNetworkResults(existing, incoming, band) {
-    const merged = new Map();
-    existing.forEach(item => {
-        merged.set(getNetworkKey(item), { ...item });
-    });
-    incoming.forEach(item => {
-        if (!item) {
-            return;
-        }
-        const normalized = normalizeNetworkEntry(item, band);
-        if (!normalized) {
-            return;
-        }
-        const key = getNetworkKey(normalized);
-        if (merged.has(key)) {
-            merged.set(key, { ...merged.get(key), ...normalized });
-        } else {
-            merged.set(key, normalized);
+    parse(event) {
+        try {
+            return JSON.parse(event.data);
+        } catch (error) {
+            console.error('Invalid event payload:', error);
+            return null;
         }
-    });
-    return Array.from(merged.values()).sort((a, b) => {
-        const isKnownA = a.known ? 1 : 0;
-        const isKnownB = b.known ? 1 : 0;
+    },
 
-        if (isKnownA !== isKnownB) {
-            return isKnownB - isKnownA; // known first
-        }
-        return (b.signal ?? 0) - (a.signal ?? 0);
-    });
-}
+    // Resolves with the next pushed scan result or failure, or null on timeout / stream loss
+    waitForScan(timeoutMs) {
+        return new Promise(resolve => {
+            const waiter = { resolve, timer: null };
+            waiter.timer = setTimeout(() => {
+                this.scanWaiters.delete(waiter);
+                resolve(null);
+            }, Math.max(0, timeoutMs));
+            this.scanWaiters.add(waiter);
+        });
+    },
 
-let toastTimer = null;
-let toastHideTimer = null;
+    releaseScanWaiters(data) {
+        this.scanWaiters.forEach(waiter => {
+            clearTimeout(waiter.timer);
+            waiter.resolve(data);
+        });
+        this.scanWaiters.clear();
+    }
+};
 
 function formatSignal(signal) {
     if (!signal) {
@@ -556,728 +376,55 @@ function applyStatusPanel(status, elements, options) {
     disconnectBtn.style.display = showDisconnect ? 'block' : 'none';
 }
 
-function setBandSelection(band, { triggerScan = false } = {}) {
-    if (!band) {
-        return;
-    }
-
-    const changed = state.currentBand !== band;
-    state.currentBand = band;
-    let matched = false;
-    const buttons = document.querySelectorAll('.band-btn');
-
-    buttons.forEach(btn => {
-        const isActive = btn.dataset.band === band;
-        btn.classList.toggle('active', isActive);
-        if (isActive) {
-            matched = true;
-        }
-    });
-
-    if (!matched) {
-        buttons.forEach(btn => btn.classList.remove('active'));
-    }
-    renderNetworkList();
-
-    if (triggerScan && (changed || !getNetworksForCurrentBand().length)) {
-        if (changed) {
-            disableAutoScan();
-            enableAutoScan(true);  // Restart auto-scan (skip immediate scan)
-        }
-        scan(false);
-    }
-}
-
-function showNotification(message, type = 'info', duration = 4000) {
-    const toast = document.getElementById('toast-container');
-    if (!toast) {
-        return;
-    }
-
-    if (toastTimer) {
-        clearTimeout(toastTimer);
-        toastTimer = null;
-    }
-    if (toastHideTimer) {
-        clearTimeout(toastHideTimer);
-        toastHideTimer = null;
-    }
-
-    toast.classList.remove('hidden', 'toast-info', 'toast-success', 'toast-error', 'visible');
-    void toast.offsetWidth;
-    toast.textContent = typeof message === 'string' ? message : String(message);
-    toast.classList.add(`toast-${type}`);
-    toast.classList.add('visible');
-
-    toastTimer = setTimeout(() => {
-        toast.classList.remove('visible');
-        toastHideTimer = setTimeout(() => {
-            toast.classList.add('hidden');
-        }, 250);
-    }, duration);
-}
-
 async function updateStatus() {
     try {
-        const rawData = await API.get('/api/status');
-
-        // Parse status data similar to the legacy Python version
-        const status = parseStatusData(rawData);
-
-        const statusDiv = document.getElementById('connection-status');
-        const statusText = document.getElementById('status-text');
-        const detailsDiv = document.getElementById('connection-details');
-        const disconnectBtn = document.getElementById('disconnect-btn');
-        const panelElements = { statusDiv, statusText, detailsDiv, disconnectBtn };
-
-        state.isConnected = !!status.connected;
-        state.isConnecting = !!status.connecting;
-
-        if (state.isConnected || state.isConnecting) {
-            disableAutoScan();
-        } else if (state.allowAutoScan) {
-            enableAutoScan();
-        }
-
-        if (status.band) {
-            setBandSelection(status.band, { triggerScan: false });
-        }
-
-        if (status.connected) {
-            applyStatusPanel(status, panelElements, {
-                cssClass: 'status-connected',
-                message: t('status.text.connected'),
-                includeNetworkInfo: true,
-                showDisconnect: true
-            });
-        } else if (status.connecting) {
-            applyStatusPanel(status, panelElements, {
-                cssClass: 'status-connecting',
-                message: t('status.text.connecting'),
-                showDisconnect: true
-            });
-        } else {
-            applyStatusPanel(status, panelElements, {
-                cssClass: 'status-disconnected',
-                message: t('status.text.disconnected'),
-                showDetails: false
-            });
-        }
+        // Backend returns a pre-digested status object, or {"unchanged":true}
+        // when it still matches the version we rendered last
+        const query = state.statusVersion ? '?since=' + encodeURIComponent(state.statusVersion) : '';
+        const response = await fetch(apiPath('/api/status' + query));
+        const status = await response.json() || {};
+        if (status.unchanged) return;
+        state.statusVersion = response.headers.get('X-Status-Version');
+        renderStatus(status);
     } catch(error) {
         console.error('Status update failed:', error);
     }
 }
 
-function parseStatusData(rawData) {
-    // Parse raw MikroTik data inside the frontend (mirrors Python version)
-    const result = { connected: false };
-
-    if (!rawData.interfaces || !rawData.registration) {
-        return result;
-    }
-
-    const interfaces = Array.isArray(rawData.interfaces) ? rawData.interfaces : [];
-    const registrations = Array.isArray(rawData.registration) ? rawData.registration : [];
-    const addresses = Array.isArray(rawData.addresses) ? rawData.addresses : [];
-    const routes = Array.isArray(rawData.routes) ? rawData.routes : [];
-    const dnsInfo = rawData.dns || {};
-
-    // Index wireless interfaces
-    const wlanInterfaces = {};
-    interfaces.forEach(iface => {
-        const name = iface.name || '';
-        if (name.toLowerCase().includes('wlan')) {
-            wlanInterfaces[name] = iface;
-        }
-    });
-
-    // Registration table is the most reliable indicator of active links
-    let activeEntry = null;
-    for (const entry of registrations) {
-        const ifaceName = entry.interface || '';
-        if (wlanInterfaces[ifaceName]) {
-            activeEntry = entry;
-            break;
-        }
-    }
-
-    if (activeEntry) {
-        // Active connection found via registration table
-        const ifaceName = activeEntry.interface || '';
-        const iface = wlanInterfaces[ifaceName] || {};
-        const ssid = iface.ssid || activeEntry.ssid || activeEntry['radio-name'] || '';
-
-        result.connected = true;
-        result.interface = ifaceName;
-        result.ssid = ssid;
-        result.running = true;
-        result.signal = activeEntry['signal-strength'];
-        result.snr = activeEntry['signal-to-noise'];
-
-        if (iface.band) {
-            result.band = iface.band;
-        }
-    } else {
-        // Fallback: inspect interface flags
-        for (const [name, iface] of Object.entries(wlanInterfaces)) {
-            const disabled = asBoolean(iface.disabled);
-            const running = asBoolean(iface.running);
-            const ssid = iface.ssid || '';
+function renderStatus(status) {
+    const statusDiv = document.getElementById('connection-status');
+    const statusText = document.getElementById('status-text');
+    const detailsDiv = document.getElementById('connection-details');
+    const disconnectBtn = document.getElementById('disconnect-btn');
+    const panelElements = { statusDiv, statusText, detailsDiv, disconnectBtn };
 
-            if (disabled) {
-                // Even if interface is disabled, capture the band for UI accuracy
-                if (iface.band && !result.band) {
-                    result.band = iface.band;
-                }
-                continue;
-            }
+    state.isConnected = !!status.connected;
+    state.isConnecting = !!status.connecting;
+    state.lastStatus = status;
 
-            if (running) {
-                result.connected = true;
-                result.interface = name;
-                result.ssid = ssid;
-                result.running = running;
-                if (iface.band) result.band = iface.band;
-                if (iface['signal-strength']) result.signal = iface['signal-strength'];
-                break;
-            } else if (ssid) {
-                result.connecting = true;
-                result.interface = name;
-                result.ssid = ssid;
-                result.running = running;
-                if (iface.band) result.band = iface.band;
-                break;
-            }
-        }
+    if (scanView) {
+        scanView.onStatus(status);
     }
 
-    // Enrich with network information
-    if (result.connected && result.interface) {
-        const ifaceName = result.interface;
-
-        // IP address
-        let selectedAddr = null;
-        for (const addr of addresses) {
-            if (addr.interface === ifaceName || addr['actual-interface'] === ifaceName) {
-                selectedAddr = addr;
-                // Prefer dynamic (DHCP) entries
-                if (asBoolean(addr.dynamic)) {
-                    break;
-                }
-            }
-        }
-
-        if (selectedAddr) {
-            const address = selectedAddr.address || '';
-            if (address.includes('/')) {
-                const [ip, prefix] = address.split('/', 2);
-                result.ip = ip;
-                result.prefix = prefix;
-            }
-            if (selectedAddr.network) {
-                result.network = selectedAddr.network;
-            }
-        }
-
-        // Gateway
-        for (const route of routes) {
-            if (route['dst-address'] !== '0.0.0.0/0') continue;
-            if (!asBoolean(route.active)) continue;
-
-            const immediateGw = route['immediate-gw'] || '';
-            const gateway = route.gateway || '';
-
-            if (immediateGw.includes(`%${ifaceName}`) || gateway === ifaceName) {
-                result.gateway = gateway;
-                break;
-            }
-        }
-
-        // DNS servers
-        const dnsServers = [];
-        const servers = dnsInfo.servers || '';
-        const dynamicServers = dnsInfo['dynamic-servers'] || '';
-
-        if (servers) {
-            servers.split(',').forEach(dns => {
-                dns = dns.trim();
-                if (dns) dnsServers.push(dns);
-            });
-        }
-
-        if (dnsServers.length > 0) {
-            result.dns = dnsServers;
-        }
-    }
-
-    return result;
-}
-
-function getFilteredNetworks() {
-    const networks = getNetworksForCurrentBand();
-    if (!Array.isArray(networks)) {
-        return [];
-    }
-    return networks.filter(network => {
-        if (state.filter === 'secured') {
-            return network.security === true;
-        }
-        if (state.filter === 'open') {
-            return network.security === false;
-        }
-        return true;
-    });
-}
-
-function renderNetworkList() {
-    const list = document.getElementById('networks-list');
-    if (!list) return;
-
-    const filtered = getFilteredNetworks();
-    const allNetworks = getNetworksForCurrentBand();
-
-    if (!allNetworks.length) {
-        list.innerHTML = '<p style="text-align: center; color: #6c757d; padding: 24px;">Keine Netzwerke gefunden</p>';
-        hideConnectSection();
-        return;
-    }
-
-    if (!filtered.length) {
-        list.innerHTML = '<p style="text-align: center; color: #6c757d; padding: 24px;">Keine Netzwerke für diesen Filter</p>';
-        hideConnectSection();
-        return;
-    }
-
-    list.innerHTML = filtered.map(network => {
-        const signalPercent = signalToPercent(network.signal);
-        const securityState = network.security;
-        const requiresPassword = securityState !== false;
-        let icon = '';
-        if (securityState === true) {
-            icon = '🔒 ';
-        } else if (securityState === false) {
-            icon = '📡 ';
-        }
-        const badge = network.known ? `<span class="network-badge">${t('badge.known')}</span>` : '';
-        const key = getNetworkKey(network);
-        return `
-            <div class="network-item" data-ssid="${network.ssid}" data-mac="${network.mac || ''}" data-key="${key}" data-requires-password="${requiresPassword}">
-                <div class="network-header">
-                    <div class="network-ssid">${icon}${network.ssid}${badge}</div>
-                    <div>${network.signal} dBm</div>
-                </div>
-                <div class="network-details">
-                    <div class="network-meta">MAC: ${network.mac || 'N/A'}</div>
-                </div>
-                <div class="signal-bar">
-                    <div class="signal-fill" style="width: ${signalPercent}%; background: ${signalColor(signalPercent)};"></div>
-                </div>
-            </div>
-        `;
-    }).join('');
-
-    list.querySelectorAll('.network-item').forEach((item, index) => {
-        const network = filtered[index];
-        const securityState = network.security;
-        const requiresPassword = securityState !== false;
-        item.onclick = () => {
-            list.querySelectorAll('.network-item').forEach(i => i.classList.remove('selected'));
-            item.classList.add('selected');
-            const key = item.dataset.key;
-            state.selectedNetwork = {
-                ssid: network.ssid,
-                requiresPassword,
-                mac: network.mac || '',
-                securityState,
-                known: !!network.known,
-                profile: network.profile || null,
-                profileName: network.profileName || (network.profile && network.profile.name) || '',
-                band: state.currentBand,
-                key
-            };
-            showConnectSection();
-        };
-    });
-
-    if (state.selectedNetwork) {
-        const selectedElement = state.selectedNetwork.key
-            ? list.querySelector(`.network-item[data-key="${state.selectedNetwork.key}"]`)
-            : list.querySelector(`.network-item[data-ssid="${state.selectedNetwork.ssid}"]`);
-        if (selectedElement) {
-            selectedElement.classList.add('selected');
-        } else {
-            hideConnectSection();
-        }
-    }
-}
-
-async function scan(auto = false, retryCount = 0) {
-    if (state.isScanning) return;
-    state.isScanning = true;
-    const requestedBand = state.currentBand;
-
-    if (!auto) {
-        document.getElementById('scan-status').style.display = 'block';
-        const scanStatusText = document.querySelector('#scan-status [data-i18n="scan.status.searching"]');
-        if (scanStatusText) {
-            scanStatusText.textContent = t('scan.status.searching');
-        }
-        document.getElementById('scan-btn').disabled = true;
-        state.selectedNetwork = null;
-        hideConnectSection();
-    }
-
-    try {
-        // Step 1: start the scan (non-blocking)
-        const startResponse = await API.post('/api/scan/start?band=' + encodeURIComponent(requestedBand), {});
-
-        if (startResponse.error) {
-            console.error('Scan start error:', startResponse.error);
-            showNotification(t('notification.scan.failedReason', { error: startResponse.error }), 'error');
-            return;
-        }
-
-        const pollInterval = startResponse?.poll_interval_ms
-            ?? state.config?.scan_poll_interval_ms
-            ?? 500;
-        const durationMs = startResponse?.duration_ms
-            ?? state.config?.scan_duration_ms
-            ?? 5000;
-        const minReadyMs = startResponse?.min_ready_ms
-            ?? state.config?.scan_min_ready_ms
-            ?? durationMs;
-        const timeoutMs = startResponse?.timeout_ms
-            ?? state.config?.scan_timeout_ms
-            ?? (minReadyMs + (state.config?.scan_result_grace_ms ?? 2000));
-
-        let response = null;
-        // If scan is already running, adjust scanStart to match backend timing
-        const elapsedMs = startResponse?.elapsed_ms ?? 0;
-
-        // If the existing scan has already expired, retry with a new scan
-        if (startResponse.status === 'already_scanning' && elapsedMs >= timeoutMs) {
-            if (retryCount >= 2) {
-                console.error('Max retry attempts reached for expired scan');
-                showNotification(t('notification.scan.failedReason', { error: 'Max retries exceeded' }), 'error');
-                return;
-            }
-            console.log('Existing scan expired, retrying... (attempt ' + (retryCount + 1) + ')');
-            // Reset state and wait a moment for backend cleanup, then retry
-            state.isScanning = false;
-            await new Promise(resolve => setTimeout(resolve, 500));
-            return scan(auto, retryCount + 1);
-        }
-
-        const scanStart = Date.now() - elapsedMs;
-
-        while (true) {
-            const elapsed = Date.now() - scanStart;
-
-            if (elapsed >= timeoutMs) {
-                break;
-            }
-
-            if (elapsed < minReadyMs) {
-                const waitMs = Math.min(pollInterval, Math.max(0, minReadyMs - elapsed));
-                if (waitMs > 0) {
-                    await new Promise(resolve => setTimeout(resolve, waitMs));
-                }
-                continue;
-            }
-
-            const pollResponse = await API.get('/api/scan/result');
-
-            if (!pollResponse || pollResponse.status === 'pending') {
-                await new Promise(resolve => setTimeout(resolve, pollInterval));
-                continue;
-            }
-
-            response = pollResponse;
-            break;
-        }
-
-        if (!response) {
-            showNotification(t('notification.scan.timeout'), 'error');
-            return;
-        }
-
-        if (response.error) {
-            console.error('Scan error:', response.error);
-            showNotification(t('notification.scan.failedReason', { error: response.error }), 'error');
-            return;
-        }
-
-        const existing = getNetworksForBand(requestedBand);
-        let updates = [];
-
-        // Check if response contains CSV data (new format)
-        if (response.csv) {
-            // Parse CSV in frontend
-            updates = parseCSV(response.csv);
-
-            // Add known status from profiles array
-            const profileMap = {};
-            if (response.profiles && Array.isArray(response.profiles)) {
-                console.log('Received profiles from backend:', response.profiles);
-                response.profiles.forEach(p => {
-                    if (p.ssid) {
-                        profileMap[p.ssid] = p;
-                        console.log(`  Profile: "${p.ssid}" (mode=${p.mode})`);
-                    }
-                });
-            }
-
-            // Enrich network entries with known status and profile info
-            updates.forEach(network => {
-                const matched = profileMap[network.ssid];
-                if (matched) {
-                    network.known = true;
-                    network.profile = matched;
-                    network.profileName = matched.name || '';
-                    console.log(`  ✓ Matched network "${network.ssid}" with profile`);
-                } else {
-                    network.known = false;
-                    network.profile = null;
-                    network.profileName = '';
-                    console.log(`  ✗ No profile found for "${network.ssid}"`);
-                }
-            });
-        } else if (Array.isArray(response)) {
-            // Fallback: REST API format (old format)
-            updates = response;
-        }
-
-        const merged = mergeNetworkResults(existing, updates, requestedBand);
-        state.networks[requestedBand] = merged;
-
-        if (state.selectedNetwork && state.selectedNetwork.band === requestedBand) {
-            const selectedKey = getNetworkKey(state.selectedNetwork);
-            const refreshed = merged.find(net => getNetworkKey(net) === selectedKey);
-            if (refreshed) {
-                const refreshedKey = getNetworkKey(refreshed);
-                state.selectedNetwork = {
-                    ...state.selectedNetwork,
-                    known: !!refreshed.known,
-                    securityState: refreshed.security,
-                    requiresPassword: refreshed.security !== false,
-                    mac: refreshed.mac || state.selectedNetwork.mac,
-                    profile: refreshed.profile || null,
-                    profileName: refreshed.profileName || (refreshed.profile && refreshed.profile.name) || state.selectedNetwork.profileName || '',
-                    key: refreshedKey,
-                    band: requestedBand
-                };
-                updatePasswordUI();
-            }
-        }
-
-        if (requestedBand === state.currentBand) {
-            renderNetworkList();
-        }
-    } catch (error) {
-        const message = error && error.message ? error.message : error;
-        showNotification(t('notification.scan.failedReason', { error: message }), 'error');
-    } finally {
-        if (!auto) {
-            document.getElementById('scan-status').style.display = 'none';
-            document.getElementById('scan-btn').disabled = false;
-        }
-        state.isScanning = false;
-        if (!auto && state.allowAutoScan && !state.isConnected) {
-            enableAutoScan(true);
-        }
-    }
-}
-
-function updatePasswordUI() {
-    const passwordField = document.getElementById('password-field');
-    const passwordInput = document.getElementById('password-input');
-    if (!passwordField || !passwordInput) return;
-
-    if (!state.selectedNetwork) {
-        passwordField.style.display = 'none';
-        passwordInput.placeholder = t('input.password.placeholder.required');
-        passwordInput.value = '';
-        return;
-    }
-
-    const requiresPassword = state.selectedNetwork.requiresPassword !== false;
-    const known = !!state.selectedNetwork.known;
-    passwordField.style.display = requiresPassword ? 'block' : 'none';
-
-    if (requiresPassword && known) {
-        // Saved encrypted network: password optional (can update stored value)
-        passwordInput.placeholder = t('input.password.placeholder.optional');
-    } else if (requiresPassword) {
-        // New encrypted network: password required
-        passwordInput.placeholder = t('input.password.placeholder.required');
-    } else {
-        passwordInput.placeholder = t('input.password.placeholder.none');
-    }
-}
-
-function showConnectSection() {
-    const section = document.getElementById('connect-section');
-    const forgetBtn = document.getElementById('forget-btn');
-    const specificApField = document.getElementById('specific-ap-field');
-    const apMacAddress = document.getElementById('ap-mac-address');
-    const connectToSpecificApCheckbox = document.getElementById('connect-to-specific-ap');
-
-    document.getElementById('selected-ssid').textContent = state.selectedNetwork.ssid;
-    document.getElementById('password-input').value = '';
-    updatePasswordUI();
-
-    // Show/hide specific AP option
-    if (specificApField && apMacAddress && connectToSpecificApCheckbox) {
-        if (state.selectedNetwork.mac) {
-            specificApField.style.display = 'block';
-            apMacAddress.textContent = 'MAC: ' + state.selectedNetwork.mac;
-            connectToSpecificApCheckbox.checked = false;
-            apMacAddress.style.display = 'none';
-
-            // Toggle MAC address visibility when checkbox changes
-            connectToSpecificApCheckbox.onchange = () => {
-                apMacAddress.style.display = connectToSpecificApCheckbox.checked ? 'block' : 'none';
-            };
-        } else {
-            specificApField.style.display = 'none';
-        }
-    }
-
-    if (forgetBtn) {
-        forgetBtn.style.display = state.selectedNetwork.known ? 'inline-block' : 'none';
-        forgetBtn.disabled = !state.selectedNetwork.known;
-    }
-
-    section.style.display = 'block';
-    section.scrollIntoView({ behavior: 'smooth', block: 'nearest' });
-}
-
-function hideConnectSection() {
-    const section = document.getElementById('connect-section');
-    section.style.display = 'none';
-    const forgetBtn = document.getElementById('forget-btn');
-    if (forgetBtn) {
-        forgetBtn.style.display = 'none';
-        forgetBtn.disabled = true;
-    }
-    const list = document.getElementById('networks-list');
-    if (list) {
-        list.querySelectorAll('.network-item').forEach(i => i.classList.remove('selected'));
-    }
-    state.selectedNetwork = null;
-    updatePasswordUI();
-}
-
-async function connect() {
-    if (!state.selectedNetwork) return;
-
-    const password = document.getElementById('password-input').value;
-    const requiresPassword = state.selectedNetwork.requiresPassword !== false;
-    const known = !!state.selectedNetwork.known;
-
-    // Password validation:
-    // - Encrypted networks: password required when not already saved
-    // - Saved encrypted networks: password optional (uses stored credential)
-    // - Open networks: no password needed
-    if (requiresPassword && !password && !known) {
-        showNotification(t('notification.password.required'), 'error');
-        return;
-    }
-
-    disableAutoScan();
-    document.getElementById('connect-btn').disabled = true;
-
-    try {
-        // Generate profile name on the frontend
-        const profileName = await generateProfileName(state.selectedNetwork.ssid);
-
-        const connectToSpecificApCheckbox = document.getElementById('connect-to-specific-ap');
-        const connectToSpecificAp = connectToSpecificApCheckbox?.checked || false;
-        const apMacAddress = connectToSpecificAp ? (state.selectedNetwork.mac || '') : '';
-
-        const response = await API.post('/api/connect', {
-            ssid: state.selectedNetwork.ssid,
-            password: password,
-            band: state.currentBand,
-            known,
-            requiresPassword,
-            profileName: profileName,
-            connectToSpecificAp: connectToSpecificAp,
-            apMacAddress: apMacAddress
+    if (status.connected) {
+        applyStatusPanel(status, panelElements, {
+            cssClass: 'status-connected',
+            message: t('status.text.connected'),
+            includeNetworkInfo: true,
+            showDisconnect: true
         });
-
-        if (response && response.error) {
-            throw new Error(response.error);
-        }
-
-        showNotification(t('notification.connect.start', { ssid: state.selectedNetwork.ssid }), 'success');
-        hideConnectSection();
-
-        // Refresh status after 3 seconds
-        setTimeout(updateStatus, 3000);
-    } catch(error) {
-        const message = error && error.message ? error.message : error;
-        showNotification(t('notification.connect.failed', { error: message }), 'error');
-    } finally {
-        document.getElementById('connect-btn').disabled = false;
-    }
-}
-
-async function forgetSelectedNetwork() {
-    if (!state.selectedNetwork || !state.selectedNetwork.known) return;
-
-    const payload = {
-        ssid: state.selectedNetwork.ssid
-    };
-    if (state.selectedNetwork.profileName) {
-        payload.profileName = state.selectedNetwork.profileName;
-    }
-
-    try {
-        const response = await API.post('/api/profile/delete', payload);
-        if (response && response.error) {
-            throw new Error(response.error);
-        }
-
-        const targetKey = state.selectedNetwork.key;
-        const targetBand = state.selectedNetwork.band;
-
-        Object.entries(state.networks).forEach(([bandKey, list]) => {
-            const updated = list.map(item => {
-                if (getNetworkKey(item) === targetKey) {
-                    return {
-                        ...item,
-                        known: false,
-                        profile: null,
-                        profileName: ''
-                    };
-                }
-                return item;
-            });
-            state.networks[bandKey] = bandKey === targetBand
-                ? mergeNetworkResults(updated, [], bandKey)
-                : updated;
+    } else if (status.connecting) {
+        applyStatusPanel(status, panelElements, {
+            cssClass: 'status-connecting',
+            message: t('status.text.connecting'),
+            showDisconnect: true
+        });
+    } else {
+        applyStatusPanel(status, panelElements, {
+            cssClass: 'status-disconnected',
+            message: t('status.text.disconnected'),
+            showDetails: false
         });
-
-        const forgetBtn = document.getElementById('forget-btn');
-        if (forgetBtn) {
-            forgetBtn.style.display = 'none';
-            forgetBtn.disabled = true;
-        }
-
-        const ssid = state.selectedNetwork.ssid;
-        state.selectedNetwork.known = false;
-        state.selectedNetwork.profile = null;
-        state.selectedNetwork.profileName = '';
-        state.selectedNetwork.requiresPassword = state.selectedNetwork.securityState !== false;
-
-        updatePasswordUI();
-        renderNetworkList();
-
-        showNotification(t('notification.profile.deleted', { ssid }), 'success');
-    } catch (error) {
-        const message = error && error.message ? error.message : error;
-        showNotification(t('notification.profile.deleteFailed', { error: message }), 'error');
     }
 }
 
@@ -1297,6 +444,29 @@ async function disconnect() {
     }
 }
 
+// Only shown when more than one router/interface is configured
+function renderTargetSelector(config) {
+    const container = document.getElementById('target-selector');
+    const select = document.getElementById('target-select');
+    const targets = Array.isArray(config.targets) ? config.targets : [];
+    if (!container || !select || targets.length < 2) return;
+
+    select.innerHTML = '';
+    targets.forEach(target => {
+        const option = document.createElement('option');
+        option.value = target.name;
+        option.textContent = target.name + ' (' + target.wlan_interface + ')';
+        option.selected = target.name === config.target;
+        select.appendChild(option);
+    });
+    select.onchange = () => {
+        const params = new URLSearchParams(window.location.search);
+        params.set('target', select.value);
+        window.location.search = params.toString();
+    };
+    container.style.display = '';
+}
+
 async function loadConfig() {
     try {
         const config = await API.get('/api/config');
@@ -1319,8 +489,7 @@ async function loadConfig() {
         // Set default band
         state.currentBand = config.band_2ghz;
 
-        // Build band buttons dynamically
-        createBandButtons(config);
+        renderTargetSelector(config);
 
         return config;
     } catch(error) {
@@ -1339,92 +508,42 @@ async function loadConfig() {
         };
         state.networks = { '2ghz-b/g/n': [], '5ghz-a/n': [] };
         state.currentBand = '2ghz-b/g/n';
-        createBandButtons(state.config);
         return state.config;
     }
 }
 
-function createBandButtons(config) {
-    const container = document.getElementById('band-selector');
-    container.innerHTML = '';
-
-    // Extract mode suffix (e.g., "g/n" from "2ghz-g/n")
-    const extractMode = (band) => {
-        const parts = band.split('-');
-        return parts.length > 1 ? parts.slice(1).join('-') : '';
-    };
-
-    // 2.4 GHz button
-    const btn2ghz = document.createElement('button');
-    btn2ghz.className = 'band-btn active';
-    btn2ghz.dataset.band = config.band_2ghz;
-    btn2ghz.innerHTML = `
-        <span class="band-freq">2.4 GHz</span>
-        <span class="band-mode">${extractMode(config.band_2ghz)}</span>
-    `;
-    btn2ghz.onclick = () => setBandSelection(config.band_2ghz, { triggerScan: true });
-    container.appendChild(btn2ghz);
-
-    // 5 GHz button
-    const btn5ghz = document.createElement('button');
-    btn5ghz.className = 'band-btn';
-    btn5ghz.dataset.band = config.band_5ghz;
-    btn5ghz.innerHTML = `
-        <span class="band-freq">5 GHz</span>
-        <span class="band-mode">${extractMode(config.band_5ghz)}</span>
-    `;
-    btn5ghz.onclick = () => setBandSelection(config.band_5ghz, { triggerScan: true });
-    container.appendChild(btn5ghz);
+// Resolves once the script has run; the page keeps working without it
+function loadScript(src) {
+    return new Promise((resolve, reject) => {
+        const script = document.createElement('script');
+        script.src = src;
+        script.onload = resolve;
+        script.onerror = () => reject(new Error('Failed to load ' + src));
+        document.head.appendChild(script);
+    });
 }
 
 // Event listener setup
 document.addEventListener('DOMContentLoaded', async () => {
-    await initTranslations();
+    await initTranslations(DEFAULT_TRANSLATIONS);
     applyTranslationsToDOM();
 
-    // Load config and initialize band buttons
-    await loadConfig();
-
-    // Wire up buttons
-    document.getElementById('scan-btn').onclick = () => scan(false);
-    const autoScanToggle = document.getElementById('auto-scan-toggle');
-    if (autoScanToggle) {
-        autoScanToggle.addEventListener('change', () => {
-            state.allowAutoScan = autoScanToggle.checked;
-            if (state.allowAutoScan) {
-                if (!state.isConnected) enableAutoScan(true);
-            } else {
-                disableAutoScan();
-            }
-        });
-    }
     document.getElementById('disconnect-btn').onclick = disconnect;
-    document.getElementById('connect-btn').onclick = connect;
-    document.getElementById('cancel-btn').onclick = hideConnectSection;
-    document.getElementById('forget-btn').onclick = forgetSelectedNetwork;
-
-    document.querySelectorAll('.filter-btn').forEach(btn => {
-        btn.onclick = () => {
-            state.filter = btn.dataset.filter;
-            document.querySelectorAll('.filter-btn').forEach(b => b.classList.toggle('active', b === btn));
-            btn.blur();
-            renderNetworkList();
-        };
-    });
-
-    // Allow Enter key in password field
-    document.getElementById('password-input').addEventListener('keypress', (e) => {
-        if (e.key === 'Enter') {
-            connect();
-        }
-    });
 
-    setBandSelection(state.currentBand, { triggerScan: false });
-    updatePasswordUI();
+    // Config first: it selects the target and bands the status belongs to
+    await loadConfig();
 
     // Initial status fetch
     updateStatus();
 
-    // Auto-refresh status every 5 seconds
-    setInterval(updateStatus, 5000);
+    // Status is pushed over the event stream; poll every 5 seconds while it is down
+    Events.start();
+    setInterval(() => {
+        if (!Events.connected) updateStatus();
+    }, STATUS_POLL_INTERVAL);
+
+    // Scan and connect UI on demand, after the status is underway
+    loadScript(SCAN_MODULE_SRC).catch(error => {
+        console.error('Scan module unavailable:', error);
+    });
 });
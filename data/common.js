@@ -0,0 +1,116 @@
+/**
+ * MikroTik WiFi Manager - helpers shared by the dashboard and the settings page
+ */
+
+const SUPPORTED_LANGUAGES = ['en', 'de'];
+
+let defaultTranslations = {};
+let translations = {};
+let currentLanguage = 'en';
+
+function t(key, params = {}) {
+    const template = translations[key] ?? defaultTranslations[key] ?? key;
+    return template.replace(/\{(\w+)\}/g, (_, prop) => {
+        return params[prop] !== undefined ? params[prop] : `{${prop}}`;
+    });
+}
+
+async function loadTranslations(language) {
+    if (!SUPPORTED_LANGUAGES.includes(language)) {
+        return false;
+    }
+
+    try {
+        const response = await fetch(`/i18n/${language}.json`, { cache: 'no-cache' });
+        if (!response.ok) {
+            return false;
+        }
+        const data = await response.json();
+        translations = { ...defaultTranslations, ...data };
+        currentLanguage = language;
+        return true;
+    } catch (error) {
+        console.warn('Failed to load translations for', language, error);
+        return false;
+    }
+}
+
+// Built pages carry the strings of the language the server picked from
+// Accept-Language (window.INLINE_TRANSLATIONS); unbuilt ones fetch them
+async function initTranslations(defaults) {
+    defaultTranslations = defaults;
+    translations = { ...defaults };
+
+    const inline = window.INLINE_TRANSLATIONS;
+    if (inline && inline.strings) {
+        translations = { ...defaults, ...inline.strings };
+        currentLanguage = inline.lang || currentLanguage;
+        document.documentElement.lang = currentLanguage;
+        return;
+    }
+
+    const fallback = 'en';
+    const browserLang = (navigator.language || fallback).split('-')[0].toLowerCase();
+    const candidates = [];
+    if (SUPPORTED_LANGUAGES.includes(browserLang)) {
+        candidates.push(browserLang);
+    }
+    if (!candidates.includes(fallback)) {
+        candidates.push(fallback);
+    }
+
+    for (const lang of candidates) {
+        const loaded = await loadTranslations(lang);
+        if (loaded) {
+            break;
+        }
+    }
+
+    document.documentElement.lang = currentLanguage;
+}
+
+function applyTranslationsToDOM() {
+    document.querySelectorAll('[data-i18n]').forEach((el) => {
+        el.textContent = t(el.dataset.i18n);
+    });
+
+    document.querySelectorAll('[data-i18n-placeholder]').forEach((el) => {
+        el.setAttribute('placeholder', t(el.dataset.i18nPlaceholder));
+    });
+
+    document.querySelectorAll('[data-i18n-aria-label]').forEach((el) => {
+        el.setAttribute('aria-label', t(el.dataset.i18nAriaLabel));
+    });
+}
+
+let toastTimer = null;
+let toastHideTimer = null;
+
+function showNotification(message, type = 'info', duration = 4000) {
+    const toast = document.getElementById('toast-container');
+    if (!toast) {
+        return;
+    }
+
+    if (toastTimer) {
+        clearTimeout(toastTimer);
+        toastTimer = null;
+    }
+    if (toastHideTimer) {
+        clearTimeout(toastHideTimer);
+        toastHideTimer = null;
+    }
+
+    toast.classList.remove('hidden', 'toast-info', 'toast-success', 'toast-error', 'visible');
+    void toast.offsetWidth;
+    toast.textContent = typeof message === 'string' ? message : String(message);
+    toast.classList.add(`toast-${type}`);
+    toast.classList.add('visible');
+
+    toastTimer = setTimeout(() => {
+        toast.classList.remove('visible');
+        toastHideTimer = setTimeout(() => {
+            toast.classList.add('hidden');
+        }, 250);
+    }, duration);
+}
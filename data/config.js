@@ -18,8 +18,6 @@ const API = {
     }
 };
 
-const SUPPORTED_LANGUAGES = ['en', 'de'];
-
 const DEFAULT_TRANSLATIONS = {
     "status.title": "Connection Status",
     "status.text.connected": "Connected",
@@ -43,9 +41,13 @@ const DEFAULT_TRANSLATIONS = {
     "config.label.mikrotikPassword": "MikroTik Password",
     "config.label.mikrotikToken": "MikroTik Token",
     "config.label.mikrotikInterface": "MikroTik WLAN Interface",
+    "config.label.mikrotikInterface2": "Second radio for dual-band scans (optional)",
     "config.label.band2": "2.4 GHz Band",
     "config.label.band5": "5 GHz Band",
     "config.label.scanDuration": "Scan duration (seconds)",
+    "config.label.scanMode": "Scan mode",
+    "config.option.scanModeFtp": "FTP file (shows encryption)",
+    "config.option.scanModeRest": "REST response (faster, no FTP)",
     "config.button.save": "Save Settings",
     "config.button.cancel": "Cancel",
     "config.status.captive": "Captive portal active. Connect to {ssid} (default IP 192.168.4.1).",
@@ -62,8 +64,6 @@ const DEFAULT_TRANSLATIONS = {
     "config.clear.mikrotikToken": "Clear stored MikroTik token"
 };
 
-let translations = { ...DEFAULT_TRANSLATIONS };
-let currentLanguage = 'en';
 let settingsSnapshot = null;
 const PRESET_BANDS = {
     band2: [
@@ -78,80 +78,6 @@ const PRESET_BANDS = {
     ]
 };
 
-function t(key, params = {}) {
-    const template = translations[key] ?? key;
-    return template.replace(/\{(\w+)\}/g, (_, prop) => {
-        return params[prop] !== undefined ? params[prop] : `{${prop}}`;
-    });
-}
-
-async function loadTranslations(language) {
-    if (!SUPPORTED_LANGUAGES.includes(language)) {
-        return false;
-    }
-    try {
-        const response = await fetch(`/i18n/${language}.json`, { cache: 'no-cache' });
-        if (!response.ok) return false;
-        const data = await response.json();
-        translations = { ...DEFAULT_TRANSLATIONS, ...data };
-        currentLanguage = language;
-        return true;
-    } catch (error) {
-        console.warn('Failed to load translations', error);
-        return false;
-    }
-}
-
-async function initTranslations() {
-    const fallback = 'en';
-    const browserLang = (navigator.language || fallback).split('-')[0].toLowerCase();
-    const candidates = SUPPORTED_LANGUAGES.includes(browserLang) ? [browserLang, fallback] : [fallback];
-    for (const lang of candidates) {
-        const loaded = await loadTranslations(lang);
-        if (loaded) break;
-    }
-    document.documentElement.lang = currentLanguage;
-}
-
-function applyTranslationsToDOM() {
-    document.querySelectorAll('[data-i18n]').forEach(el => {
-        el.textContent = t(el.dataset.i18n);
-    });
-    document.querySelectorAll('[data-i18n-placeholder]').forEach(el => {
-        el.setAttribute('placeholder', t(el.dataset.i18nPlaceholder));
-    });
-}
-
-let toastTimer = null;
-let toastHideTimer = null;
-
-function showToast(message, type = 'info', duration = 4000) {
-    const toast = document.getElementById('toast-container');
-    if (!toast) return;
-
-    if (toastTimer) {
-        clearTimeout(toastTimer);
-        toastTimer = null;
-    }
-    if (toastHideTimer) {
-        clearTimeout(toastHideTimer);
-        toastHideTimer = null;
-    }
-
-    toast.classList.remove('hidden', 'toast-info', 'toast-success', 'toast-error', 'visible');
-    void toast.offsetWidth;
-    toast.textContent = typeof message === 'string' ? message : String(message);
-    toast.classList.add(`toast-${type}`);
-    toast.classList.add('visible');
-
-    toastTimer = setTimeout(() => {
-        toast.classList.remove('visible');
-        toastHideTimer = setTimeout(() => {
-            toast.classList.add('hidden');
-        }, 250);
-    }, duration);
-}
-
 function setStatusMessage(data) {
     const statusEl = document.getElementById('status-message');
     if (!statusEl || !data || !data.status) return;
@@ -174,12 +100,14 @@ function fillForm(data) {
     const mikrotikPassword = document.getElementById('mikrotik-password');
     const mikrotikToken = document.getElementById('mikrotik-token');
     const mikrotikInterface = document.getElementById('mikrotik-interface');
+    const mikrotikInterface2 = document.getElementById('mikrotik-interface-2');
     const band2 = document.getElementById('band-2g');
     const band5 = document.getElementById('band-5g');
     const wifiClear = document.getElementById('wifi-clear-password');
     const mikrotikClearPass = document.getElementById('mikrotik-clear-password');
     const mikrotikClearToken = document.getElementById('mikrotik-clear-token');
     const scanDurationInput = document.getElementById('scan-duration');
+    const scanModeSelect = document.getElementById('scan-mode');
     const stationRoamingCheckbox = document.getElementById('station-roaming');
 
     const currentBand2 = data.bands?.band_2ghz || '';
@@ -220,10 +148,12 @@ function fillForm(data) {
     mikrotikPassword.value = '';
     mikrotikToken.value = '';
     mikrotikInterface.value = data.mikrotik?.wlan_interface || '';
+    if (mikrotikInterface2) mikrotikInterface2.value = data.mikrotik?.wlan_interface_2 || '';
     if (wifiClear) wifiClear.checked = false;
     if (mikrotikClearPass) mikrotikClearPass.checked = false;
     if (mikrotikClearToken) mikrotikClearToken.checked = false;
     if (scanDurationInput) scanDurationInput.value = currentScanDuration || '';
+    if (scanModeSelect) scanModeSelect.value = data.scan?.mode || 'ftp';
     if (stationRoamingCheckbox) stationRoamingCheckbox.checked = currentStationRoaming;
 
     setStatusMessage(data);
@@ -235,7 +165,7 @@ async function loadSettings() {
         fillForm(data);
     } catch (error) {
         console.error('Failed to load settings', error);
-        showToast(t('config.save.failed', { error: error.message || error }), 'error');
+        showNotification(t('config.save.failed', { error: error.message || error }), 'error');
     }
 }
 
@@ -270,6 +200,7 @@ function buildSettingsPayload() {
     const mikrotikPasswordInput = document.getElementById('mikrotik-password');
     const mikrotikTokenInput = document.getElementById('mikrotik-token');
     const mikrotikInterfaceInput = document.getElementById('mikrotik-interface');
+    const mikrotikInterface2Input = document.getElementById('mikrotik-interface-2');
     const mikrotikClearPass = document.getElementById('mikrotik-clear-password');
     const mikrotikClearToken = document.getElementById('mikrotik-clear-token');
     const band2Input = document.getElementById('band-2g');
@@ -301,6 +232,12 @@ function buildSettingsPayload() {
     if (newInterface !== (settingsSnapshot.mikrotik?.wlan_interface || '')) {
         mikrotik.wlan_interface = newInterface;
     }
+    if (mikrotikInterface2Input) {
+        const newInterface2 = mikrotikInterface2Input.value.trim();
+        if (newInterface2 !== (settingsSnapshot.mikrotik?.wlan_interface_2 || '')) {
+            mikrotik.wlan_interface_2 = newInterface2;
+        }
+    }
     if (Object.keys(mikrotik).length > 0) {
         payload.mikrotik = mikrotik;
     }
@@ -331,6 +268,10 @@ function buildSettingsPayload() {
             }
         }
     }
+    const scanModeSelect = document.getElementById('scan-mode');
+    if (scanModeSelect && scanModeSelect.value !== (settingsSnapshot.scan?.mode || 'ftp')) {
+        scan.mode = scanModeSelect.value;
+    }
     if (Object.keys(scan).length > 0) {
         payload.scan = scan;
     }
@@ -354,27 +295,27 @@ async function saveSettings() {
     try {
         const payload = buildSettingsPayload();
         if (!payload) {
-            showToast(t('config.save.nochanges'), 'info');
+            showNotification(t('config.save.nochanges'), 'info');
             return;
         }
 
         const result = await API.post('/api/settings', payload);
         if (result.wifi_changed) {
-            showToast(t('config.save.reconnecting'), 'info', 4000);
+            showNotification(t('config.save.reconnecting'), 'info', 4000);
         } else {
-            showToast(t('config.save.success'), 'success');
+            showNotification(t('config.save.success'), 'success');
         }
         if (result.captive_portal) {
-            showToast(t('config.status.captive', { ssid: settingsSnapshot?.status?.ap_ssid || 'MikroTikSetup' }), 'info', 6000);
+            showNotification(t('config.status.captive', { ssid: settingsSnapshot?.status?.ap_ssid || 'MikroTikSetup' }), 'info', 6000);
         }
         await loadSettings();
     } catch (error) {
-        showToast(t('config.save.failed', { error: error.message || error }), 'error');
+        showNotification(t('config.save.failed', { error: error.message || error }), 'error');
     }
 }
 
 document.addEventListener('DOMContentLoaded', async () => {
-    await initTranslations();
+    await initTranslations(DEFAULT_TRANSLATIONS);
     applyTranslationsToDOM();
     await loadSettings();
 
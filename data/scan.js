@@ -0,0 +1,811 @@
+/**
+ * MikroTik WiFi Manager - scan and connect view
+ *
+ * Loaded on demand by app.js once the status view is up; it shares that
+ * script's state, API and signal helpers.
+ */
+
+// Utility functions
+function simpleHash(text) {
+    // Simple string hash to create unique profile names
+    let hash = 0;
+    for (let i = 0; i < text.length; i++) {
+        const char = text.charCodeAt(i);
+        hash = ((hash << 5) - hash) + char;
+        hash = hash & hash; // Convert to 32bit integer
+    }
+    // Convert to positive hex (6 characters)
+    return Math.abs(hash).toString(16).padStart(6, '0').substring(0, 6);
+}
+
+function generateProfileName(ssid) {
+    if (!ssid) return Promise.resolve('client-ssid');
+    let base = ssid.trim().toLowerCase();
+    base = base.replace(/[^a-zA-Z0-9_-]+/g, '-');
+    base = base.replace(/^-+|-+$/g, '') || 'ssid';
+    base = base.substring(0, 24);
+
+    // Append hash to ensure uniqueness
+    const hash = simpleHash(ssid);
+    return Promise.resolve(`client-${base}-${hash}`);
+}
+
+function asBoolean(value) {
+    if (typeof value === 'boolean') return value;
+    if (value === null || value === undefined) return false;
+    if (typeof value === 'number') return value !== 0;
+    if (typeof value === 'string') {
+        const normalized = value.trim().toLowerCase();
+        return ['true', 'yes', 'on', '1', 'running', 'enabled'].includes(normalized);
+    }
+    return false;
+}
+
+function interpretSecurityFromProfile(profile) {
+    if (!profile) return null;
+    const mode = profile.mode;
+    const authTypes = profile['authentication-types'] || '';
+    return !(mode === 'none' || !authTypes);
+}
+
+function enableAutoScan(skipImmediate = false) {
+    if (!state.allowAutoScan) return;
+    if (state.isConnected) return;
+    if (state.autoScanTimer) return;
+    state.autoScanTimer = setInterval(() => {
+        if (!state.isScanning && !state.isConnected) {
+            // With the background scheduler the device scans anyway: just pick up its table
+            if (state.config?.scan_scheduler_interval_ms > 0 && !Events.connected) {
+                loadStoredNetworks(state.currentBand);
+            } else if (!(state.config?.scan_scheduler_interval_ms > 0)) {
+                scan(true);
+            }
+        }
+    }, AUTO_SCAN_INTERVAL);
+    if (!state.isScanning && !skipImmediate) {
+        scan(true);
+    }
+}
+
+function disableAutoScan() {
+    if (state.autoScanTimer) {
+        clearInterval(state.autoScanTimer);
+        state.autoScanTimer = null;
+    }
+}
+
+function ensureBandStore(band) {
+    if (!state.networks[band]) {
+        state.networks[band] = [];
+    }
+    return state.networks[band];
+}
+
+function getNetworksForBand(band) {
+    return ensureBandStore(band);
+}
+
+function getNetworksForCurrentBand() {
+    return getNetworksForBand(state.currentBand);
+}
+
+function getNetworkKey(network) {
+    if (!network) return '';
+    const ssid = network.ssid || '';
+    const mac = (network.mac || '').toLowerCase();
+    return `${ssid}__${mac}`;
+}
+
+function normalizeNetworkEntry(entry, band) {
+    if (!entry || !entry.ssid) {
+        return null;
+    }
+    let signal = entry.signal;
+    if (signal === undefined || signal === null) {
+        signal = entry.sig ?? entry.strength ?? entry.rssi ?? null;
+    }
+    if (typeof signal !== 'number') {
+        const parsed = parseInt(signal, 10);
+        signal = Number.isFinite(parsed) ? parsed : 0;
+    }
+    const macAddress = entry.mac || entry.address || entry.bssid || '';
+
+    // Interpret security state (frontend logic)
+    let security = entry.security;
+    if (security === undefined || security === null) {
+        // Check privacy flag
+        if (entry.privacy !== undefined && entry.privacy !== null) {
+            security = asBoolean(entry.privacy);
+        }
+        // Fallback: derive from profile information
+        else if (entry.profile) {
+            security = interpretSecurityFromProfile(entry.profile);
+        }
+    }
+
+    const profileObj = entry.profile ?? null;
+    const profileName = entry.profileName ?? (profileObj && profileObj.name) ?? '';
+
+    return {
+        ssid: entry.ssid,
+        mac: macAddress,
+        signal: Number.isFinite(signal) ? signal : 0,
+        frequency: entry.frequency ?? entry.freq ?? null,
+        security: security,
+        known: !!entry.known,
+        profile: profileObj,
+        profileName,
+        band,
+        lastUpdated: Date.now()
+    };
+}
+
+function mergeNetworkResults(existing, incoming, band) {
+    const merged = new Map();
+    existing.forEach(item => {
+        merged.set(getNetworkKey(item), { ...item });
+    });
+    incoming.forEach(item => {
+        if (!item) {
+            return;
+        }
+        const normalized = normalizeNetworkEntry(item, band);
+        if (!normalized) {
+            return;
+        }
+        const key = getNetworkKey(normalized);
+        if (merged.has(key)) {
+            merged.set(key, { ...merged.get(key), ...normalized });
+        } else {
+            merged.set(key, normalized);
+        }
+    });
+    return Array.from(merged.values()).sort((a, b) => {
+        const isKnownA = a.known ? 1 : 0;
+        const isKnownB = b.known ? 1 : 0;
+
+        if (isKnownA !== isKnownB) {
+            return isKnownB - isKnownA; // known first
+        }
+        return (b.signal ?? 0) - (a.signal ?? 0);
+    });
+}
+
+function setBandSelection(band, { triggerScan = false } = {}) {
+    if (!band) {
+        return;
+    }
+
+    const changed = state.currentBand !== band;
+    state.currentBand = band;
+    let matched = false;
+    const buttons = document.querySelectorAll('.band-btn');
+
+    buttons.forEach(btn => {
+        const isActive = btn.dataset.band === band;
+        btn.classList.toggle('active', isActive);
+        if (isActive) {
+            matched = true;
+        }
+    });
+
+    if (!matched) {
+        buttons.forEach(btn => btn.classList.remove('active'));
+    }
+    renderNetworkList();
+
+    if (triggerScan && (changed || !getNetworksForCurrentBand().length)) {
+        if (changed) {
+            disableAutoScan();
+            enableAutoScan(true);  // Restart auto-scan (skip immediate scan)
+        }
+        // Show what the device already has; scan only if that is missing or old
+        loadStoredNetworks(band).then(recent => {
+            if (!recent && state.currentBand === band) scan(false);
+        });
+    }
+}
+
+function getFilteredNetworks() {
+    const networks = getNetworksForCurrentBand();
+    if (!Array.isArray(networks)) {
+        return [];
+    }
+    return networks.filter(network => {
+        if (state.filter === 'secured') {
+            return network.security === true;
+        }
+        if (state.filter === 'open') {
+            return network.security === false;
+        }
+        return true;
+    });
+}
+
+function renderNetworkList() {
+    const list = document.getElementById('networks-list');
+    if (!list) return;
+
+    const filtered = getFilteredNetworks();
+    const allNetworks = getNetworksForCurrentBand();
+
+    if (!allNetworks.length) {
+        list.innerHTML = '<p style="text-align: center; color: #6c757d; padding: 24px;">Keine Netzwerke gefunden</p>';
+        hideConnectSection();
+        return;
+    }
+
+    if (!filtered.length) {
+        list.innerHTML = '<p style="text-align: center; color: #6c757d; padding: 24px;">Keine Netzwerke für diesen Filter</p>';
+        hideConnectSection();
+        return;
+    }
+
+    list.innerHTML = filtered.map(network => {
+        const signalPercent = signalToPercent(network.signal);
+        const securityState = network.security;
+        const requiresPassword = securityState !== false;
+        let icon = '';
+        if (securityState === true) {
+            icon = '🔒 ';
+        } else if (securityState === false) {
+            icon = '📡 ';
+        }
+        const badge = network.known ? `<span class="network-badge">${t('badge.known')}</span>` : '';
+        const key = getNetworkKey(network);
+        return `
+            <div class="network-item" data-ssid="${network.ssid}" data-mac="${network.mac || ''}" data-key="${key}" data-requires-password="${requiresPassword}">
+                <div class="network-header">
+                    <div class="network-ssid">${icon}${network.ssid}${badge}</div>
+                    <div>${network.signal} dBm</div>
+                </div>
+                <div class="network-details">
+                    <div class="network-meta">MAC: ${network.mac || 'N/A'}</div>
+                </div>
+                <div class="signal-bar">
+                    <div class="signal-fill" style="width: ${signalPercent}%; background: ${signalColor(signalPercent)};"></div>
+                </div>
+            </div>
+        `;
+    }).join('');
+
+    list.querySelectorAll('.network-item').forEach((item, index) => {
+        const network = filtered[index];
+        const securityState = network.security;
+        const requiresPassword = securityState !== false;
+        item.onclick = () => {
+            list.querySelectorAll('.network-item').forEach(i => i.classList.remove('selected'));
+            item.classList.add('selected');
+            const key = item.dataset.key;
+            state.selectedNetwork = {
+                ssid: network.ssid,
+                requiresPassword,
+                mac: network.mac || '',
+                securityState,
+                known: !!network.known,
+                profile: network.profile || null,
+                profileName: network.profileName || (network.profile && network.profile.name) || '',
+                band: state.currentBand,
+                key
+            };
+            showConnectSection();
+        };
+    });
+
+    if (state.selectedNetwork) {
+        const selectedElement = state.selectedNetwork.key
+            ? list.querySelector(`.network-item[data-key="${state.selectedNetwork.key}"]`)
+            : list.querySelector(`.network-item[data-ssid="${state.selectedNetwork.ssid}"]`);
+        if (selectedElement) {
+            selectedElement.classList.add('selected');
+        } else {
+            hideConnectSection();
+        }
+    }
+}
+
+// Merge a scan table (/api/scan/result, /api/scan/networks or a pushed
+// scan-result) into the band's network list
+function applyScanResponse(response, band) {
+    const existing = getNetworksForBand(band);
+    let updates = [];
+
+    // Networks are parsed and de-duplicated on the ESP32
+    if (Array.isArray(response.networks)) {
+        updates = response.networks;
+
+        // Attach profile info for known networks
+        const profileMap = {};
+        if (response.profiles && Array.isArray(response.profiles)) {
+            response.profiles.forEach(p => {
+                if (p.ssid) {
+                    profileMap[p.ssid] = p;
+                }
+            });
+        }
+
+        updates.forEach(network => {
+            const matched = profileMap[network.ssid];
+            network.known = !!matched;
+            network.profile = matched || null;
+            network.profileName = matched ? (matched.name || '') : '';
+        });
+    } else if (Array.isArray(response)) {
+        // Fallback: REST API format (old format)
+        updates = response;
+    }
+
+    const merged = mergeNetworkResults(existing, updates, band);
+    state.networks[band] = merged;
+
+    if (state.selectedNetwork && state.selectedNetwork.band === band) {
+        const selectedKey = getNetworkKey(state.selectedNetwork);
+        const refreshed = merged.find(net => getNetworkKey(net) === selectedKey);
+        if (refreshed) {
+            const refreshedKey = getNetworkKey(refreshed);
+            state.selectedNetwork = {
+                ...state.selectedNetwork,
+                known: !!refreshed.known,
+                securityState: refreshed.security,
+                requiresPassword: refreshed.security !== false,
+                mac: refreshed.mac || state.selectedNetwork.mac,
+                profile: refreshed.profile || null,
+                profileName: refreshed.profileName || (refreshed.profile && refreshed.profile.name) || state.selectedNetwork.profileName || '',
+                key: refreshedKey,
+                band
+            };
+            updatePasswordUI();
+        }
+    }
+
+    if (band === state.currentBand) {
+        renderNetworkList();
+    }
+
+    // Dual-radio scan: the device scanned the other band at the same time
+    if (response.companion_band && response.companion_band !== band && state.networks[response.companion_band]) {
+        loadStoredNetworks(response.companion_band);
+    }
+}
+
+// Networks the device already knows for a band (background and earlier scans).
+// Resolves true when that table is recent enough to skip a scan.
+async function loadStoredNetworks(band) {
+    try {
+        const response = await API.get('/api/scan/networks?band=' + encodeURIComponent(band));
+        if (!response || !Array.isArray(response.networks)) {
+            return false;
+        }
+        applyScanResponse(response, band);
+        return response.networks.length > 0 && response.age_ms !== null &&
+            response.age_ms < (state.config?.scan_scheduler_interval_ms || 0) * 2;
+    } catch (error) {
+        console.error('Loading stored networks failed:', error);
+        return false;
+    }
+}
+
+async function scan(auto = false, retryCount = 0) {
+    if (state.isScanning) return;
+    state.isScanning = true;
+    const requestedBand = state.currentBand;
+
+    if (!auto) {
+        document.getElementById('scan-status').style.display = 'block';
+        const scanStatusText = document.querySelector('#scan-status [data-i18n="scan.status.searching"]');
+        if (scanStatusText) {
+            scanStatusText.textContent = t('scan.status.searching');
+        }
+        document.getElementById('scan-btn').disabled = true;
+        state.selectedNetwork = null;
+        hideConnectSection();
+    }
+
+    try {
+        // Step 1: start the scan (non-blocking)
+        const startResponse = await API.post('/api/scan/start?band=' + encodeURIComponent(requestedBand), {});
+
+        if (startResponse.error) {
+            console.error('Scan start error:', startResponse.error);
+            showNotification(t('notification.scan.failedReason', { error: startResponse.error }), 'error');
+            return;
+        }
+
+        const pollInterval = startResponse?.poll_interval_ms
+            ?? state.config?.scan_poll_interval_ms
+            ?? 500;
+        const durationMs = startResponse?.duration_ms
+            ?? state.config?.scan_duration_ms
+            ?? 5000;
+        const minReadyMs = startResponse?.min_ready_ms
+            ?? state.config?.scan_min_ready_ms
+            ?? durationMs;
+        const timeoutMs = startResponse?.timeout_ms
+            ?? state.config?.scan_timeout_ms
+            ?? (minReadyMs + (state.config?.scan_result_grace_ms ?? 2000));
+
+        let response = null;
+        // If scan is already running, adjust scanStart to match backend timing
+        const elapsedMs = startResponse?.elapsed_ms ?? 0;
+
+        // If the existing scan has already expired, retry with a new scan
+        if (startResponse.status === 'already_scanning' && elapsedMs >= timeoutMs) {
+            if (retryCount >= 2) {
+                console.error('Max retry attempts reached for expired scan');
+                showNotification(t('notification.scan.failedReason', { error: 'Max retries exceeded' }), 'error');
+                return;
+            }
+            console.log('Existing scan expired, retrying... (attempt ' + (retryCount + 1) + ')');
+            // Reset state and wait a moment for backend cleanup, then retry
+            state.isScanning = false;
+            await new Promise(resolve => setTimeout(resolve, 500));
+            return scan(auto, retryCount + 1);
+        }
+
+        const scanStart = Date.now() - elapsedMs;
+
+        while (true) {
+            const elapsed = Date.now() - scanStart;
+
+            if (elapsed >= timeoutMs) {
+                break;
+            }
+
+            if (Events.connected) {
+                // Result is pushed as soon as it is ready; poll once in a while in case it was missed
+                const pushed = await Events.waitForScan(Math.min(timeoutMs - elapsed, SCAN_EVENT_RECHECK_MS));
+                if (pushed && (!pushed.band || pushed.band === requestedBand)) {
+                    response = pushed;
+                    break;
+                }
+                continue;
+            }
+
+            if (elapsed < minReadyMs) {
+                const waitMs = Math.min(pollInterval, Math.max(0, minReadyMs - elapsed));
+                if (waitMs > 0) {
+                    await new Promise(resolve => setTimeout(resolve, waitMs));
+                }
+                continue;
+            }
+
+            const pollResponse = await API.get('/api/scan/result');
+
+            if (!pollResponse || pollResponse.status === 'pending') {
+                await new Promise(resolve => setTimeout(resolve, pollInterval));
+                continue;
+            }
+
+            response = pollResponse;
+            break;
+        }
+
+        if (!response) {
+            showNotification(t('notification.scan.timeout'), 'error');
+            return;
+        }
+
+        if (response.error) {
+            console.error('Scan error:', response.error);
+            showNotification(t('notification.scan.failedReason', { error: response.error }), 'error');
+            return;
+        }
+
+        // Joined a background scan of the other band: keep it there, then scan ours
+        if (response.band && response.band !== requestedBand) {
+            if (state.networks[response.band]) {
+                applyScanResponse(response, response.band);
+            }
+            if (retryCount < 2) {
+                state.isScanning = false;
+                return scan(auto, retryCount + 1);
+            }
+            return;
+        }
+
+        applyScanResponse(response, requestedBand);
+    } catch (error) {
+        const message = error && error.message ? error.message : error;
+        showNotification(t('notification.scan.failedReason', { error: message }), 'error');
+    } finally {
+        if (!auto) {
+            document.getElementById('scan-status').style.display = 'none';
+            document.getElementById('scan-btn').disabled = false;
+        }
+        state.isScanning = false;
+        if (!auto && state.allowAutoScan && !state.isConnected) {
+            enableAutoScan(true);
+        }
+    }
+}
+
+function updatePasswordUI() {
+    const passwordField = document.getElementById('password-field');
+    const passwordInput = document.getElementById('password-input');
+    if (!passwordField || !passwordInput) return;
+
+    if (!state.selectedNetwork) {
+        passwordField.style.display = 'none';
+        passwordInput.placeholder = t('input.password.placeholder.required');
+        passwordInput.value = '';
+        return;
+    }
+
+    const requiresPassword = state.selectedNetwork.requiresPassword !== false;
+    const known = !!state.selectedNetwork.known;
+    passwordField.style.display = requiresPassword ? 'block' : 'none';
+
+    if (requiresPassword && known) {
+        // Saved encrypted network: password optional (can update stored value)
+        passwordInput.placeholder = t('input.password.placeholder.optional');
+    } else if (requiresPassword) {
+        // New encrypted network: password required
+        passwordInput.placeholder = t('input.password.placeholder.required');
+    } else {
+        passwordInput.placeholder = t('input.password.placeholder.none');
+    }
+}
+
+function showConnectSection() {
+    const section = document.getElementById('connect-section');
+    const forgetBtn = document.getElementById('forget-btn');
+    const specificApField = document.getElementById('specific-ap-field');
+    const apMacAddress = document.getElementById('ap-mac-address');
+    const connectToSpecificApCheckbox = document.getElementById('connect-to-specific-ap');
+
+    document.getElementById('selected-ssid').textContent = state.selectedNetwork.ssid;
+    document.getElementById('password-input').value = '';
+    updatePasswordUI();
+
+    // Show/hide specific AP option
+    if (specificApField && apMacAddress && connectToSpecificApCheckbox) {
+        if (state.selectedNetwork.mac) {
+            specificApField.style.display = 'block';
+            apMacAddress.textContent = 'MAC: ' + state.selectedNetwork.mac;
+            connectToSpecificApCheckbox.checked = false;
+            apMacAddress.style.display = 'none';
+
+            // Toggle MAC address visibility when checkbox changes
+            connectToSpecificApCheckbox.onchange = () => {
+                apMacAddress.style.display = connectToSpecificApCheckbox.checked ? 'block' : 'none';
+            };
+        } else {
+            specificApField.style.display = 'none';
+        }
+    }
+
+    if (forgetBtn) {
+        forgetBtn.style.display = state.selectedNetwork.known ? 'inline-block' : 'none';
+        forgetBtn.disabled = !state.selectedNetwork.known;
+    }
+
+    section.style.display = 'block';
+    section.scrollIntoView({ behavior: 'smooth', block: 'nearest' });
+}
+
+function hideConnectSection() {
+    const section = document.getElementById('connect-section');
+    section.style.display = 'none';
+    const forgetBtn = document.getElementById('forget-btn');
+    if (forgetBtn) {
+        forgetBtn.style.display = 'none';
+        forgetBtn.disabled = true;
+    }
+    const list = document.getElementById('networks-list');
+    if (list) {
+        list.querySelectorAll('.network-item').forEach(i => i.classList.remove('selected'));
+    }
+    state.selectedNetwork = null;
+    updatePasswordUI();
+}
+
+async function connect() {
+    if (!state.selectedNetwork) return;
+
+    const password = document.getElementById('password-input').value;
+    const requiresPassword = state.selectedNetwork.requiresPassword !== false;
+    const known = !!state.selectedNetwork.known;
+
+    // Password validation:
+    // - Encrypted networks: password required when not already saved
+    // - Saved encrypted networks: password optional (uses stored credential)
+    // - Open networks: no password needed
+    if (requiresPassword && !password && !known) {
+        showNotification(t('notification.password.required'), 'error');
+        return;
+    }
+
+    disableAutoScan();
+    document.getElementById('connect-btn').disabled = true;
+
+    try {
+        // Generate profile name on the frontend
+        const profileName = await generateProfileName(state.selectedNetwork.ssid);
+
+        const connectToSpecificApCheckbox = document.getElementById('connect-to-specific-ap');
+        const connectToSpecificAp = connectToSpecificApCheckbox?.checked || false;
+        const apMacAddress = connectToSpecificAp ? (state.selectedNetwork.mac || '') : '';
+
+        const response = await API.post('/api/connect', {
+            ssid: state.selectedNetwork.ssid,
+            password: password,
+            band: state.currentBand,
+            known,
+            requiresPassword,
+            profileName: profileName,
+            connectToSpecificAp: connectToSpecificAp,
+            apMacAddress: apMacAddress
+        });
+
+        if (response && response.error) {
+            throw new Error(response.error);
+        }
+
+        showNotification(t('notification.connect.start', { ssid: state.selectedNetwork.ssid }), 'success');
+        hideConnectSection();
+
+        // Refresh status after 3 seconds
+        setTimeout(updateStatus, 3000);
+    } catch(error) {
+        const message = error && error.message ? error.message : error;
+        showNotification(t('notification.connect.failed', { error: message }), 'error');
+    } finally {
+        document.getElementById('connect-btn').disabled = false;
+    }
+}
+
+async function forgetSelectedNetwork() {
+    if (!state.selectedNetwork || !state.selectedNetwork.known) return;
+
+    const payload = {
+        ssid: state.selectedNetwork.ssid
+    };
+    if (state.selectedNetwork.profileName) {
+        payload.profileName = state.selectedNetwork.profileName;
+    }
+
+    try {
+        const response = await API.post('/api/profile/delete', payload);
+        if (response && response.error) {
+            throw new Error(response.error);
+        }
+
+        const targetKey = state.selectedNetwork.key;
+        const targetBand = state.selectedNetwork.band;
+
+        Object.entries(state.networks).forEach(([bandKey, list]) => {
+            const updated = list.map(item => {
+                if (getNetworkKey(item) === targetKey) {
+                    return {
+                        ...item,
+                        known: false,
+                        profile: null,
+                        profileName: ''
+                    };
+                }
+                return item;
+            });
+            state.networks[bandKey] = bandKey === targetBand
+                ? mergeNetworkResults(updated, [], bandKey)
+                : updated;
+        });
+
+        const forgetBtn = document.getElementById('forget-btn');
+        if (forgetBtn) {
+            forgetBtn.style.display = 'none';
+            forgetBtn.disabled = true;
+        }
+
+        const ssid = state.selectedNetwork.ssid;
+        state.selectedNetwork.known = false;
+        state.selectedNetwork.profile = null;
+        state.selectedNetwork.profileName = '';
+        state.selectedNetwork.requiresPassword = state.selectedNetwork.securityState !== false;
+
+        updatePasswordUI();
+        renderNetworkList();
+
+        showNotification(t('notification.profile.deleted', { ssid }), 'success');
+    } catch (error) {
+        const message = error && error.message ? error.message : error;
+        showNotification(t('notification.profile.deleteFailed', { error: message }), 'error');
+    }
+}
+
+function createBandButtons(config) {
+    const container = document.getElementById('band-selector');
+    container.innerHTML = '';
+
+    // Extract mode suffix (e.g., "g/n" from "2ghz-g/n")
+    const extractMode = (band) => {
+        const parts = band.split('-');
+        return parts.length > 1 ? parts.slice(1).join('-') : '';
+    };
+
+    // 2.4 GHz button
+    const btn2ghz = document.createElement('button');
+    btn2ghz.className = 'band-btn active';
+    btn2ghz.dataset.band = config.band_2ghz;
+    btn2ghz.innerHTML = `
+        <span class="band-freq">2.4 GHz</span>
+        <span class="band-mode">${extractMode(config.band_2ghz)}</span>
+    `;
+    btn2ghz.onclick = () => setBandSelection(config.band_2ghz, { triggerScan: true });
+    container.appendChild(btn2ghz);
+
+    // 5 GHz button
+    const btn5ghz = document.createElement('button');
+    btn5ghz.className = 'band-btn';
+    btn5ghz.dataset.band = config.band_5ghz;
+    btn5ghz.innerHTML = `
+        <span class="band-freq">5 GHz</span>
+        <span class="band-mode">${extractMode(config.band_5ghz)}</span>
+    `;
+    btn5ghz.onclick = () => setBandSelection(config.band_5ghz, { triggerScan: true });
+    container.appendChild(btn5ghz);
+}
+
+function initScanView() {
+    createBandButtons(state.config);
+
+    document.getElementById('scan-btn').onclick = () => scan(false);
+    const autoScanToggle = document.getElementById('auto-scan-toggle');
+    if (autoScanToggle) {
+        autoScanToggle.addEventListener('change', () => {
+            state.allowAutoScan = autoScanToggle.checked;
+            if (state.allowAutoScan) {
+                if (!state.isConnected) enableAutoScan(true);
+            } else {
+                disableAutoScan();
+            }
+        });
+    }
+    document.getElementById('connect-btn').onclick = connect;
+    document.getElementById('cancel-btn').onclick = hideConnectSection;
+    document.getElementById('forget-btn').onclick = forgetSelectedNetwork;
+
+    document.querySelectorAll('.filter-btn').forEach(btn => {
+        btn.onclick = () => {
+            state.filter = btn.dataset.filter;
+            document.querySelectorAll('.filter-btn').forEach(b => b.classList.toggle('active', b === btn));
+            btn.blur();
+            renderNetworkList();
+        };
+    });
+
+    // Allow Enter key in password field
+    document.getElementById('password-input').addEventListener('keypress', (e) => {
+        if (e.key === 'Enter') {
+            connect();
+        }
+    });
+
+    setBandSelection(state.currentBand, { triggerScan: false });
+    updatePasswordUI();
+
+    scanView = {
+        onStatus(status) {
+            if (state.isConnected || state.isConnecting) {
+                disableAutoScan();
+            } else if (state.allowAutoScan) {
+                enableAutoScan();
+            }
+            if (status.band) {
+                setBandSelection(status.band, { triggerScan: false });
+            }
+        },
+        onScanResult(result) {
+            applyScanResponse(result, result.band);
+        }
+    };
+
+    // Networks from background scans are available right away
+    Object.keys(state.networks).forEach(band => loadStoredNetworks(band));
+
+    // The first status usually lands before this script does
+    if (state.lastStatus) {
+        scanView.onStatus(state.lastStatus);
+    }
+}
+
+initScanView();
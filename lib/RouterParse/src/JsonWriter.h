@@ -0,0 +1,111 @@
+#pragma once
+
+// Buffered JSON output for responses built from tables instead of ArduinoJson
+// documents. Strings are escaped a run at a time into a fixed buffer that is
+// handed to the sink whenever it fills, so a streamed response leaves in
+// pieces of ChunkSize bytes (about one TCP segment on the device).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <utility>
+
+struct JsonSink {
+  virtual ~JsonSink() = default;
+  virtual void write(const char* data, size_t length) = 0;  // data is NUL-terminated
+};
+
+template <size_t ChunkSize>
+class BasicJsonWriter {
+ public:
+  explicit BasicJsonWriter(JsonSink& sink) : sink_(sink) {}
+  ~BasicJsonWriter() { flush(); }
+  BasicJsonWriter(const BasicJsonWriter&) = delete;
+  BasicJsonWriter& operator=(const BasicJsonWriter&) = delete;
+
+  BasicJsonWriter& raw(const char* text) { return raw(text, strlen(text)); }
+
+  BasicJsonWriter& raw(const char* text, size_t length) {
+    while (length > 0) {
+      size_t room = ChunkSize - used_;
+      size_t count = length < room ? length : room;
+      memcpy(buffer_ + used_, text, count);
+      used_ += count;
+      text += count;
+      length -= count;
+      if (used_ == ChunkSize) flush();
+    }
+    return *this;
+  }
+
+  // Arduino String or std::string (char arrays take the const char* overload)
+  template <typename Text, typename = decltype(std::declval<const Text&>().c_str())>
+  BasicJsonWriter& raw(const Text& text) {
+    return raw(text.c_str(), text.length());
+  }
+
+  // Quoted string literal; quotes, backslashes and all control bytes are escaped
+  BasicJsonWriter& string(const char* text) {
+    raw("\"", 1);
+    const char* run = text;
+    for (const char* p = text; *p != '\0'; p++) {
+      uint8_t c = static_cast<uint8_t>(*p);
+      if (c >= 0x20 && c != '"' && c != '\\') continue;
+      raw(run, p - run);
+      run = p + 1;
+      switch (c) {
+        case '"': raw("\\\"", 2); break;
+        case '\\': raw("\\\\", 2); break;
+        case '\n': raw("\\n", 2); break;
+        case '\r': raw("\\r", 2); break;
+        case '\t': raw("\\t", 2); break;
+        default: {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+          raw(escaped, 6);
+        }
+      }
+    }
+    raw(run, strlen(run));
+    return raw("\"", 1);
+  }
+
+  template <typename Text, typename = decltype(std::declval<const Text&>().c_str())>
+  BasicJsonWriter& string(const Text& text) {
+    return string(text.c_str());
+  }
+
+  BasicJsonWriter& number(long value) {
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%ld", value);
+    return raw(digits, static_cast<size_t>(length));
+  }
+
+  BasicJsonWriter& number(unsigned long value) {
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%lu", value);
+    return raw(digits, static_cast<size_t>(length));
+  }
+
+  BasicJsonWriter& boolean(bool value) { return value ? raw("true", 4) : raw("false", 5); }
+
+  // "key": - the caller writes the value
+  BasicJsonWriter& key(const char* name) {
+    string(name);
+    return raw(":", 1);
+  }
+
+  void flush() {
+    if (used_ == 0) return;
+    buffer_[used_] = '\0';
+    sink_.write(buffer_, used_);
+    used_ = 0;
+  }
+
+ private:
+  JsonSink& sink_;
+  char buffer_[ChunkSize + 1];
+  size_t used_ = 0;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// RouterOS value helpers shared by the firmware and the native build
+
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+// RouterOS reports booleans as "true"/"yes"/"enabled" etc.
+inline bool asBool(const char* value) {
+  if (value == nullptr) return false;
+  while (*value == ' ') value++;
+  size_t length = strlen(value);
+  while (length > 0 && isspace(static_cast<unsigned char>(value[length - 1]))) length--;
+  static const char* const truthy[] = {"true", "yes", "on", "1", "running", "enabled"};
+  for (const char* word : truthy) {
+    if (strlen(word) == length && strncasecmp(value, word, length) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
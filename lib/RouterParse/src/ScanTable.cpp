@@ -0,0 +1,201 @@
+#include "ScanTable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "RouterValues.h"
+
+namespace {
+
+int8_t clampSignal(int value) {
+  return static_cast<int8_t>(value < -128 ? -128 : value > 127 ? 127 : value);
+}
+
+}  // namespace
+
+void scanTableClear(ScanTable& table) {
+  table.count = 0;
+  table.dropped = 0;
+}
+
+void scanTableAdd(ScanTable& table, const ScanNetwork& network) {
+  for (size_t i = 0; i < table.count; i++) {
+    ScanNetwork& existing = table.entries[i];
+    if (memcmp(existing.bssid, network.bssid, sizeof(network.bssid)) == 0) {
+      if (network.signal > existing.signal) {
+        existing = network;
+      }
+      return;
+    }
+  }
+
+  if (table.count < table.capacity) {
+    table.entries[table.count++] = network;
+    return;
+  }
+
+  // Table full: replace the weakest entry if this one is stronger
+  size_t weakest = 0;
+  for (size_t i = 1; i < table.count; i++) {
+    if (table.entries[i].signal < table.entries[weakest].signal) {
+      weakest = i;
+    }
+  }
+  if (table.count > 0 && network.signal > table.entries[weakest].signal) {
+    table.entries[weakest] = network;
+  }
+  table.dropped++;
+}
+
+bool parseMacAddress(const char* text, uint8_t out[6]) {
+  unsigned int bytes[6];
+  if (sscanf(text, "%2x:%2x:%2x:%2x:%2x:%2x", &bytes[0], &bytes[1], &bytes[2],
+             &bytes[3], &bytes[4], &bytes[5]) != 6) {
+    return false;
+  }
+  for (int i = 0; i < 6; i++) {
+    out[i] = static_cast<uint8_t>(bytes[i]);
+  }
+  return true;
+}
+
+void formatMacAddress(const uint8_t mac[6], char out[18]) {
+  snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+char* trimField(char* field) {
+  while (*field == ' ') field++;
+  size_t length = strlen(field);
+  while (length > 0 && (field[length - 1] == ' ' || field[length - 1] == '\r')) {
+    field[--length] = '\0';
+  }
+  return field;
+}
+
+// Quote characters (' or ") only toggle quoting and are not part of a field.
+bool scanCsvParseLine(char* line, ScanNetwork& out) {
+  const size_t MAX_FIELDS = 8;
+  char* fields[MAX_FIELDS];
+  size_t fieldCount = 0;
+  bool inQuote = false;
+  char* write = line;
+  fields[fieldCount++] = line;
+
+  for (char* read = line; *read != '\0'; read++) {
+    char c = *read;
+    if (c == '\'' || c == '\"') {
+      inQuote = !inQuote;
+    } else if (c == ',' && !inQuote) {
+      *write++ = '\0';
+      if (fieldCount == MAX_FIELDS) {
+        break;
+      }
+      fields[fieldCount++] = write;
+    } else {
+      *write++ = c;
+    }
+  }
+  *write = '\0';
+
+  // Require at least 4 fields: MAC, SSID, channel, signal
+  if (fieldCount < 4) {
+    return false;
+  }
+
+  const char* ssid = trimField(fields[1]);
+  out = ScanNetwork();
+  if (ssid[0] == '\0' || !parseMacAddress(trimField(fields[0]), out.bssid)) {
+    return false;
+  }
+
+  strncpy(out.ssid, ssid, sizeof(out.ssid) - 1);
+  const char* channel = trimField(fields[2]);
+  if (strchr(channel, '/') != nullptr) {
+    out.frequency = static_cast<uint16_t>(atoi(channel));
+  }
+  out.signal = clampSignal(atoi(trimField(fields[3])));
+  if (fieldCount > 5 && strcasecmp(trimField(fields[5]), "privacy") == 0) {
+    out.flags |= SCAN_FLAG_PRIVACY;
+  }
+  return true;
+}
+
+void scanTableParseCsvLine(ScanTable& table, char* line) {
+  ScanNetwork network;
+  if (scanCsvParseLine(line, network)) {
+    scanTableAdd(table, network);
+  }
+}
+
+void scanTableAddRestEntry(ScanTable& table, JsonObjectConst entry) {
+  const char* ssid = entry["ssid"] | "";
+  const char* address = entry["address"] | "";
+  ScanNetwork network = {};
+  if (ssid[0] == '\0' || !parseMacAddress(address, network.bssid)) {
+    return;
+  }
+
+  strncpy(network.ssid, ssid, sizeof(network.ssid) - 1);
+  const char* channel = entry["channel"] | "";
+  if (strchr(channel, '/') != nullptr) {
+    network.frequency = static_cast<uint16_t>(atoi(channel));
+  }
+  network.signal = clampSignal(atoi(entry["sig"] | "0"));
+  if (entry.containsKey("privacy")) {
+    if (asBool(entry["privacy"] | "")) {
+      network.flags |= SCAN_FLAG_PRIVACY;
+    }
+  } else {
+    network.flags |= SCAN_FLAG_PRIVACY_UNKNOWN;
+  }
+
+  scanTableAdd(table, network);
+}
+
+size_t scanTableMarkKnown(ScanTable& table, const char* ssid) {
+  size_t marked = 0;
+  for (size_t i = 0; i < table.count; i++) {
+    if (strcmp(table.entries[i].ssid, ssid) == 0) {
+      table.entries[i].flags |= SCAN_FLAG_KNOWN;
+      marked++;
+    }
+  }
+  return marked;
+}
+
+size_t scanTableToBinary(const ScanTable& table, uint8_t* out, size_t capacity, const char* band) {
+  size_t bandLength = strlen(band);
+  if (bandLength > 255) bandLength = 255;
+  size_t pos = 0;
+  if (capacity < 7 + bandLength) {
+    return 0;
+  }
+  memcpy(out, "MTSC", 4);
+  out[4] = 1;
+  out[5] = 0;
+  out[6] = static_cast<uint8_t>(bandLength);
+  memcpy(out + 7, band, bandLength);
+  pos = 7 + bandLength;
+
+  uint8_t count = 0;
+  for (size_t i = 0; i < table.count && count < 255; i++) {
+    const ScanNetwork& network = table.entries[i];
+    size_t ssidLength = strlen(network.ssid);
+    if (pos + 11 + ssidLength > capacity) {
+      break;
+    }
+    memcpy(out + pos, network.bssid, 6);
+    out[pos + 6] = static_cast<uint8_t>(network.signal);
+    out[pos + 7] = network.flags;
+    out[pos + 8] = static_cast<uint8_t>(network.frequency & 0xFF);
+    out[pos + 9] = static_cast<uint8_t>(network.frequency >> 8);
+    out[pos + 10] = static_cast<uint8_t>(ssidLength);
+    memcpy(out + pos + 11, network.ssid, ssidLength);
+    pos += 11 + ssidLength;
+    count++;
+  }
+  out[5] = count;
+  return pos;
+}
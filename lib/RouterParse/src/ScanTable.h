@@ -0,0 +1,67 @@
+#pragma once
+
+// The router's scan CSV (or REST scan response) is parsed once into a
+// fixed-size table, de-duplicated by BSSID, instead of shipping raw CSV to
+// the browser. No Arduino dependencies: also built by the native environment.
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+
+const uint8_t SCAN_FLAG_PRIVACY = 0x01;
+const uint8_t SCAN_FLAG_KNOWN = 0x02;
+const uint8_t SCAN_FLAG_PRIVACY_UNKNOWN = 0x04;  // REST scans do not report encryption
+const size_t SCAN_CSV_LINE_MAX = 256;
+
+struct ScanNetwork {
+  uint8_t bssid[6];
+  int8_t signal;
+  uint8_t flags;
+  uint16_t frequency;
+  char ssid[33];
+};
+
+struct ScanTable {
+  ScanNetwork* entries;
+  size_t capacity;
+  size_t count = 0;
+  size_t dropped = 0;
+
+  ScanTable(ScanNetwork* storage, size_t size) : entries(storage), capacity(size) {}
+  ScanTable(const ScanTable&) = delete;
+  ScanTable& operator=(const ScanTable&) = delete;
+};
+
+// Table with its own storage for Capacity networks
+template <size_t Capacity>
+struct ScanTableBuffer : ScanTable {
+  ScanNetwork storage[Capacity];
+  ScanTableBuffer() : ScanTable(storage, Capacity) {}
+};
+
+void scanTableClear(ScanTable& table);
+
+// Insert or merge by BSSID, keeping the strongest reading
+void scanTableAdd(ScanTable& table, const ScanNetwork& network);
+
+bool parseMacAddress(const char* text, uint8_t out[6]);
+void formatMacAddress(const uint8_t mac[6], char out[18]);
+char* trimField(char* field);
+
+// Parse one CSV line in place: MAC, SSID, channel, signal, ..., privacy flag (index 5).
+// False for headers, hidden networks and malformed lines.
+bool scanCsvParseLine(char* line, ScanNetwork& out);
+
+// scanCsvParseLine() + scanTableAdd()
+void scanTableParseCsvLine(ScanTable& table, char* line);
+
+// One element of the REST /interface/wireless/scan response
+void scanTableAddRestEntry(ScanTable& table, JsonObjectConst entry);
+
+// Flag every network broadcasting ssid as known; returns the number flagged
+size_t scanTableMarkKnown(ScanTable& table, const char* ssid);
+
+// Binary encoding for /api/scan/result.bin (little endian):
+//   "MTSC" | u8 version=1 | u8 count | u8 bandLength | band
+//   per network: bssid[6] | i8 signal | u8 flags | u16 frequency | u8 ssidLength | ssid
+size_t scanTableToBinary(const ScanTable& table, uint8_t* out, size_t capacity, const char* band);
@@ -0,0 +1,81 @@
+#include "SignalHistory.h"
+
+void signalHistoryClear(SignalHistory& history) {
+  history.count = 0;
+  history.next = 0;
+}
+
+void signalHistoryAdd(SignalHistory& history, const HistorySample& sample) {
+  if (history.capacity == 0) {
+    return;
+  }
+  history.samples[history.next] = sample;
+  history.next = (history.next + 1) % history.capacity;
+  if (history.count < history.capacity) {
+    history.count++;
+  }
+}
+
+const HistorySample& signalHistoryAt(const SignalHistory& history, size_t index) {
+  size_t oldest = (history.next + history.capacity - history.count) % history.capacity;
+  return history.samples[(oldest + index) % history.capacity];
+}
+
+size_t signalHistoryDownsample(const SignalHistory& history, uint16_t now, uint32_t windowS,
+                               HistoryBucket* out, size_t points) {
+  // Samples are in time order, so the window is a suffix of the ring
+  size_t first = 0;
+  if (windowS > 0) {
+    while (first < history.count &&
+           static_cast<uint16_t>(now - signalHistoryAt(history, first).time) > windowS) {
+      first++;
+    }
+  }
+  size_t total = history.count - first;
+  if (total == 0 || points == 0) {
+    return 0;
+  }
+  size_t buckets = total < points ? total : points;
+
+  for (size_t b = 0; b < buckets; b++) {
+    size_t begin = first + b * total / buckets;
+    size_t end = first + (b + 1) * total / buckets;
+    HistoryBucket bucket = {};
+    int32_t signalSum = 0;
+    uint32_t ccqSum = 0;
+    uint32_t txSum = 0;
+    uint32_t rxSum = 0;
+    bucket.signalMin = INT8_MAX;
+
+    for (size_t i = begin; i < end; i++) {
+      const HistorySample& sample = signalHistoryAt(history, i);
+      bucket.samples++;
+      if (sample.signal == HISTORY_NO_SIGNAL) {
+        continue;
+      }
+      bucket.linked++;
+      signalSum += sample.signal;
+      if (sample.signal < bucket.signalMin) bucket.signalMin = sample.signal;
+      txSum += sample.txRate;
+      rxSum += sample.rxRate;
+      if (sample.ccq != HISTORY_NO_CCQ) {
+        bucket.ccqSamples++;
+        ccqSum += sample.ccq;
+      }
+    }
+
+    bucket.ageS = static_cast<uint16_t>(now - signalHistoryAt(history, end - 1).time);
+    if (bucket.linked > 0) {
+      bucket.signalAvg = static_cast<int8_t>(signalSum / bucket.linked);
+      bucket.txRateAvg = static_cast<uint16_t>(txSum / bucket.linked);
+      bucket.rxRateAvg = static_cast<uint16_t>(rxSum / bucket.linked);
+    } else {
+      bucket.signalMin = HISTORY_NO_SIGNAL;
+    }
+    if (bucket.ccqSamples > 0) {
+      bucket.ccqAvg = static_cast<uint8_t>(ccqSum / bucket.ccqSamples);
+    }
+    out[b] = bucket;
+  }
+  return buckets;
+}
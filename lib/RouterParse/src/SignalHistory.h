@@ -0,0 +1,65 @@
+#pragma once
+
+// Link quality history for /api/history: one packed 8-byte sample per
+// HISTORY_SAMPLE_INTERVAL_MS in a fixed ring, oldest overwritten first, and
+// reduced to a fixed number of buckets when read. No Arduino dependencies:
+// also built by the native environment.
+
+#include <stddef.h>
+#include <stdint.h>
+
+const int8_t HISTORY_NO_SIGNAL = INT8_MIN;  // No link when the sample was taken
+const uint8_t HISTORY_NO_CCQ = 0xFF;        // Not reported (e.g. RouterOS wifi packages)
+
+struct HistorySample {
+  uint16_t time;    // Seconds since boot modulo 65536; ages beyond ~18 h wrap
+  int8_t signal;    // dBm, HISTORY_NO_SIGNAL without link
+  uint8_t ccq;      // %, HISTORY_NO_CCQ when unknown
+  uint16_t txRate;  // Mbps
+  uint16_t rxRate;  // Mbps
+};
+
+static_assert(sizeof(HistorySample) == 8, "history samples are packed into 8 bytes");
+
+struct SignalHistory {
+  HistorySample* samples;
+  size_t capacity;
+  size_t count = 0;
+  size_t next = 0;  // Slot the next sample goes to
+
+  SignalHistory(HistorySample* storage, size_t size) : samples(storage), capacity(size) {}
+  SignalHistory(const SignalHistory&) = delete;
+  SignalHistory& operator=(const SignalHistory&) = delete;
+};
+
+// History with its own storage for Capacity samples
+template <size_t Capacity>
+struct SignalHistoryBuffer : SignalHistory {
+  HistorySample storage[Capacity];
+  SignalHistoryBuffer() : SignalHistory(storage, Capacity) {}
+};
+
+// One point of a downsampled series; averages are only valid when their count is non-zero
+struct HistoryBucket {
+  uint16_t ageS;        // Age of the bucket's newest sample
+  uint16_t samples;
+  uint16_t linked;      // Samples with a link: signal and rates average over these
+  uint16_t ccqSamples;  // Linked samples that reported CCQ
+  int8_t signalAvg;
+  int8_t signalMin;
+  uint8_t ccqAvg;
+  uint16_t txRateAvg;
+  uint16_t rxRateAvg;
+};
+
+void signalHistoryClear(SignalHistory& history);
+void signalHistoryAdd(SignalHistory& history, const HistorySample& sample);
+
+// Sample `index`, oldest first (index < count)
+const HistorySample& signalHistoryAt(const SignalHistory& history, size_t index);
+
+// Samples of the last windowS seconds before `now` (0 = all) averaged into at
+// most `points` buckets of about equal sample count, oldest first. Returns the
+// number of buckets written.
+size_t signalHistoryDownsample(const SignalHistory& history, uint16_t now, uint32_t windowS,
+                               HistoryBucket* out, size_t points);
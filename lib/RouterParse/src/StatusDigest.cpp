@@ -0,0 +1,187 @@
+#include "StatusDigest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "RouterValues.h"
+
+namespace {
+
+// ArduinoJson copies char* but only references const char*: every string
+// goes in as a copy so `out` outlives the input documents
+void setText(JsonVariant target, const char* text) {
+  target.set(const_cast<char*>(text));
+}
+
+void setText(JsonVariant target, const char* text, size_t length) {
+  char buffer[64];
+  if (length >= sizeof(buffer)) length = sizeof(buffer) - 1;
+  memcpy(buffer, text, length);
+  buffer[length] = '\0';
+  setText(target, buffer);
+}
+
+JsonObjectConst findWlanInterface(JsonArrayConst interfaces, const char* name) {
+  for (JsonObjectConst iface : interfaces) {
+    const char* ifaceName = iface["name"] | "";
+    if (strcmp(ifaceName, name) == 0 && statusIsWlan(ifaceName)) {
+      return iface;
+    }
+  }
+  return JsonObjectConst();
+}
+
+// "65Mbps-20MHz/1S/SGI" -> 65
+uint16_t parseRateMbps(const char* rate) {
+  double value = atof(rate) + 0.5;
+  return static_cast<uint16_t>(value < 0 ? 0 : value > 65535 ? 65535 : value);
+}
+
+}  // namespace
+
+bool statusIsWlan(const char* name) {
+  for (const char* p = name; *p != '\0'; p++) {
+    if (strncasecmp(p, "wlan", 4) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* statusDigestLink(JsonArrayConst interfaces, JsonArrayConst registrations, JsonDocument& out) {
+  // Registration table is the most reliable indicator of active links
+  for (JsonObjectConst entry : registrations) {
+    const char* ifaceName = entry["interface"] | "";
+    JsonObjectConst iface = findWlanInterface(interfaces, ifaceName);
+    if (iface.isNull()) {
+      continue;
+    }
+    const char* ssid = iface["ssid"] | "";
+    if (ssid[0] == '\0') ssid = entry["ssid"] | "";
+    if (ssid[0] == '\0') ssid = entry["radio-name"] | "";
+
+    out["connected"] = true;
+    setText(out["interface"], ifaceName);
+    setText(out["ssid"], ssid);
+    out["running"] = true;
+    if (entry.containsKey("signal-strength")) {
+      out["signal"] = atoi(entry["signal-strength"] | "");
+    }
+    if (entry.containsKey("signal-to-noise")) {
+      out["snr"] = atoi(entry["signal-to-noise"] | "");
+    }
+    const char* band = iface["band"] | "";
+    if (band[0] != '\0') setText(out["band"], band);
+    return ifaceName;
+  }
+
+  // Fallback: inspect interface flags
+  for (JsonObjectConst iface : interfaces) {
+    const char* name = iface["name"] | "";
+    if (!statusIsWlan(name)) continue;
+    const char* band = iface["band"] | "";
+    const char* ssid = iface["ssid"] | "";
+    bool running = asBool(iface["running"] | "");
+
+    if (asBool(iface["disabled"] | "")) {
+      // Even if interface is disabled, capture the band for UI accuracy
+      if (band[0] != '\0' && !out.containsKey("band")) setText(out["band"], band);
+      continue;
+    }
+
+    if (running || ssid[0] != '\0') {
+      out[running ? "connected" : "connecting"] = true;
+      setText(out["interface"], name);
+      setText(out["ssid"], ssid);
+      out["running"] = running;
+      if (band[0] != '\0') setText(out["band"], band);
+      return running ? name : "";
+    }
+  }
+  return "";
+}
+
+void statusDigestAddress(JsonArrayConst addresses, const char* activeInterface, JsonDocument& out) {
+  JsonObjectConst selected;
+  for (JsonObjectConst addr : addresses) {
+    const char* ifaceName = addr["interface"] | "";
+    const char* actualName = addr["actual-interface"] | "";
+    if (strcmp(ifaceName, activeInterface) == 0 || strcmp(actualName, activeInterface) == 0) {
+      selected = addr;
+      if (asBool(addr["dynamic"] | "")) break;
+    }
+  }
+  if (selected.isNull()) {
+    return;
+  }
+  const char* address = selected["address"] | "";
+  const char* slash = strchr(address, '/');
+  if (slash != nullptr && slash > address) {
+    setText(out["ip"], address, slash - address);
+    setText(out["prefix"], slash + 1);
+  }
+  const char* network = selected["network"] | "";
+  if (network[0] != '\0') setText(out["network"], network);
+}
+
+void statusDigestGateway(JsonArrayConst routes, const char* activeInterface, JsonDocument& out) {
+  size_t interfaceLength = strlen(activeInterface);
+  for (JsonObjectConst route : routes) {
+    const char* dst = route["dst-address"] | "";
+    if (strcmp(dst, "0.0.0.0/0") != 0 || !asBool(route["active"] | "")) continue;
+    const char* immediateGw = route["immediate-gw"] | "";
+    const char* gateway = route["gateway"] | "";
+    // immediate-gw looks like "192.168.88.1%wlan1"
+    const char* percent = strchr(immediateGw, '%');
+    bool viaInterface = false;
+    while (percent != nullptr && !viaInterface) {
+      viaInterface = strncmp(percent + 1, activeInterface, interfaceLength) == 0;
+      percent = strchr(percent + 1, '%');
+    }
+    if (viaInterface || strcmp(gateway, activeInterface) == 0) {
+      setText(out["gateway"], gateway);
+      break;
+    }
+  }
+}
+
+void statusDigestDns(const char* servers, JsonDocument& out) {
+  if (servers == nullptr || servers[0] == '\0') {
+    return;
+  }
+  JsonArray dnsArr = out.createNestedArray("dns");
+  const char* start = servers;
+  while (true) {
+    const char* comma = strchr(start, ',');
+    const char* end = comma != nullptr ? comma : start + strlen(start);
+    const char* first = start;
+    while (first < end && isspace(static_cast<unsigned char>(*first))) first++;
+    const char* last = end;
+    while (last > first && isspace(static_cast<unsigned char>(last[-1]))) last--;
+    if (last > first) setText(dnsArr.add(), first, last - first);
+    if (comma == nullptr) break;
+    start = comma + 1;
+  }
+}
+
+HistorySample statusDigestLinkSample(JsonArrayConst registrations, const char* activeInterface) {
+  HistorySample sample = {0, HISTORY_NO_SIGNAL, HISTORY_NO_CCQ, 0, 0};
+  if (activeInterface == nullptr || activeInterface[0] == '\0') {
+    return sample;
+  }
+  for (JsonObjectConst entry : registrations) {
+    if (strcmp(entry["interface"] | "", activeInterface) != 0) continue;
+    // "-62@HT20-7" on older RouterOS versions: atoi stops at the '@'
+    int signal = atoi(entry["signal-strength"] | "0");
+    sample.signal = static_cast<int8_t>(signal < -127 ? -127 : signal > 127 ? 127 : signal);
+    if (entry.containsKey("tx-ccq")) {
+      int ccq = atoi(entry["tx-ccq"] | "0");
+      sample.ccq = static_cast<uint8_t>(ccq < 0 ? 0 : ccq > 100 ? 100 : ccq);
+    }
+    sample.txRate = parseRateMbps(entry["tx-rate"] | "");
+    sample.rxRate = parseRateMbps(entry["rx-rate"] | "");
+    break;
+  }
+  return sample;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Digest of the RouterOS interface, registration, address, route and DNS
+// lists into the compact status object the frontend renders. Pure functions
+// over parsed documents, so the native build can run them on recorded
+// responses. Strings are copied into `out`, which may outlive the inputs.
+
+#include <ArduinoJson.h>
+
+#include "SignalHistory.h"
+
+// Only wlan* interfaces are considered (case-insensitive)
+bool statusIsWlan(const char* name);
+
+// connected/connecting, interface, ssid, running, signal, snr and band from
+// /interface/wireless and its registration table. Returns the name of the
+// interface with an active link, or "" when there is none.
+const char* statusDigestLink(JsonArrayConst interfaces, JsonArrayConst registrations, JsonDocument& out);
+
+// ip, prefix and network of the active interface (dynamic entries preferred)
+void statusDigestAddress(JsonArrayConst addresses, const char* activeInterface, JsonDocument& out);
+
+// gateway: the active default route via the active interface
+void statusDigestGateway(JsonArrayConst routes, const char* activeInterface, JsonDocument& out);
+
+// dns: the comma-separated /ip/dns servers as an array
+void statusDigestDns(const char* servers, JsonDocument& out);
+
+// Signal, CCQ and tx/rx rate of the registration on activeInterface as a
+// history sample (time left 0); HISTORY_NO_SIGNAL when there is none
+HistorySample statusDigestLinkSample(JsonArrayConst registrations, const char* activeInterface);
@@ -0,0 +1,371 @@
+"""
+PlatformIO pre-script: stage the web UI for the LittleFS image.
+
+Copies data/ into .pio/build/<env>/data and on the way:
+- minifies the scripts, stylesheets, pages and translations
+- renames scripts and stylesheets to content-hashed names (/app.1a2b3c4d.js)
+  and rewrites the references to them; other assets get ?v=<hash>
+- builds one copy of every page per language with that language's strings
+  inlined (/index.html in DEFAULT_LANGUAGE, /index.de.html, ...)
+- adds a gzip copy of every text asset (*.gz, served with Content-Encoding: gzip)
+- writes /assets.json, the manifest the firmware uses for ETags, cache headers
+  and language selection
+
+Runs only for filesystem targets (buildfs, uploadfs, uploadfsota); data/
+itself is never modified.
+"""
+
+import gzip
+import hashlib
+import json
+import os
+import re
+import shutil
+
+Import("env")  # noqa: F821 - provided by PlatformIO
+
+FS_TARGETS = {"buildfs", "uploadfs", "uploadfsota"}
+COMPRESSIBLE = {".html", ".css", ".js", ".json", ".svg", ".ico"}
+HASHED_NAMES = {".css", ".js"}
+MANIFEST_NAME = "assets.json"
+TRANSLATIONS_DIR = "/i18n/"
+DEFAULT_LANGUAGE = "en"
+
+
+def content_hash(data):
+    return hashlib.sha1(data).hexdigest()[:8]
+
+
+def hashed_name(path, digest):
+    # /app.js -> /app.1a2b3c4d.js
+    stem, ext = os.path.splitext(path)
+    return "%s.%s%s" % (stem, digest, ext)
+
+
+def variant_name(path, language):
+    # /index.html -> /index.de.html
+    stem, ext = os.path.splitext(path)
+    return "%s.%s%s" % (stem, language, ext)
+
+
+# ---------------------------------------------------------------- minifiers
+
+JS_WORD = re.compile(r"[A-Za-z0-9_$]")
+# A '/' after these starts a regular expression, not a division
+JS_REGEX_AFTER = set("(,=:[!&|?{};+-*%<>~^")
+JS_REGEX_KEYWORDS = {"return", "typeof", "case", "do", "else", "in", "of", "new",
+                     "delete", "void", "throw", "instanceof", "yield", "await"}
+# Line breaks next to these can never end a statement
+JS_JOIN_AFTER = set("{;,([=:&|?*%<>!~^")
+JS_JOIN_BEFORE = set("}),];:.?=&|")
+
+
+def skip_js_string(source, i):
+    quote = source[i]
+    i += 1
+    while i < len(source) and source[i] != quote:
+        if source[i] == "\\":
+            i += 1
+        elif source[i] == "\n":
+            raise ValueError("unterminated string literal")
+        i += 1
+    return i + 1
+
+
+def skip_js_template(source, i):
+    # Returns the index after the closing backtick, expressions included
+    i += 1
+    while i < len(source):
+        c = source[i]
+        if c == "\\":
+            i += 2
+        elif c == "`":
+            return i + 1
+        elif source.startswith("${", i):
+            i = skip_js_expression(source, i + 2)
+        else:
+            i += 1
+    raise ValueError("unterminated template literal")
+
+
+def skip_js_expression(source, i):
+    # Index after the '}' closing a ${...} substitution
+    depth = 0
+    while i < len(source):
+        c = source[i]
+        if c in "'\"":
+            i = skip_js_string(source, i)
+        elif c == "`":
+            i = skip_js_template(source, i)
+        elif c == "{":
+            depth += 1
+            i += 1
+        elif c == "}":
+            if depth == 0:
+                return i + 1
+            depth -= 1
+            i += 1
+        else:
+            i += 1
+    raise ValueError("unterminated template substitution")
+
+
+def skip_js_regex(source, i):
+    i += 1
+    in_class = False
+    while i < len(source):
+        c = source[i]
+        if c == "\\":
+            i += 2
+            continue
+        if c == "\n":
+            raise ValueError("unterminated regular expression")
+        if c == "[":
+            in_class = True
+        elif c == "]":
+            in_class = False
+        elif c == "/" and not in_class:
+            i += 1
+            while i < len(source) and source[i].isalpha():
+                i += 1
+            return i
+        i += 1
+    raise ValueError("unterminated regular expression")
+
+
+def minify_js(source):
+    """Drop comments and indentation; literals are copied verbatim.
+
+    Line breaks survive wherever automatic semicolon insertion could depend on
+    them, so the output parses exactly like the input.
+    """
+    out = []
+    last = ""          # last character written
+    last_word = ""     # identifier or keyword just written, for regex detection
+    gap = None         # None, " " or "\n": whitespace skipped since the last token
+    i = 0
+    n = len(source)
+
+    def emit(token, first):
+        nonlocal gap, last
+        if gap is not None and last:
+            if gap == "\n" and last not in JS_JOIN_AFTER and first not in JS_JOIN_BEFORE:
+                out.append("\n")
+            elif (JS_WORD.match(last) and JS_WORD.match(first)) or (last in "+-" and first == last):
+                out.append(" ")
+        gap = None
+        out.append(token)
+        last = token[-1]
+
+    while i < n:
+        c = source[i]
+        if c in " \t\r\n":
+            if c == "\n" or gap == "\n":
+                gap = "\n"
+            else:
+                gap = " "
+            i += 1
+        elif source.startswith("//", i):
+            end = source.find("\n", i)
+            i = n if end < 0 else end
+        elif source.startswith("/*", i):
+            end = source.find("*/", i + 2)
+            if end < 0:
+                raise ValueError("unterminated comment")
+            gap = "\n" if "\n" in source[i:end] or gap == "\n" else " "
+            i = end + 2
+        elif c in "'\"":
+            end = skip_js_string(source, i)
+            emit(source[i:end], c)
+            last_word = ""
+            i = end
+        elif c == "`":
+            end = skip_js_template(source, i)
+            emit(source[i:end], c)
+            last_word = ""
+            i = end
+        elif c == "/" and (last == "" or last in JS_REGEX_AFTER or last_word in JS_REGEX_KEYWORDS):
+            end = skip_js_regex(source, i)
+            emit(source[i:end], c)
+            last = "a"  # flags must not run into a following word
+            last_word = ""
+            i = end
+        elif JS_WORD.match(c):
+            end = i
+            while end < n and (JS_WORD.match(source[end]) or (source[end] == "." and source[i].isdigit())):
+                end += 1
+            word = source[i:end]
+            emit(word, c)
+            last_word = word
+            i = end
+        else:
+            emit(c, c)
+            last_word = ""
+            i += 1
+
+    return "".join(out) + "\n"
+
+
+def minify_css(source):
+    # Strings are rare in style.css but kept verbatim all the same
+    parts = re.split(r'("(?:[^"\\]|\\.)*"|\'(?:[^\'\\]|\\.)*\')', source)
+    for index in range(0, len(parts), 2):
+        text = re.sub(r"/\*.*?\*/", "", parts[index], flags=re.S)
+        text = re.sub(r"\s+", " ", text)
+        text = re.sub(r"\s*([{};,>])\s*", r"\1", text)
+        text = re.sub(r":\s+", ":", text)
+        parts[index] = text.replace(";}", "}")
+    return "".join(parts).strip() + "\n"
+
+
+def minify_html(source):
+    # Indentation and comments only: a line break still separates inline elements
+    source = re.sub(r"<!--.*?-->", "", source, flags=re.S)
+    return re.sub(r"\s*\n\s*", "\n", source).strip() + "\n"
+
+
+def minify(path, data):
+    ext = os.path.splitext(path)[1]
+    if ext == ".js":
+        return minify_js(data.decode("utf-8")).encode("utf-8")
+    if ext == ".css":
+        return minify_css(data.decode("utf-8")).encode("utf-8")
+    if ext == ".json":
+        return json.dumps(json.loads(data), ensure_ascii=False, separators=(",", ":")).encode("utf-8")
+    return data
+
+
+# --------------------------------------------------------------- references
+
+def asset_references(text, names):
+    # Quoted, root-relative references to other assets: src="/app.js", '/scan.js'
+    return {match.group(2) for match in re.finditer(r'(["\'])(/[^"\'?#]+)\1', text)
+            if match.group(2) in names}
+
+
+def rewrite_references(text, renamed, hashes):
+    # Hashed files by their new name, everything else as /file?v=<hash>
+    def replace(match):
+        quote, path = match.group(1), match.group(2)
+        if path in renamed:
+            return quote + renamed[path] + quote
+        if path in hashes:
+            return "%s%s?v=%s%s" % (quote, path, hashes[path], quote)
+        return match.group(0)
+
+    return re.sub(r'(["\'])(/[^"\'?#]+)\1', replace, text)
+
+
+def inline_translations(html, language, strings):
+    # <script>window.INLINE_TRANSLATIONS=...</script> ahead of the page scripts
+    payload = json.dumps({"lang": language, "strings": strings}, ensure_ascii=False,
+                         separators=(",", ":")).replace("</", "<\\/")
+    html = re.sub(r'<html lang="[^"]*"', '<html lang="%s"' % language, html, count=1)
+    tag = "<script>window.INLINE_TRANSLATIONS=%s</script>\n" % payload
+    position = html.find("<script")
+    if position < 0:
+        position = html.find("</body>")
+    return html[:position] + tag + html[position:]
+
+
+# ------------------------------------------------------------------ staging
+
+def stage_data(source_dir, target_dir):
+    if os.path.isdir(target_dir):
+        shutil.rmtree(target_dir)
+
+    sources = {}
+    for root, _, names in os.walk(source_dir):
+        for name in names:
+            full_path = os.path.join(root, name)
+            rel_path = "/" + os.path.relpath(full_path, source_dir).replace(os.sep, "/")
+            with open(full_path, "rb") as handle:
+                sources[rel_path] = handle.read()
+
+    files = {path: minify(path, data) for path, data in sources.items()}
+    manifest = {}
+    renamed = {}
+    hashes = {}
+
+    # Plain assets first, then scripts and stylesheets once everything they
+    # reference has its final name, then the pages on top of all of them
+    for path, data in files.items():
+        if os.path.splitext(path)[1] not in HASHED_NAMES and not path.endswith(".html"):
+            hashes[path] = content_hash(data)
+            manifest[path] = {"hash": hashes[path]}
+
+    pending = {path for path in files if os.path.splitext(path)[1] in HASHED_NAMES}
+    while pending:
+        ready = [path for path in sorted(pending)
+                 if not (asset_references(files[path].decode("utf-8"), pending) - {path})]
+        if not ready:
+            raise ValueError("circular asset references: %s" % ", ".join(sorted(pending)))
+        for path in ready:
+            data = rewrite_references(files.pop(path).decode("utf-8"), renamed, hashes).encode("utf-8")
+            digest = content_hash(data)
+            renamed[path] = hashed_name(path, digest)
+            files[renamed[path]] = data
+            hashes[renamed[path]] = digest
+            manifest[renamed[path]] = {"hash": digest, "immutable": True, "src": path}
+            pending.discard(path)
+
+    languages = {}
+    for path, data in files.items():
+        if path.startswith(TRANSLATIONS_DIR) and path.endswith(".json"):
+            languages[os.path.splitext(os.path.basename(path))[0]] = json.loads(data)
+
+    for path in [p for p in files if p.endswith(".html")]:
+        html = minify_html(rewrite_references(files[path].decode("utf-8"), renamed, hashes))
+        variants = [language for language in sorted(languages) if language != DEFAULT_LANGUAGE]
+        for language in variants:
+            name = variant_name(path, language)
+            files[name] = inline_translations(html, language, languages[language]).encode("utf-8")
+            hashes[name] = content_hash(files[name])
+            manifest[name] = {"hash": hashes[name], "src": path}
+        if DEFAULT_LANGUAGE in languages:
+            html = inline_translations(html, DEFAULT_LANGUAGE, languages[DEFAULT_LANGUAGE])
+        files[path] = html.encode("utf-8")
+        hashes[path] = content_hash(files[path])
+        manifest[path] = {"hash": hashes[path], "lang": DEFAULT_LANGUAGE}
+        if variants:
+            manifest[path]["variants"] = variants
+
+    original_bytes = sum(len(data) for data in sources.values())
+    staged_bytes = 0
+    transfer = {}
+    for path, data in sorted(files.items()):
+        out_path = os.path.join(target_dir, path.lstrip("/"))
+        os.makedirs(os.path.dirname(out_path), exist_ok=True)
+        with open(out_path, "wb") as handle:
+            handle.write(data)
+
+        staged_bytes += len(data)
+        transfer[path] = len(data)
+        if os.path.splitext(path)[1] in COMPRESSIBLE:
+            compressed = gzip.compress(data, compresslevel=9, mtime=0)
+            if len(compressed) < len(data):
+                with open(out_path + ".gz", "wb") as handle:
+                    handle.write(compressed)
+                manifest[path]["gz"] = True
+                staged_bytes += len(compressed)
+                transfer[path] = len(compressed)
+                print("  %-28s %7d -> %6d bytes gzip" % (path, len(data), len(compressed)))
+
+    with open(os.path.join(target_dir, MANIFEST_NAME), "w") as handle:
+        json.dump(manifest, handle, separators=(",", ":"), sort_keys=True)
+
+    # What the dashboard needs before the status shows: the page and what it loads itself
+    first_paint = transfer["/index.html"] if "/index.html" in transfer else 0
+    if first_paint:
+        for reference in asset_references(files["/index.html"].decode("utf-8"), set(files)):
+            first_paint += transfer[reference]
+
+    print("Web assets staged in %s (%d files, %d -> %d bytes incl. gzip copies, first paint %d bytes)"
+          % (target_dir, len(manifest), original_bytes, staged_bytes, first_paint))
+
+
+if FS_TARGETS.intersection(COMMAND_LINE_TARGETS):  # noqa: F821 - provided by PlatformIO
+    source = env.subst("$PROJECT_DATA_DIR")
+    staged = os.path.join(env.subst("$BUILD_DIR"), "data")
+    stage_data(source, staged)
+    env.Replace(PROJECT_DATA_DIR=staged)
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+Host-side load test for the web UI endpoints.
+
+Runs a number of concurrent clients against the ESP32 for a fixed time, each
+requesting the configured endpoints round-robin, and reports throughput and
+latency percentiles per endpoint. Optionally runs the on-device benchmark
+(POST /api/bench) first and prints its report.
+
+    python3 scripts/loadtest.py 192.168.4.1 --clients 4 --duration 30
+    python3 scripts/loadtest.py wifi-manager.local --bench 20 --json report.json
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import http.client
+import json
+import threading
+import time
+from collections import defaultdict
+
+DEFAULT_ENDPOINTS = [
+    "/api/status",
+    "/api/config",
+    "/api/scan/networks",
+    "/api/scan/result",
+    "/",
+    "/app.js",
+]
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0.0
+    index = max(0, min(len(sorted_values) - 1, (len(sorted_values) * pct + 99) // 100 - 1))
+    return sorted_values[index]
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = defaultdict(list)
+        self.codes = defaultdict(lambda: defaultdict(int))
+        self.bytes = defaultdict(int)
+        self.errors = defaultdict(int)
+
+    def record(self, path, seconds, code, size):
+        with self.lock:
+            self.latencies[path].append(seconds * 1000.0)
+            self.codes[path][code] += 1
+            self.bytes[path] += size
+
+    def error(self, path):
+        with self.lock:
+            self.errors[path] += 1
+
+
+def client_worker(host, port, endpoints, offset, deadline, stats, timeout, keep_alive):
+    connection = None
+    index = offset
+    while time.monotonic() < deadline:
+        path = endpoints[index % len(endpoints)]
+        index += 1
+        if connection is None:
+            connection = http.client.HTTPConnection(host, port, timeout=timeout)
+        started = time.monotonic()
+        try:
+            connection.request("GET", path, headers={"Accept-Encoding": "gzip"})
+            response = connection.getresponse()
+            body = response.read()
+            stats.record(path, time.monotonic() - started, response.status, len(body))
+            if not keep_alive or response.getheader("Connection", "").lower() == "close":
+                connection.close()
+                connection = None
+        except (OSError, http.client.HTTPException):
+            stats.error(path)
+            if connection is not None:
+                connection.close()
+            connection = None
+            time.sleep(0.2)
+    if connection is not None:
+        connection.close()
+
+
+def run_bench(host, port, iterations, tests, timeout):
+    query = "iterations=%d" % iterations
+    if tests:
+        query += "&tests=" + tests
+    connection = http.client.HTTPConnection(host, port, timeout=timeout)
+    connection.request("POST", "/api/bench?" + query, body=b"")
+    response = connection.getresponse()
+    report = json.loads(response.read().decode("utf-8") or "{}")
+    connection.close()
+    if response.status != 200:
+        raise SystemExit("bench failed: HTTP %d %s" % (response.status, report))
+    return report
+
+
+def print_bench(report):
+    print("On-device benchmark (%d iterations)" % report.get("iterations", 0))
+    print("  %-10s %8s %8s %8s %8s %9s %6s" % ("test", "min ms", "median", "p99", "max", "bytes", "fail"))
+    for name, result in report.get("tests", {}).items():
+        if "skipped" in result:
+            print("  %-10s skipped (%s)" % (name, result["skipped"]))
+            continue
+        print("  %-10s %8.1f %8.1f %8.1f %8.1f %9d %6d" % (
+            name, result["min_ms"], result["median_ms"], result["p99_ms"], result["max_ms"],
+            result["bytes"], result["failures"]))
+    heap = report.get("heap", {})
+    print("  heap: %d free before, low-water %d, %d since boot" % (
+        heap.get("before", 0), heap.get("low_water", 0), heap.get("min_since_boot", 0)))
+    print()
+
+
+def summarize(stats, elapsed):
+    summary = {}
+    for path in sorted(set(stats.latencies) | set(stats.errors)):
+        values = sorted(stats.latencies[path])
+        summary[path] = {
+            "requests": len(values),
+            "errors": stats.errors[path],
+            "rps": len(values) / elapsed if elapsed > 0 else 0.0,
+            "bytes": stats.bytes[path],
+            "median_ms": percentile(values, 50),
+            "p99_ms": percentile(values, 99),
+            "max_ms": values[-1] if values else 0.0,
+            "codes": dict(stats.codes[path]),
+        }
+    return summary
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load-test the WiFi manager web UI")
+    parser.add_argument("host", help="ESP32 IP address or hostname")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--clients", type=int, default=4, help="concurrent clients (default 4)")
+    parser.add_argument("--duration", type=float, default=20.0, help="seconds to run (default 20)")
+    parser.add_argument("--endpoints", default=",".join(DEFAULT_ENDPOINTS),
+                        help="comma-separated paths, requested round-robin")
+    parser.add_argument("--timeout", type=float, default=10.0, help="per-request timeout in seconds")
+    parser.add_argument("--no-keep-alive", action="store_true", help="open a new connection per request")
+    parser.add_argument("--bench", type=int, metavar="N", help="run POST /api/bench with N iterations first")
+    parser.add_argument("--bench-tests", default="", help="tests for --bench (default: all)")
+    parser.add_argument("--json", metavar="FILE", help="also write the report as JSON")
+    args = parser.parse_args()
+
+    report = {}
+    if args.bench:
+        report["bench"] = run_bench(args.host, args.port, args.bench, args.bench_tests, timeout=600)
+        print_bench(report["bench"])
+
+    endpoints = [path.strip() for path in args.endpoints.split(",") if path.strip()]
+    stats = Stats()
+    started = time.monotonic()
+    deadline = started + args.duration
+    threads = [
+        threading.Thread(target=client_worker,
+                         args=(args.host, args.port, endpoints, i, deadline, stats,
+                               args.timeout, not args.no_keep_alive),
+                         daemon=True)
+        for i in range(args.clients)
+    ]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - started
+
+    summary = summarize(stats, elapsed)
+    total = sum(entry["requests"] for entry in summary.values())
+    errors = sum(entry["errors"] for entry in summary.values())
+    print("Load test: %d clients, %.1f s, %d requests (%.1f req/s), %d errors" % (
+        args.clients, elapsed, total, total / elapsed if elapsed > 0 else 0.0, errors))
+    print("  %-22s %7s %7s %9s %8s %8s %8s  codes" % ("endpoint", "reqs", "req/s", "bytes", "median", "p99", "max"))
+    for path, entry in summary.items():
+        codes = " ".join("%s:%d" % (code, count) for code, count in sorted(entry["codes"].items()))
+        print("  %-22s %7d %7.1f %9d %8.1f %8.1f %8.1f  %s%s" % (
+            path, entry["requests"], entry["rps"], entry["bytes"], entry["median_ms"], entry["p99_ms"],
+            entry["max_ms"], codes, "  errors:%d" % entry["errors"] if entry["errors"] else ""))
+
+    if args.json:
+        report["load"] = {"clients": args.clients, "duration_s": elapsed, "requests": total,
+                          "errors": errors, "endpoints": summary}
+        with open(args.json, "w") as handle:
+            json.dump(report, handle, indent=2, sort_keys=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -18,41 +18,124 @@
 #include <ArduinoJson.h>
 #include <base64.h>
 #include <LittleFS.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <limits.h>
+#include <stdarg.h>
 
 // Load configuration from separate header
 #include "config.h"
+#include "JsonWriter.h"
+#include "RouterValues.h"
+#include "ScanTable.h"
+#include "SignalHistory.h"
+#include "StatusDigest.h"
 
 // ==================== CONSTANTS ====================
 
 const char* PROFILE_COMMENT_PREFIX = "wifi-manager:ssid=";
 
-const char* CONFIG_FILE_PATH = "/config.json";
+const char* CONFIG_FILE_PATH = "/config.bin";
+const char* CONFIG_TEMP_PATH = "/config.bin.tmp";
+const char* CONFIG_JSON_PATH = "/config.json";                 // Imported at boot (earlier builds, uploadfs)
+const unsigned long CONFIG_SAVE_DELAY_MS = 5000;                // Settings are written once edits pause this long
+const unsigned long CONFIG_SAVE_MAX_DELAY_MS = 30000;           // ...or at the latest this long after the first edit
+const char* ASSET_MANIFEST_PATH = "/assets.json";
 const char* CAPTIVE_PORTAL_SSID = "MikroTikSetup";
-const unsigned long WIFI_INITIAL_CONNECT_TIMEOUT_MS = 10000;
+const unsigned long WIFI_INITIAL_CONNECT_TIMEOUT_MS = 10000;  // STA tries this long before the setup AP comes up
 const unsigned long WIFI_RECONNECT_INTERVAL_MS = 30000;
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT_MS = 3000;      // Direct connect to the cached AP before scanning instead
+const unsigned long SERIAL_WAIT_MS = 0;                       // Wait this long for a USB serial monitor at boot
+const uint32_t FTP_CONNECT_TIMEOUT_MS = 1000;
+const unsigned long FTP_REPLY_TIMEOUT_MS = 2000;
+const unsigned long FTP_TRANSFER_TIMEOUT_MS = 8000;
+
+// A router/interface pair managed by the dashboard (see ROUTER TARGETS)
+struct RouterTargetConfig {
+  String name;
+  String ip;
+  String user;
+  String pass;
+  String wlanInterface;
+  String secondInterface;  // Second radio for dual-band scans ("" = none)
+};
 
 struct RuntimeConfig {
   String wifiSsid;
   String wifiPassword;
+  String wifiBssid;   // AP of the last connection, for a connect without scan
+  int wifiChannel;
   String mikrotikIp;
   String mikrotikUser;
   String mikrotikPass;
   String mikrotikWlanInterface;
+  String mikrotikSecondInterface;
   String band2ghz;
   String band5ghz;
   String channelWidth2ghz;
   String channelWidth5ghz;
   int scanDurationSeconds;
+  String scanMode;
   bool stationRoaming;
+  std::vector<RouterTargetConfig> extraTargets;  // Targets 1.. (target 0 is mikrotik* above)
 };
 
 RuntimeConfig runtimeConfig;
+uint32_t routerTargetsGeneration = 1;  // Bumped whenever a target's settings change
+
+const char* PRIMARY_TARGET_NAME = "main";
+
+size_t routerTargetCount() {
+  size_t count = 1 + runtimeConfig.extraTargets.size();
+  return count < ROUTER_TARGETS_MAX ? count : ROUTER_TARGETS_MAX;
+}
+
+// Settings of target `index` (< routerTargetCount()); call under SharedStateLock
+RouterTargetConfig routerTargetConfigAt(size_t index) {
+  if (index > 0) {
+    return runtimeConfig.extraTargets[index - 1];
+  }
+  RouterTargetConfig config;
+  config.name = PRIMARY_TARGET_NAME;
+  config.ip = runtimeConfig.mikrotikIp;
+  config.user = runtimeConfig.mikrotikUser;
+  config.pass = runtimeConfig.mikrotikPass;
+  config.wlanInterface = runtimeConfig.mikrotikWlanInterface;
+  config.secondInterface = runtimeConfig.mikrotikSecondInterface;
+  return config;
+}
+
+// A request answered later (router task, event stream) keeps its own copy of
+// the client. handleClient() only accepts the next connection once its own
+// copy is disconnected, and otherwise waits up to HTTP_MAX_CLOSE_WAIT per
+// request in HC_WAIT_CLOSE.
+class AppWebServer : public WebServer {
+ public:
+  using WebServer::WebServer;
+
+  // WiFiClient::stop() only drops this copy's socket handle: the socket stays
+  // open for the returned client and closes with its last copy
+  WiFiClient detachClient() {
+    WiFiClient client = _currentClient;
+    _currentClient.stop();
+    return client;
+  }
+};
 
-WebServer server(WEB_PORT);
+AppWebServer server(WEB_PORT);
 
 bool captivePortalActive = false;
 bool wifiReconnectPending = false;
 unsigned long lastReconnectAttempt = 0;
+unsigned long wifiDownSince = 0;          // Start of the current outage (or boot)
+bool wifiUseCachedAp = true;              // Next attempt may go straight to the cached BSSID/channel
+bool wifiAttemptFast = false;             // Current attempt is such a direct connect
+volatile bool wifiConnectFailed = false;  // Set by the WiFi event handler when an attempt ends without a link
 bool filesystemAvailable = false;
 
 bool otaServiceReady = false;
@@ -62,23 +145,499 @@ struct ScanState {
   bool isScanning = false;
   bool hasResult = false;
   String result = "";
+  String resultEtag = "";
+  uint32_t resultHash = 0;
   unsigned long startTime = 0;
   unsigned long resultTimestamp = 0;
   String band = "";
   String csvFilename = "";
+  String interfaceId = "";
+  bool restMode = false;
+  bool background = false;         // Started by the scan scheduler, not a client
+  bool benchmark = false;          // Re-download for /api/bench: the result store is left alone
+  bool triggerPending = false;     // Save-file scan not yet sent (band switch settling)
+  // Dual-radio scan: the other configured band, scanned at the same time on
+  // the other radio and downloaded first into that band's store
+  String companionBand = "";
+  String companionInterfaceId = "";
+  String companionCsvFilename = "";
+  bool companionPending = false;   // Companion save-file not downloaded yet
+  unsigned long triggerAt = 0;
+  unsigned long lastScanDurationMs = 0;
   unsigned long expectedDurationMs = 0;
   unsigned long minReadyMs = 0;
   unsigned long resultTimeoutMs = 0;
   unsigned long pollIntervalMs = 0;
+  String errorStatus = "";
+  String error = "";
+  unsigned long cacheHits = 0;
+  unsigned long notModifiedCount = 0;
+};
+
+ScanState& scanState();  // Per target, see ROUTER TARGETS
+
+// ==================== METRICS ====================
+
+// Counters and latency histograms for /api/metrics (JSON or Prometheus text).
+// Everything is preallocated; recording is a few increments inside a
+// critical section, so it is cheap enough for every request and loop pass.
+const uint32_t METRIC_BUCKETS_US[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+                                      100000, 250000, 500000, 1000000, 2500000, 5000000};
+const size_t METRIC_BUCKET_COUNT = sizeof(METRIC_BUCKETS_US) / sizeof(METRIC_BUCKETS_US[0]);
+
+struct LatencyHistogram {
+  uint32_t buckets[METRIC_BUCKET_COUNT + 1] = {};  // Last bucket: above the largest bound
+  uint32_t count = 0;
+  uint64_t sumUs = 0;
+  uint32_t maxUs = 0;
+};
+
+struct EndpointMetric {
+  const char* name = nullptr;
+  LatencyHistogram latency;
+};
+
+struct RouterPathMetric {
+  char key[48] = "";  // "GET /interface/wireless/{id}"
+  LatencyHistogram latency;
+  uint32_t failures = 0;
+};
+
+struct ScanMetrics {
+  LatencyHistogram connect;   // FTP control connection setup
+  LatencyHistogram transfer;  // CSV download / REST scan body
+  uint64_t bytes = 0;
+  uint32_t completed = 0;
+  uint32_t failed = 0;
+};
+
+EndpointMetric endpointMetrics[METRICS_MAX_ENDPOINTS];
+RouterPathMetric routerPathMetrics[METRICS_MAX_ROUTER_PATHS];
+ScanMetrics scanMetrics;
+LatencyHistogram loopMetrics;
+portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+
+EndpointMetric* currentEndpointMetric = nullptr;  // Request being handled on loop()
+unsigned long currentEndpointStartUs = 0;
+
+// Call inside portENTER_CRITICAL(&metricsMux)
+void metricsAddSample(LatencyHistogram& histogram, uint32_t us) {
+  size_t bucket = 0;
+  while (bucket < METRIC_BUCKET_COUNT && us > METRIC_BUCKETS_US[bucket]) bucket++;
+  histogram.buckets[bucket]++;
+  histogram.count++;
+  histogram.sumUs += us;
+  if (us > histogram.maxUs) histogram.maxUs = us;
+}
+
+void metricsRecord(LatencyHistogram& histogram, uint32_t us) {
+  portENTER_CRITICAL(&metricsMux);
+  metricsAddSample(histogram, us);
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+// One finished scan download: transfer time, bytes and (for the requested
+// band, not the companion radio) the completed count, updated together
+void metricsRecordScan(uint32_t transferUs, uint32_t bytes, bool completed) {
+  portENTER_CRITICAL(&metricsMux);
+  metricsAddSample(scanMetrics.transfer, transferUs);
+  scanMetrics.bytes += bytes;
+  if (completed) scanMetrics.completed++;
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+void metricsRecordScanFailure() {
+  portENTER_CRITICAL(&metricsMux);
+  scanMetrics.failed++;
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+// Consistent copy for reporting (the 64-bit byte counter cannot be read in one access)
+ScanMetrics metricsScanSnapshot() {
+  portENTER_CRITICAL(&metricsMux);
+  ScanMetrics copy = scanMetrics;
+  portEXIT_CRITICAL(&metricsMux);
+  return copy;
+}
+
+// Registered once per route at setup; the last slot collects what does not fit
+EndpointMetric* metricsEndpoint(const char* name) {
+  for (size_t i = 0; i + 1 < METRICS_MAX_ENDPOINTS; i++) {
+    EndpointMetric& metric = endpointMetrics[i];
+    if (metric.name == nullptr) {
+      metric.name = name;
+      return &metric;
+    }
+    if (strcmp(metric.name, name) == 0) {
+      return &metric;
+    }
+  }
+  EndpointMetric& other = endpointMetrics[METRICS_MAX_ENDPOINTS - 1];
+  other.name = "other";
+  return &other;
+}
+
+// RouterOS round trip, keyed by method and path with ids ("*3") and query stripped
+void metricsRecordRouter(const char* method, const char* path, uint32_t us, bool failed) {
+  char key[sizeof(RouterPathMetric::key)];
+  size_t length = snprintf(key, sizeof(key), "%s ", method);
+  for (const char* p = path; *p != '\0' && *p != '?' && length < sizeof(key) - 1; p++) {
+    if (*p == '*' && p > path && p[-1] == '/') {
+      length += snprintf(key + length, sizeof(key) - length, "{id}");
+      while (p[1] != '\0' && p[1] != '/' && p[1] != '?') p++;
+      continue;
+    }
+    key[length++] = *p;
+  }
+  key[min(length, sizeof(key) - 1)] = '\0';
+
+  // Lookup or claim, sample and failure count in one critical section:
+  // router tasks of different targets record concurrently
+  portENTER_CRITICAL(&metricsMux);
+  // The last slot collects whatever does not fit
+  RouterPathMetric* slot = &routerPathMetrics[METRICS_MAX_ROUTER_PATHS - 1];
+  for (size_t i = 0; i + 1 < METRICS_MAX_ROUTER_PATHS; i++) {
+    RouterPathMetric& metric = routerPathMetrics[i];
+    if (metric.key[0] == '\0') {
+      strncpy(metric.key, key, sizeof(metric.key) - 1);
+      slot = &metric;
+      break;
+    }
+    if (strcmp(metric.key, key) == 0) {
+      slot = &metric;
+      break;
+    }
+  }
+  if (slot->key[0] == '\0') {
+    strncpy(slot->key, "other", sizeof(slot->key) - 1);
+  }
+  metricsAddSample(slot->latency, us);
+  if (failed) slot->failures++;
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+// Consistent copy of router path slot `index` for reporting (key "" when unused)
+RouterPathMetric metricsRouterSnapshot(size_t index) {
+  portENTER_CRITICAL(&metricsMux);
+  RouterPathMetric copy = routerPathMetrics[index];
+  portEXIT_CRITICAL(&metricsMux);
+  return copy;
+}
+
+// Route wrapper: times the handler. Requests handed to the router task are
+// recorded when they are answered there (see deferToRouterTask()).
+std::function<void()> metered(const char* name, std::function<void()> handler) {
+  EndpointMetric* metric = metricsEndpoint(name);
+  return [metric, handler]() {
+    currentEndpointMetric = metric;
+    currentEndpointStartUs = micros();
+    handler();
+    if (currentEndpointMetric != nullptr) {
+      metricsRecord(metric->latency, micros() - currentEndpointStartUs);
+    }
+    currentEndpointMetric = nullptr;
+  };
+}
+
+// ==================== API REQUEST CONTEXT ====================
+
+// With ROUTER_TASK_ENABLED all RouterOS traffic runs on the router I/O task
+// while loop() keeps serving static files, cached endpoints and OTA. A request
+// whose handler talks to the router is captured (client socket + arguments)
+// and answered later from that task, so those handlers use apiArg()/apiSend()
+// instead of the WebServer directly.
+struct DeferredRequest {
+  WiFiClient client;
+  void (*handler)() = nullptr;
+  std::vector<std::pair<String, String>> args;
+  String ifNoneMatch;
+  std::vector<std::pair<String, String>> responseHeaders;
+  unsigned long queuedAt = 0;
+  bool responded = false;
+  EndpointMetric* metric = nullptr;  // Recorded once the router task has answered
+  unsigned long startedUs = 0;
+  String coalesceKey;                // Set while identical GETs can still join (see deferToRouterTask())
+  std::vector<WiFiClient> followers;  // Their clients, answered with the same response
+};
+
+// One router I/O task per configured target (see ROUTER TARGETS), so a slow
+// or unreachable router only stalls its own queue
+struct RouterTaskSlot {
+  TaskHandle_t handle = nullptr;
+  QueueHandle_t queue = nullptr;  // RouterCommand*, consumed by this target's task
+  unsigned long processed = 0;
+  unsigned long rejected = 0;
+  unsigned long coalesced = 0;    // Requests answered with another queued request's response
+  unsigned long maxWaitMs = 0;
+  unsigned long maxRunMs = 0;
+  const char* lastCommand = "";
+  DeferredRequest* activeRequest = nullptr;  // Set while the task runs a handler
+  bool stackWarned = false;
+};
+
+RouterTaskSlot routerTasks[ROUTER_TARGETS_MAX];
+QueueHandle_t routerCompletionQueue = nullptr;  // RouterCommand* with a done callback, consumed by loop()
+bool routerTaskPaused = false;                  // Background work suspended (OTA in progress)
+size_t loopTargetIndex = 0;                     // Target of the loop() code currently running, see TargetScope
+std::vector<DeferredRequest*> joinableRequests; // Queued GETs that have not answered yet (SharedStateLock)
+
+// Index of the target whose router task is calling, or -1 from loop()
+int routerTaskIndex() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  for (size_t i = 0; i < ROUTER_TARGETS_MAX; i++) {
+    if (routerTasks[i].handle != nullptr && routerTasks[i].handle == self) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+// Router tasks always act on their own target; loop() on the one selected by
+// the request (?target=) or event client it is serving
+size_t currentTargetIndex() {
+  int task = routerTaskIndex();
+  return task >= 0 ? static_cast<size_t>(task) : loopTargetIndex;
+}
+
+class TargetScope {
+ public:
+  explicit TargetScope(size_t index) : previous_(loopTargetIndex) { loopTargetIndex = index; }
+  ~TargetScope() { loopTargetIndex = previous_; }
+  TargetScope(const TargetScope&) = delete;
+  TargetScope& operator=(const TargetScope&) = delete;
+
+ private:
+  size_t previous_;
 };
 
-ScanState scanState;
+DeferredRequest* activeDeferredRequest() {
+  int task = routerTaskIndex();
+  return task >= 0 ? routerTasks[task].activeRequest : nullptr;
+}
+
+// Guards state shared between loop() handlers and the router task
+// (status cache, scan state/table, runtime config)
+SemaphoreHandle_t sharedStateMutex = nullptr;
+
+struct SharedStateLock {
+  SharedStateLock() {
+    if (sharedStateMutex != nullptr) xSemaphoreTakeRecursive(sharedStateMutex, portMAX_DELAY);
+  }
+  ~SharedStateLock() {
+    if (sharedStateMutex != nullptr) xSemaphoreGiveRecursive(sharedStateMutex);
+  }
+};
+
+// ==================== SCRATCH ARENA ====================
+
+// Short-lived text (response heads, event frames, URLs) is carved from a
+// static per-task buffer instead of the heap, so days of requests do not
+// fragment it. A ScratchScope hands out memory and releases everything it
+// took when it goes out of scope; scopes nest. If the arena is exhausted the
+// scope falls back to malloc (counted as overflow in /api/diagnostics).
+struct ScratchArena {
+  char buffer[SCRATCH_ARENA_SIZE];
+  size_t used = 0;
+  size_t highWater = 0;
+  unsigned long overflows = 0;
+};
+
+ScratchArena scratchArenas[1 + ROUTER_TARGETS_MAX];  // [0] loop(), [1 + i] router task of target i
+
+ScratchArena& currentScratchArena() {
+  return scratchArenas[1 + routerTaskIndex()];
+}
+
+class ScratchScope {
+ public:
+  ScratchScope() : arena_(currentScratchArena()), mark_(arena_.used) {}
+  ~ScratchScope() {
+    arena_.used = mark_;
+    while (heapBlocks_ != nullptr) {
+      HeapBlock* next = heapBlocks_->next;
+      free(heapBlocks_);
+      heapBlocks_ = next;
+    }
+  }
+  ScratchScope(const ScratchScope&) = delete;
+  ScratchScope& operator=(const ScratchScope&) = delete;
+
+  char* alloc(size_t size) {
+    size = (size + 3) & ~static_cast<size_t>(3);
+    if (arena_.used + size <= sizeof(arena_.buffer)) {
+      char* block = arena_.buffer + arena_.used;
+      arena_.used += size;
+      if (arena_.used > arena_.highWater) arena_.highWater = arena_.used;
+      return block;
+    }
+    arena_.overflows++;
+    HeapBlock* block = static_cast<HeapBlock*>(malloc(sizeof(HeapBlock) + size));
+    if (block == nullptr) {
+      return nullptr;
+    }
+    block->next = heapBlocks_;
+    heapBlocks_ = block;
+    return reinterpret_cast<char*>(block + 1);
+  }
+
+  // printf into scratch memory; lengthOut receives the formatted length
+  const char* format(size_t& lengthOut, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(nullptr, 0, fmt, args);
+    va_end(args);
+    lengthOut = 0;
+    if (length < 0) {
+      return "";
+    }
+    char* out = alloc(static_cast<size_t>(length) + 1);
+    if (out == nullptr) {
+      return "";
+    }
+    va_start(args, fmt);
+    vsnprintf(out, static_cast<size_t>(length) + 1, fmt, args);
+    va_end(args);
+    lengthOut = static_cast<size_t>(length);
+    return out;
+  }
+
+ private:
+  struct HeapBlock {
+    HeapBlock* next;
+  };
+  ScratchArena& arena_;
+  size_t mark_;
+  HeapBlock* heapBlocks_ = nullptr;
+};
+
+bool onRouterTask() {
+  return activeDeferredRequest() != nullptr;
+}
+
+String apiArg(const char* name) {
+  if (!onRouterTask()) {
+    return server.arg(name);
+  }
+  for (const auto& arg : activeDeferredRequest()->args) {
+    if (arg.first == name) {
+      return arg.second;
+    }
+  }
+  return "";
+}
+
+bool apiHasArg(const char* name) {
+  if (!onRouterTask()) {
+    return server.hasArg(name);
+  }
+  for (const auto& arg : activeDeferredRequest()->args) {
+    if (arg.first == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Percent-encode a value for a RouterOS query string ("guest net&5" -> "guest%20net%265")
+String urlEncode(const String& value) {
+  static const char hex[] = "0123456789ABCDEF";
+  String encoded;
+  encoded.reserve(value.length());
+  for (size_t i = 0; i < value.length(); i++) {
+    uint8_t c = static_cast<uint8_t>(value[i]);
+    if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      encoded += static_cast<char>(c);
+    } else {
+      encoded += '%';
+      encoded += hex[c >> 4];
+      encoded += hex[c & 0x0F];
+    }
+  }
+  return encoded;
+}
+
+// Only If-None-Match is captured for deferred requests
+String apiIfNoneMatch() {
+  if (!onRouterTask()) {
+    return server.hasHeader("If-None-Match") ? server.header("If-None-Match") : "";
+  }
+  return activeDeferredRequest()->ifNoneMatch;
+}
+
+void apiSendHeader(const String& name, const String& value) {
+  if (!onRouterTask()) {
+    server.sendHeader(name, value);
+    return;
+  }
+  activeDeferredRequest()->responseHeaders.push_back({name, value});
+}
+
+const char* httpStatusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+  }
+  return "";
+}
+
+// Write a complete response to a captured client, and to the clients of the
+// identical requests coalesced into it, and close them
+void deferredRespond(DeferredRequest& request, int code, const char* contentType, const String& body) {
+  if (request.coalesceKey.length() > 0) {
+    SharedStateLock lock;
+    joinableRequests.erase(std::remove(joinableRequests.begin(), joinableRequests.end(), &request),
+                           joinableRequests.end());
+  }
+
+  ScratchScope scratch;
+  String head;
+  size_t length = 0;
+  head += scratch.format(length, "HTTP/1.1 %d %s\r\nContent-Length: %u\r\n", code, httpStatusText(code),
+                         static_cast<unsigned>(body.length()));
+  if (contentType != nullptr) {
+    head += scratch.format(length, "Content-Type: %s\r\n", contentType);
+  }
+  for (const auto& header : request.responseHeaders) {
+    head += scratch.format(length, "%s: %s\r\n", header.first.c_str(), header.second.c_str());
+  }
+  head += "Connection: close\r\n\r\n";
+
+  auto respond = [&](WiFiClient& client) {
+    client.write(reinterpret_cast<const uint8_t*>(head.c_str()), head.length());
+    if (body.length() > 0) {
+      client.write(reinterpret_cast<const uint8_t*>(body.c_str()), body.length());
+    }
+    client.stop();
+  };
+  respond(request.client);
+  for (WiFiClient& follower : request.followers) {
+    respond(follower);
+  }
+  request.responded = true;
+}
+
+void apiSend(int code, const char* contentType = nullptr, const String& body = String()) {
+  if (!onRouterTask()) {
+    server.send(code, contentType, body);
+    return;
+  }
+  deferredRespond(*activeDeferredRequest(), code, contentType, body);
+}
 
 // ==================== HELPER FUNCTIONS ====================
 
 void applyDefaultConfig(RuntimeConfig& cfg);
-bool loadRuntimeConfigFromFile();
-bool saveRuntimeConfigToFile();
+bool loadRuntimeConfig();
+bool flushConfig();
+void markConfigDirty();
 void attemptWifiConnect();
 void startCaptivePortal();
 void stopCaptivePortal();
@@ -90,66 +649,336 @@ void setupArduinoOTA();
 void handleSettingsGet();
 void handleSettingsUpdate();
 void handleDeleteProfile();
+void scanFetcherReset();
+bool mikrotikGetFiltered(const String& path, JsonDocument& doc, JsonDocument& filter);
+bool deferToRouterTask(void (*handler)());
+void runOnLoop(std::function<void()> fn);
+void handleStatusCacheTasks();
+void handleScanFetchTasks();
+void describeScanProgress(JsonDocument& doc);
+const RouterTargetConfig& targetConfig();
+void routerTargetSync();
+String targetScanFilename();
+String scanFilenameFor(const String& interfaceName);
+void describeScanScheduler(JsonObject obj);
+bool scanFileStamp(const String& filename, String& stampOut);
+void scanFetcherArmProbe(bool enabled, const String& baselineStamp);
+
+// "ftp": save-file + FTP download (detects encryption); "rest": read the REST scan response directly
+bool isValidScanMode(const String& mode) {
+  return mode == "ftp" || mode == "rest";
+}
+
+uint32_t fnv1aHash(const char* data, size_t length, uint32_t hash = 2166136261UL) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+String makeEtag(uint32_t hash, const char* suffix = "") {
+  char etag[24];
+  snprintf(etag, sizeof(etag), "\"%08lx%s\"", static_cast<unsigned long>(hash), suffix);
+  return String(etag);
+}
 
-bool asBool(String value) {
-  value.toLowerCase();
-  value.trim();
-  return (value == "true" || value == "yes" || value == "on" ||
-          value == "1" || value == "running" || value == "enabled");
+// True when the client's If-None-Match already names this entity
+bool clientHasEtag(const String& etag) {
+  String ifNoneMatch = apiIfNoneMatch();
+  return ifNoneMatch.length() > 0 && ifNoneMatch.indexOf(etag) >= 0;
 }
 
 void applyDefaultConfig(RuntimeConfig& cfg) {
   cfg.wifiSsid = WIFI_SSID;
   cfg.wifiPassword = WIFI_PASSWORD;
+  cfg.wifiBssid = "";
+  cfg.wifiChannel = 0;
   cfg.mikrotikIp = MIKROTIK_IP;
   cfg.mikrotikUser = MIKROTIK_USER;
   cfg.mikrotikPass = MIKROTIK_PASS;
   cfg.mikrotikWlanInterface = MIKROTIK_WLAN_INTERFACE;
+  cfg.mikrotikSecondInterface = MIKROTIK_WLAN_INTERFACE_2;
   cfg.band2ghz = BAND_2GHZ;
   cfg.band5ghz = BAND_5GHZ;
   cfg.channelWidth2ghz = CHANNEL_WIDTH_2GHZ;
   cfg.channelWidth5ghz = CHANNEL_WIDTH_5GHZ;
   cfg.scanDurationSeconds = SCAN_DURATION_SECONDS;
+  cfg.scanMode = SCAN_MODE_DEFAULT;
   cfg.stationRoaming = STATION_ROAMING_DEFAULT;
+  cfg.extraTargets.clear();
 }
 
-bool loadRuntimeConfigFromFile() {
-  applyDefaultConfig(runtimeConfig);
+// "targets" entries from config.json or a settings update. Entries without a
+// name or IP, and duplicate names, are skipped. A target whose password is
+// omitted keeps the one stored under the same name (settings never echo it).
+void parseRouterTargets(JsonArrayConst list, const std::vector<RouterTargetConfig>& previous,
+                        std::vector<RouterTargetConfig>& out) {
+  out.clear();
+  for (JsonObjectConst entry : list) {
+    if (1 + out.size() >= ROUTER_TARGETS_MAX) {
+      Serial.printf("  WARNING: Only %u router targets supported, ignoring the rest\n",
+                    static_cast<unsigned>(ROUTER_TARGETS_MAX));
+      break;
+    }
+    RouterTargetConfig target;
+    target.name = entry["name"] | "";
+    target.ip = entry["ip"] | "";
+    target.user = entry["user"] | "";
+    target.wlanInterface = entry["wlan_interface"] | MIKROTIK_WLAN_INTERFACE;
+    target.secondInterface = entry["wlan_interface_2"] | "";
+    target.name.trim();
+    target.ip.trim();
+    target.user.trim();
+    target.wlanInterface.trim();
+    target.secondInterface.trim();
+    if (target.name.length() == 0 || target.ip.length() == 0 || target.name == PRIMARY_TARGET_NAME) {
+      continue;
+    }
+    bool duplicate = false;
+    for (const RouterTargetConfig& existing : out) {
+      if (existing.name == target.name) duplicate = true;
+    }
+    if (duplicate) {
+      continue;
+    }
+    if (entry["pass"].is<const char*>()) {
+      target.pass = entry["pass"].as<const char*>();
+    } else if (entry["password"].is<const char*>()) {
+      target.pass = entry["password"].as<const char*>();
+    } else {
+      for (const RouterTargetConfig& old : previous) {
+        if (old.name == target.name) target.pass = old.pass;
+      }
+    }
+    out.push_back(target);
+  }
+}
 
-  if (!filesystemAvailable) {
-    Serial.println("  WARNING: Filesystem unavailable, using defaults");
+// ==================== CONFIG STORE ====================
+// CONFIG_FILE_PATH holds the settings as "MWCF", a format version byte and one
+// record per field: tag and length (1 byte each), then the value - strings
+// without terminator, numbers as 4 bytes little-endian. A CRC-32 of
+// everything before it closes the file. Unknown tags are skipped, so a new
+// setting only needs a new tag; CONFIG_STORE_VERSION changes when an existing
+// tag changes meaning. Boot reads it without a JSON document.
+
+const uint8_t CONFIG_STORE_VERSION = 1;
+const size_t CONFIG_STORE_MAX_BYTES = 4096;
+
+// Values are stored in the file: append new tags, never renumber
+enum ConfigTag : uint8_t {
+  CONFIG_TAG_WIFI_SSID = 1,
+  CONFIG_TAG_WIFI_PASSWORD = 2,
+  CONFIG_TAG_WIFI_BSSID = 3,
+  CONFIG_TAG_WIFI_CHANNEL = 4,
+  CONFIG_TAG_MIKROTIK_IP = 5,
+  CONFIG_TAG_MIKROTIK_USER = 6,
+  CONFIG_TAG_MIKROTIK_PASS = 7,
+  CONFIG_TAG_MIKROTIK_INTERFACE = 8,
+  CONFIG_TAG_MIKROTIK_INTERFACE_2 = 9,
+  CONFIG_TAG_BAND_2GHZ = 10,
+  CONFIG_TAG_BAND_5GHZ = 11,
+  CONFIG_TAG_CHANNEL_WIDTH_2GHZ = 12,
+  CONFIG_TAG_CHANNEL_WIDTH_5GHZ = 13,
+  CONFIG_TAG_SCAN_DURATION = 14,
+  CONFIG_TAG_SCAN_MODE = 15,
+  CONFIG_TAG_STATION_ROAMING = 16,
+  CONFIG_TAG_TARGET_NAME = 17,  // Starts a target; the TARGET_* records up to the next one belong to it
+  CONFIG_TAG_TARGET_IP = 18,
+  CONFIG_TAG_TARGET_USER = 19,
+  CONFIG_TAG_TARGET_PASS = 20,
+  CONFIG_TAG_TARGET_INTERFACE = 21,
+  CONFIG_TAG_TARGET_INTERFACE_2 = 22,
+};
+
+bool configDirty = false;           // runtimeConfig has changes not yet in the store
+unsigned long configDirtySince = 0;  // First unsaved change
+unsigned long configChangedAt = 0;   // Latest unsaved change
+uint32_t configStoredCrc = 0;        // CRC of the store as last read or written
+bool configStoreValid = false;
+
+uint32_t configCrc32(const uint8_t* data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+void configPutString(std::vector<uint8_t>& out, uint8_t tag, const String& value) {
+  size_t length = std::min<size_t>(value.length(), 255);
+  out.push_back(tag);
+  out.push_back(static_cast<uint8_t>(length));
+  out.insert(out.end(), value.c_str(), value.c_str() + length);
+}
+
+void configPutNumber(std::vector<uint8_t>& out, uint8_t tag, int32_t value) {
+  uint32_t bits = static_cast<uint32_t>(value);
+  out.push_back(tag);
+  out.push_back(4);
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+  }
+}
+
+void configPutCrc(std::vector<uint8_t>& out) {
+  uint32_t crc = configCrc32(out.data(), out.size());
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<uint8_t>(crc >> (8 * i)));
+  }
+}
+
+uint32_t configGetUint32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+         static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+void encodeRuntimeConfig(const RuntimeConfig& cfg, std::vector<uint8_t>& out) {
+  out.clear();
+  out.reserve(384);
+  out.insert(out.end(), {'M', 'W', 'C', 'F', CONFIG_STORE_VERSION});
+  configPutString(out, CONFIG_TAG_WIFI_SSID, cfg.wifiSsid);
+  configPutString(out, CONFIG_TAG_WIFI_PASSWORD, cfg.wifiPassword);
+  if (cfg.wifiBssid.length() > 0) {
+    configPutString(out, CONFIG_TAG_WIFI_BSSID, cfg.wifiBssid);
+    configPutNumber(out, CONFIG_TAG_WIFI_CHANNEL, cfg.wifiChannel);
+  }
+  configPutString(out, CONFIG_TAG_MIKROTIK_IP, cfg.mikrotikIp);
+  configPutString(out, CONFIG_TAG_MIKROTIK_USER, cfg.mikrotikUser);
+  configPutString(out, CONFIG_TAG_MIKROTIK_PASS, cfg.mikrotikPass);
+  configPutString(out, CONFIG_TAG_MIKROTIK_INTERFACE, cfg.mikrotikWlanInterface);
+  configPutString(out, CONFIG_TAG_MIKROTIK_INTERFACE_2, cfg.mikrotikSecondInterface);
+  for (const RouterTargetConfig& target : cfg.extraTargets) {
+    configPutString(out, CONFIG_TAG_TARGET_NAME, target.name);
+    configPutString(out, CONFIG_TAG_TARGET_IP, target.ip);
+    configPutString(out, CONFIG_TAG_TARGET_USER, target.user);
+    configPutString(out, CONFIG_TAG_TARGET_PASS, target.pass);
+    configPutString(out, CONFIG_TAG_TARGET_INTERFACE, target.wlanInterface);
+    configPutString(out, CONFIG_TAG_TARGET_INTERFACE_2, target.secondInterface);
+  }
+  configPutString(out, CONFIG_TAG_BAND_2GHZ, cfg.band2ghz);
+  configPutString(out, CONFIG_TAG_BAND_5GHZ, cfg.band5ghz);
+  configPutString(out, CONFIG_TAG_CHANNEL_WIDTH_2GHZ, cfg.channelWidth2ghz);
+  configPutString(out, CONFIG_TAG_CHANNEL_WIDTH_5GHZ, cfg.channelWidth5ghz);
+  configPutNumber(out, CONFIG_TAG_SCAN_DURATION, cfg.scanDurationSeconds);
+  configPutString(out, CONFIG_TAG_SCAN_MODE, cfg.scanMode);
+  configPutNumber(out, CONFIG_TAG_STATION_ROAMING, cfg.stationRoaming ? 1 : 0);
+  configPutCrc(out);
+}
+
+// Fields missing from the store keep what `cfg` already holds (the defaults)
+bool decodeRuntimeConfig(const uint8_t* data, size_t length, RuntimeConfig& cfg) {
+  if (length < 9 || memcmp(data, "MWCF", 4) != 0) {
+    Serial.println("  WARNING: Config store has no valid header");
+    return false;
+  }
+  if (data[4] != CONFIG_STORE_VERSION) {
+    Serial.printf("  WARNING: Config store version %u not supported\n", data[4]);
+    return false;
+  }
+  size_t end = length - 4;
+  if (configCrc32(data, end) != configGetUint32(data + end)) {
+    Serial.println("  WARNING: Config store checksum mismatch");
     return false;
   }
 
-  if (!LittleFS.exists(CONFIG_FILE_PATH)) {
-    saveRuntimeConfigToFile();
-    return true;
+  RouterTargetConfig* target = nullptr;
+  size_t pos = 5;
+  while (pos + 2 <= end) {
+    uint8_t tag = data[pos];
+    uint8_t valueLength = data[pos + 1];
+    const uint8_t* value = data + pos + 2;
+    pos += 2 + valueLength;
+    if (pos > end) {
+      Serial.println("  WARNING: Config store record truncated");
+      return false;
+    }
+
+    char text[256];
+    memcpy(text, value, valueLength);
+    text[valueLength] = '\0';
+    int32_t number = valueLength == 4 ? static_cast<int32_t>(configGetUint32(value)) : 0;
+
+    switch (tag) {
+      case CONFIG_TAG_WIFI_SSID: cfg.wifiSsid = text; break;
+      case CONFIG_TAG_WIFI_PASSWORD: cfg.wifiPassword = text; break;
+      case CONFIG_TAG_WIFI_BSSID: cfg.wifiBssid = text; break;
+      case CONFIG_TAG_WIFI_CHANNEL: cfg.wifiChannel = number; break;
+      case CONFIG_TAG_MIKROTIK_IP: cfg.mikrotikIp = text; break;
+      case CONFIG_TAG_MIKROTIK_USER: cfg.mikrotikUser = text; break;
+      case CONFIG_TAG_MIKROTIK_PASS: cfg.mikrotikPass = text; break;
+      case CONFIG_TAG_MIKROTIK_INTERFACE: cfg.mikrotikWlanInterface = text; break;
+      case CONFIG_TAG_MIKROTIK_INTERFACE_2: cfg.mikrotikSecondInterface = text; break;
+      case CONFIG_TAG_BAND_2GHZ: cfg.band2ghz = text; break;
+      case CONFIG_TAG_BAND_5GHZ: cfg.band5ghz = text; break;
+      case CONFIG_TAG_CHANNEL_WIDTH_2GHZ: cfg.channelWidth2ghz = text; break;
+      case CONFIG_TAG_CHANNEL_WIDTH_5GHZ: cfg.channelWidth5ghz = text; break;
+      case CONFIG_TAG_SCAN_DURATION: cfg.scanDurationSeconds = number; break;
+      case CONFIG_TAG_SCAN_MODE: cfg.scanMode = text; break;
+      case CONFIG_TAG_STATION_ROAMING: cfg.stationRoaming = number != 0; break;
+      case CONFIG_TAG_TARGET_NAME:
+        target = nullptr;
+        if (1 + cfg.extraTargets.size() < ROUTER_TARGETS_MAX) {
+          cfg.extraTargets.push_back(RouterTargetConfig());
+          target = &cfg.extraTargets.back();
+          target->name = text;
+        }
+        break;
+      case CONFIG_TAG_TARGET_IP: if (target) target->ip = text; break;
+      case CONFIG_TAG_TARGET_USER: if (target) target->user = text; break;
+      case CONFIG_TAG_TARGET_PASS: if (target) target->pass = text; break;
+      case CONFIG_TAG_TARGET_INTERFACE: if (target) target->wlanInterface = text; break;
+      case CONFIG_TAG_TARGET_INTERFACE_2: if (target) target->secondInterface = text; break;
+      default: break;  // Written by a newer build
+    }
   }
 
-  File file = LittleFS.open(CONFIG_FILE_PATH, "r");
+  if (cfg.scanDurationSeconds <= 0) {
+    cfg.scanDurationSeconds = SCAN_DURATION_SECONDS;
+  }
+  if (!isValidScanMode(cfg.scanMode)) {
+    cfg.scanMode = SCAN_MODE_DEFAULT;
+  }
+  return true;
+}
+
+// Import of the /config.json written by earlier builds (or uploaded with the
+// filesystem image); the only place the settings still go through ArduinoJson
+bool importLegacyConfigJson() {
+  File file = LittleFS.open(CONFIG_JSON_PATH, "r");
   if (!file) {
-    Serial.println("  WARNING: Unable to open config file, using defaults");
+    Serial.println("  WARNING: Unable to open config.json");
     return false;
   }
 
-  DynamicJsonDocument doc(1536);
+  DynamicJsonDocument doc(2560);
   DeserializationError error = deserializeJson(doc, file);
   file.close();
 
   if (error) {
-    Serial.printf("  WARNING: Failed to parse config file: %s\n", error.c_str());
+    Serial.printf("  WARNING: Failed to parse config.json: %s\n", error.c_str());
     return false;
   }
 
   JsonObject wifiObj = doc["wifi"].as<JsonObject>();
   runtimeConfig.wifiSsid = wifiObj["ssid"] | runtimeConfig.wifiSsid;
   runtimeConfig.wifiPassword = wifiObj["password"] | runtimeConfig.wifiPassword;
+  runtimeConfig.wifiBssid = wifiObj["bssid"] | runtimeConfig.wifiBssid;
+  runtimeConfig.wifiChannel = wifiObj["channel"] | runtimeConfig.wifiChannel;
 
   JsonObject mikrotikObj = doc["mikrotik"].as<JsonObject>();
   runtimeConfig.mikrotikIp = mikrotikObj["ip"] | runtimeConfig.mikrotikIp;
   runtimeConfig.mikrotikUser = mikrotikObj["user"] | runtimeConfig.mikrotikUser;
   runtimeConfig.mikrotikPass = mikrotikObj["pass"] | runtimeConfig.mikrotikPass;
   runtimeConfig.mikrotikWlanInterface = mikrotikObj["wlan_interface"] | runtimeConfig.mikrotikWlanInterface;
+  runtimeConfig.mikrotikSecondInterface = mikrotikObj["wlan_interface_2"] | runtimeConfig.mikrotikSecondInterface;
+
+  std::vector<RouterTargetConfig> noPrevious;
+  parseRouterTargets(doc["targets"].as<JsonArrayConst>(), noPrevious, runtimeConfig.extraTargets);
 
   JsonObject bandObj = doc["bands"].as<JsonObject>();
   runtimeConfig.band2ghz = bandObj["band_2ghz"] | runtimeConfig.band2ghz;
@@ -162,6 +991,10 @@ bool loadRuntimeConfigFromFile() {
   if (runtimeConfig.scanDurationSeconds <= 0) {
     runtimeConfig.scanDurationSeconds = SCAN_DURATION_SECONDS;
   }
+  runtimeConfig.scanMode = scanObj["mode"] | runtimeConfig.scanMode;
+  if (!isValidScanMode(runtimeConfig.scanMode)) {
+    runtimeConfig.scanMode = SCAN_MODE_DEFAULT;
+  }
 
   JsonObject wirelessObj = doc["wireless"].as<JsonObject>();
   runtimeConfig.stationRoaming = wirelessObj["station_roaming"] | runtimeConfig.stationRoaming;
@@ -169,49 +1002,132 @@ bool loadRuntimeConfigFromFile() {
   return true;
 }
 
-bool saveRuntimeConfigToFile() {
-  if (!filesystemAvailable) {
-    Serial.println("  ERROR: Cannot save config (filesystem unavailable)");
+bool readConfigStore() {
+  File file = LittleFS.open(CONFIG_FILE_PATH, "r");
+  if (!file) {
+    Serial.println("  WARNING: Unable to open config store");
+    return false;
+  }
+  size_t size = file.size();
+  if (size > CONFIG_STORE_MAX_BYTES) {
+    file.close();
+    Serial.printf("  WARNING: Config store too large (%u bytes)\n", static_cast<unsigned>(size));
     return false;
   }
+  std::vector<uint8_t> data(size);
+  size_t read = file.read(data.data(), size);
+  file.close();
 
-  DynamicJsonDocument doc(1536);
+  RuntimeConfig decoded;
+  applyDefaultConfig(decoded);
+  if (read != size || !decodeRuntimeConfig(data.data(), size, decoded)) {
+    return false;
+  }
+  runtimeConfig = decoded;
+  configStoredCrc = configGetUint32(data.data() + size - 4);
+  configStoreValid = true;
+  return true;
+}
+
+bool loadRuntimeConfig() {
+  applyDefaultConfig(runtimeConfig);
 
-  JsonObject wifiObj = doc.createNestedObject("wifi");
-  wifiObj["ssid"] = runtimeConfig.wifiSsid;
-  wifiObj["password"] = runtimeConfig.wifiPassword;
+  if (!filesystemAvailable) {
+    Serial.println("  WARNING: Filesystem unavailable, using defaults");
+    return false;
+  }
 
-  JsonObject mikrotikObj = doc.createNestedObject("mikrotik");
-  mikrotikObj["ip"] = runtimeConfig.mikrotikIp;
-  mikrotikObj["user"] = runtimeConfig.mikrotikUser;
-  mikrotikObj["pass"] = runtimeConfig.mikrotikPass;
-  mikrotikObj["wlan_interface"] = runtimeConfig.mikrotikWlanInterface;
+  // A config.json is imported once and then replaced by the store
+  if (LittleFS.exists(CONFIG_JSON_PATH)) {
+    Serial.println("  Importing config.json into the config store");
+    bool imported = importLegacyConfigJson();
+    if (!imported) {
+      applyDefaultConfig(runtimeConfig);
+      if (LittleFS.exists(CONFIG_FILE_PATH)) {
+        return readConfigStore();
+      }
+    }
+    configDirty = true;
+    if (flushConfig() && imported) {
+      LittleFS.remove(CONFIG_JSON_PATH);
+    }
+    return imported;
+  }
 
-  JsonObject bandObj = doc.createNestedObject("bands");
-  bandObj["band_2ghz"] = runtimeConfig.band2ghz;
-  bandObj["band_5ghz"] = runtimeConfig.band5ghz;
-  bandObj["channel_width_2ghz"] = runtimeConfig.channelWidth2ghz;
-  bandObj["channel_width_5ghz"] = runtimeConfig.channelWidth5ghz;
+  if (!LittleFS.exists(CONFIG_FILE_PATH)) {
+    configDirty = true;
+    flushConfig();
+    return true;
+  }
+  return readConfigStore();
+}
 
-  JsonObject scanObj = doc.createNestedObject("scan");
-  scanObj["duration_seconds"] = runtimeConfig.scanDurationSeconds;
+// Settings changes only mark the config dirty; handleConfigTasks() writes it
+// CONFIG_SAVE_DELAY_MS after the last change, so a burst of edits costs one
+// flash write. Call under SharedStateLock.
+void markConfigDirty() {
+  unsigned long now = millis();
+  if (!configDirty) {
+    configDirtySince = now;
+  }
+  configDirty = true;
+  configChangedAt = now;
+}
 
-  JsonObject wirelessObj = doc.createNestedObject("wireless");
-  wirelessObj["station_roaming"] = runtimeConfig.stationRoaming;
+// Writes pending changes now. The store is replaced through a temporary file,
+// and not at all when its contents would not change.
+bool flushConfig() {
+  std::vector<uint8_t> data;
+  {
+    SharedStateLock lock;
+    if (!configDirty) {
+      return true;
+    }
+    configDirty = false;
+    encodeRuntimeConfig(runtimeConfig, data);
+  }
 
-  File file = LittleFS.open(CONFIG_FILE_PATH, "w");
-  if (!file) {
-    Serial.println("  ERROR: Unable to open config file for writing");
+  if (!filesystemAvailable) {
+    Serial.println("  ERROR: Cannot save config (filesystem unavailable)");
     return false;
   }
+  uint32_t crc = configGetUint32(data.data() + data.size() - 4);
+  if (configStoreValid && crc == configStoredCrc) {
+    return true;
+  }
 
-  serializeJson(doc, file);
-  file.close();
+  File file = LittleFS.open(CONFIG_TEMP_PATH, "w");
+  size_t written = file ? file.write(data.data(), data.size()) : 0;
+  if (file) {
+    file.close();
+  }
+  if (written != data.size() || !LittleFS.rename(CONFIG_TEMP_PATH, CONFIG_FILE_PATH)) {
+    Serial.println("  ERROR: Unable to write config store, retrying");
+    SharedStateLock lock;
+    markConfigDirty();
+    return false;
+  }
+  configStoredCrc = crc;
+  configStoreValid = true;
+  Serial.printf("Config saved (%u bytes)\n", static_cast<unsigned>(data.size()));
   return true;
 }
 
+void handleConfigTasks() {
+  unsigned long now = millis();
+  bool due;
+  {
+    SharedStateLock lock;
+    due = configDirty && (now - configChangedAt >= CONFIG_SAVE_DELAY_MS ||
+                          now - configDirtySince >= CONFIG_SAVE_MAX_DELAY_MS);
+  }
+  if (due) {
+    flushConfig();
+  }
+}
+
 bool isPathAllowedDuringCaptive(const String& path) {
-  if (path == "/" || path == "/config.html" || path == "/config.js" || path == "/style.css" || path == "/favicon.png" || path == "/favicon.ico" || path == "/favicon@2x.png") {
+  if (path == "/" || path == "/config.html" || path == "/config.js" || path == "/common.js" || path == "/style.css" || path == "/favicon.png" || path == "/favicon.ico" || path == "/favicon@2x.png") {
     return true;
   }
   if (path.startsWith("/i18n/")) {
@@ -224,13 +1140,13 @@ bool ensureOperationAllowed() {
   if (!captivePortalActive) {
     return true;
   }
-  server.send(403, "application/json", "{\"error\":\"Captive portal active\"}");
+  apiSend(403, "application/json", "{\"error\":\"Captive portal active\"}");
   return false;
 }
 
 // ==================== FILESYSTEM UTILITIES ====================
 
-String getContentType(String filename) {
+String getContentType(const String& filename) {
   if (filename.endsWith(".html")) return "text/html";
   else if (filename.endsWith(".css")) return "text/css";
   else if (filename.endsWith(".js")) return "application/javascript";
@@ -241,34 +1157,167 @@ String getContentType(String filename) {
   return "text/plain";
 }
 
-bool handleFileRead(String path) {
-  if (path.endsWith("/")) {
-    path += "index.html";
-  }
+// Entry of /assets.json, written by scripts/build_data.py when the LittleFS image is built
+struct StaticAsset {
+  String path;
+  String source;                 // data/ file it was built from (app.1a2b3c4d.js -> /app.js)
+  uint32_t hash;
+  bool gzip;
+  bool immutable;                // content-hashed name: never changes
+  String language;               // strings inlined into a page
+  std::vector<String> variants;  // other languages of a page (index.html -> index.de.html)
+};
 
-  // LittleFS expects paths WITH a leading slash
-  if (!path.startsWith("/")) {
-    path = "/" + path;
-  }
+std::vector<StaticAsset> staticAssets;
+bool assetManifestLoaded = false;
 
-  // Never expose runtime configuration secrets over HTTP
-  if (path == CONFIG_FILE_PATH) {
-    server.send(404, "text/plain", "Not found");
-    return true;
-  }
+// Load the asset manifest once at boot: lookups then need no LittleFS.exists()
+void loadAssetManifest() {
+  staticAssets.clear();
+  assetManifestLoaded = false;
 
-  if (captivePortalActive && !isPathAllowedDuringCaptive(path)) {
-    server.sendHeader("Location", "/config.html");
-    server.send(302, "text/plain", "Redirect");
-    return true;
+  File file = LittleFS.open(ASSET_MANIFEST_PATH, "r");
+  if (!file) {
+    Serial.println("  No asset manifest - serving files uncompressed without caching");
+    return;
+  }
+
+  DynamicJsonDocument doc(JSON_BUFFER_ASSET_MANIFEST);
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error) {
+    Serial.printf("  ERROR: Failed to parse asset manifest: %s\n", error.c_str());
+    return;
+  }
+
+  for (JsonPair entry : doc.as<JsonObject>()) {
+    StaticAsset asset;
+    asset.path = entry.key().c_str();
+    asset.source = entry.value()["src"] | asset.path.c_str();
+    asset.hash = strtoul(entry.value()["hash"] | "0", nullptr, 16);
+    asset.gzip = entry.value()["gz"] | false;
+    asset.immutable = entry.value()["immutable"] | false;
+    asset.language = entry.value()["lang"] | "";
+    for (JsonVariant variant : entry.value()["variants"].as<JsonArray>()) {
+      asset.variants.push_back(variant.as<const char*>());
+    }
+    staticAssets.push_back(asset);
+  }
+  assetManifestLoaded = true;
+  Serial.printf("  Asset manifest: %u files\n", static_cast<unsigned>(staticAssets.size()));
+}
+
+const StaticAsset* findStaticAsset(const String& path) {
+  for (const StaticAsset& asset : staticAssets) {
+    if (asset.path == path) {
+      return &asset;
+    }
+  }
+  return nullptr;
+}
+
+bool clientAcceptsGzip() {
+  return server.hasHeader("Accept-Encoding") && server.header("Accept-Encoding").indexOf("gzip") >= 0;
+}
+
+// Language copy of a page for Accept-Language ("de-DE,de;q=0.9,en;q=0.8"), in the
+// client's order; the page itself when its own language comes first or none matches
+const StaticAsset* selectAssetVariant(const StaticAsset* asset) {
+  if (asset->variants.empty() || !server.hasHeader("Accept-Language")) {
+    return asset;
+  }
+  String header = server.header("Accept-Language");
+  header.toLowerCase();
+  int start = 0;
+  while (start < static_cast<int>(header.length())) {
+    int end = header.indexOf(',', start);
+    if (end < 0) end = header.length();
+    String tag = header.substring(start, end);
+    int cut = tag.indexOf(';');
+    if (cut >= 0) tag = tag.substring(0, cut);
+    cut = tag.indexOf('-');
+    if (cut >= 0) tag = tag.substring(0, cut);
+    tag.trim();
+    start = end + 1;
+
+    if (tag == asset->language) {
+      return asset;
+    }
+    for (const String& variant : asset->variants) {
+      if (tag != variant) continue;
+      int dot = asset->path.lastIndexOf('.');
+      const StaticAsset* copy = findStaticAsset(asset->path.substring(0, dot) + "." + variant + asset->path.substring(dot));
+      return copy != nullptr ? copy : asset;
+    }
+  }
+  return asset;
+}
+
+bool handleFileRead(String path) {
+  if (path.endsWith("/")) {
+    path += "index.html";
+  }
+
+  // LittleFS expects paths WITH a leading slash
+  if (!path.startsWith("/")) {
+    path = "/" + path;
+  }
+
+  // Never expose runtime configuration secrets over HTTP
+  if (path == CONFIG_JSON_PATH || path.startsWith(CONFIG_FILE_PATH)) {
+    server.send(404, "text/plain", "Not found");
+    return true;
+  }
+
+  // Built files (app.1a2b3c4d.js, index.de.html) are checked under the name they were built from
+  const StaticAsset* asset = assetManifestLoaded ? findStaticAsset(path) : nullptr;
+  if (captivePortalActive && !isPathAllowedDuringCaptive(asset != nullptr ? asset->source : path)) {
+    server.sendHeader("Location", "/config.html");
+    server.send(302, "text/plain", "Redirect");
+    return true;
   }
 
   if (captivePortalActive && path == "/index.html") {
     path = "/config.html";
+    asset = assetManifestLoaded ? findStaticAsset(path) : nullptr;
   }
 
   String contentType = getContentType(path);
 
+  if (assetManifestLoaded) {
+    if (asset == nullptr) {
+      return false;
+    }
+    bool localized = !asset->variants.empty();
+    asset = selectAssetVariant(asset);
+
+    // Content-hashed names and references carrying the hash (?v=...) never change:
+    // cache them for good. Everything else is revalidated with the ETag.
+    String etag = makeEtag(asset->hash);
+    bool versioned = asset->immutable ||
+                     (server.hasArg("v") && strtoul(server.arg("v").c_str(), nullptr, 16) == asset->hash);
+    server.sendHeader("Cache-Control", versioned ? "public, max-age=31536000, immutable" : "no-cache");
+    server.sendHeader("ETag", etag);
+    if (localized) {
+      server.sendHeader("Vary", asset->gzip ? "Accept-Encoding, Accept-Language" : "Accept-Language");
+    } else if (asset->gzip) {
+      server.sendHeader("Vary", "Accept-Encoding");
+    }
+    if (clientHasEtag(etag)) {
+      server.send(304);
+      return true;
+    }
+
+    // streamFile() adds Content-Encoding: gzip for *.gz files
+    File file = LittleFS.open(asset->gzip && clientAcceptsGzip() ? asset->path + ".gz" : asset->path, "r");
+    if (!file) {
+      return false;
+    }
+    server.streamFile(file, contentType);
+    file.close();
+    return true;
+  }
+
   if (LittleFS.exists(path)) {
     File file = LittleFS.open(path, "r");
     if (file) {
@@ -283,1020 +1332,3664 @@ bool handleFileRead(String path) {
 
 // ==================== MIKROTIK API HELPERS ====================
 
-String mikrotikRequest(String method, String path, String jsonBody = "", int timeoutMs = 15000) {
+// Persistent REST session: a single keep-alive socket to the router plus the
+// base URL and Authorization header, computed once per credential change.
+struct MikrotikSession {
+  WiFiClient client;
   HTTPClient http;
-  http.setTimeout(timeoutMs);
+  String baseUrl;
+  String url;
+  String authHeader;
+  bool prepared = false;
+
+  // Per-request timing (exposed via /api/diagnostics)
+  unsigned long requestCount = 0;
+  unsigned long failureCount = 0;
+  unsigned long reconnectCount = 0;
+  unsigned long reusedCount = 0;
+  unsigned long totalRequestMs = 0;
+  unsigned long maxRequestMs = 0;
+  unsigned long lastRequestMs = 0;
+  unsigned long responseBytes = 0;
+  int lastHttpCode = 0;
+  char lastRequest[96] = "";
+};
 
-  // Use HTTP instead of HTTPS to keep RAM usage low
-  if (runtimeConfig.mikrotikIp.length() == 0) {
-    Serial.println("  ERROR: MikroTik IP not configured");
-    return "{\"error\":\"mikrotik_ip_not_configured\"}";
-  }
-  String url = "http://" + runtimeConfig.mikrotikIp + "/rest" + path;
+MikrotikSession& mikrotikSession();
 
-  http.begin(url);
+// Drop the socket and cached credentials (call after MikroTik settings change)
+void mikrotikSessionReset() {
+  mikrotikSession().http.end();
+  mikrotikSession().client.stop();
+  mikrotikSession().baseUrl = "";
+  mikrotikSession().authHeader = "";
+  mikrotikSession().prepared = false;
+}
 
-  String auth = runtimeConfig.mikrotikUser + ":" + runtimeConfig.mikrotikPass;
-  String authEncoded = base64::encode(auth);
-  http.addHeader("Authorization", "Basic " + authEncoded);
+bool mikrotikSessionPrepare() {
+  if (mikrotikSession().prepared) {
+    return true;
+  }
 
-  if (jsonBody.length() > 0) {
-    http.addHeader("Content-Type", "application/json");
+  // Use HTTP instead of HTTPS to keep RAM usage low
+  if (targetConfig().ip.length() == 0) {
+    return false;
   }
 
-  int httpCode = -1;
+  mikrotikSession().baseUrl = "http://" + targetConfig().ip + "/rest";
+  mikrotikSession().url.reserve(mikrotikSession().baseUrl.length() + 128);
+  String auth = targetConfig().user + ":" + targetConfig().pass;
+  mikrotikSession().authHeader = "Basic " + base64::encode(auth);
+  mikrotikSession().http.setReuse(true);
+  mikrotikSession().prepared = true;
+  return true;
+}
 
+// Errors that indicate the router closed our idle keep-alive socket
+bool isStaleSessionError(int httpCode) {
+  return httpCode == HTTPC_ERROR_SEND_HEADER_FAILED ||
+         httpCode == HTTPC_ERROR_SEND_PAYLOAD_FAILED ||
+         httpCode == HTTPC_ERROR_NOT_CONNECTED ||
+         httpCode == HTTPC_ERROR_CONNECTION_LOST;
+}
+
+int mikrotikSendRequest(HTTPClient& http, const String& method, const String& jsonBody) {
   if (method == "GET") {
-    httpCode = http.GET();
+    return http.GET();
   } else if (method == "POST") {
-    httpCode = http.POST(jsonBody);
+    return http.POST(jsonBody);
   } else if (method == "PATCH") {
-    httpCode = http.PATCH(jsonBody);
+    return http.PATCH(jsonBody);
   } else if (method == "DELETE") {
-    httpCode = http.sendRequest("DELETE", jsonBody);
-  }
-
-  String response = "";
-  if (httpCode > 0) {
-    response = http.getString();
-  } else {
-    Serial.printf("  → MikroTik ERROR: %s\n", http.errorToString(httpCode).c_str());
-    response = "{\"error\":\"Request failed\"}";
+    return http.sendRequest("DELETE", jsonBody);
   }
-
-  http.end();
-  return response;
+  return -1;
 }
 
-bool fetchConfiguredWirelessInterface(String& interfaceIdOut, String& currentBandOut) {
-  String ifaceResponse = mikrotikRequest("GET", "/interface/wireless");
-  DynamicJsonDocument ifaceDoc(JSON_BUFFER_INTERFACES);
-  DeserializationError error = deserializeJson(ifaceDoc, ifaceResponse);
+// Send a request on the session socket and read the response headers.
+// The body is left unread for the caller; finish with mikrotikEndRequest().
+int mikrotikBeginRequest(const String& method, const String& path, const String& jsonBody, int timeoutMs) {
+  HTTPClient& http = mikrotikSession().http;
+  int httpCode = -1;
 
-  if (error) {
-    Serial.printf("  ERROR: Failed to parse interface list: %s\n", error.c_str());
-    return false;
-  }
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reusingSocket = mikrotikSession().client.connected();
 
-  if (ifaceDoc.is<JsonArray>()) {
-    for (JsonObject iface : ifaceDoc.as<JsonArray>()) {
-      String name = iface["name"] | "";
-      if (name == runtimeConfig.mikrotikWlanInterface) {
-        interfaceIdOut = iface[".id"] | "";
-        currentBandOut = iface["band"] | "";
-        if (interfaceIdOut.length() == 0) {
-          Serial.println("  ERROR: Configured interface found but missing .id");
-          return false;
-        }
-        return true;
-      }
+    http.setTimeout(timeoutMs);
+    // Reused buffer: keeps its capacity across requests
+    mikrotikSession().url = mikrotikSession().baseUrl;
+    mikrotikSession().url += path;
+    if (!http.begin(mikrotikSession().client, mikrotikSession().url)) {
+      break;
     }
-  }
-
-  Serial.printf("  ERROR: Configured interface '%s' not found on MikroTik\n", runtimeConfig.mikrotikWlanInterface.c_str());
-  return false;
-}
-
-// ==================== SECURITY PROFILE MANAGEMENT ====================
+    http.addHeader("Authorization", mikrotikSession().authHeader);
 
-String ensureSecurityProfile(String ssid, String password, bool requiresPassword,
-                             bool known, String profileName) {
-  // Use profile name from frontend or fall back to truncated SSID
-  if (profileName.length() == 0) {
-    profileName = "client-" + ssid.substring(0, min(20, (int)ssid.length()));
-  }
+    if (jsonBody.length() > 0) {
+      http.addHeader("Content-Type", "application/json");
+    }
 
-  String comment = String(PROFILE_COMMENT_PREFIX) + ssid;
+    const char* collect[] = {"Transfer-Encoding"};
+    http.collectHeaders(collect, 1);
+    httpCode = mikrotikSendRequest(http, method, jsonBody);
 
-  // Load existing profiles
-  DynamicJsonDocument profilesDoc(JSON_BUFFER_SECURITY_PROFILES);
-  String response = mikrotikRequest("GET", "/interface/wireless/security-profiles");
-  DeserializationError error = deserializeJson(profilesDoc, response);
-  if (error) {
-    Serial.printf("  ERROR: JSON parsing failed: %s\n", error.c_str());
-    Serial.printf("  Response size: %d bytes\n", response.length());
-  }
+    if (reusingSocket && httpCode > 0) {
+      mikrotikSession().reusedCount++;
+    }
 
-  // Find matching profile if it already exists
-  JsonObject targetProfile;
-  String existingMode = "";
-  if (profilesDoc.is<JsonArray>()) {
-    for (JsonObject profile : profilesDoc.as<JsonArray>()) {
-      String pName = profile["name"] | "";
-      String pComment = profile["comment"] | "";
-      if (pName == profileName || pComment == comment) {
-        targetProfile = profile;
-        existingMode = profile["mode"] | "";
-        break;
-      }
+    // A reused socket may have been closed by the router while idle: reconnect once.
+    // Timeouts are not retried, the router may already be executing the command.
+    if (httpCode > 0 || !reusingSocket || !isStaleSessionError(httpCode)) {
+      break;
     }
+    Serial.printf("  → MikroTik session stale (%s), reconnecting\n", http.errorToString(httpCode).c_str());
+    http.end();
+    mikrotikSession().client.stop();
+    mikrotikSession().reconnectCount++;
   }
 
-  // Determine desired security mode
-  String desiredMode = requiresPassword ? "dynamic-keys" : "none";
-
-  // If profile exists but mode differs -> delete and recreate
-  bool needsRecreate = false;
-  if (!targetProfile.isNull() && existingMode != desiredMode) {
-    String targetName = targetProfile["name"] | profileName;
-    mikrotikRequest("DELETE", "/interface/wireless/security-profiles/" + targetName, "");
-    targetProfile = JsonObject();  // Mark as deleted
-    needsRecreate = true;
+  if (httpCode <= 0) {
+    Serial.printf("  → MikroTik ERROR: %s\n", http.errorToString(httpCode).c_str());
+    mikrotikSession().failureCount++;
   }
+  return httpCode;
+}
 
-  // Build payload
-  DynamicJsonDocument payloadDoc(JSON_BUFFER_SECURITY_PAYLOAD);
-  payloadDoc["comment"] = comment;
-
-  if (requiresPassword) {
-    payloadDoc["mode"] = "dynamic-keys";
-    payloadDoc["authentication-types"] = "wpa-psk,wpa2-psk";
-    if (password.length() > 0) {
-      payloadDoc["wpa-pre-shared-key"] = password;
-      payloadDoc["wpa2-pre-shared-key"] = password;
-    } else {
-      Serial.println("  WARNING: requiresPassword=true but password is empty!");
-    }
-  } else {
-    payloadDoc["mode"] = "none";
-    payloadDoc["authentication-types"] = "";
-    payloadDoc["wpa-pre-shared-key"] = "";
-    payloadDoc["wpa2-pre-shared-key"] = "";
+// Release the request and record its timing. Pass bodyConsumed=false when the
+// body was not read to the end so the socket is not reused mid-response.
+void mikrotikEndRequest(const String& method, const String& path, int httpCode,
+                        unsigned long startMs, bool bodyConsumed = true) {
+  if (!bodyConsumed) {
+    mikrotikSession().client.stop();
+  }
+  // Keeps the socket open for the next request when the router allows keep-alive
+  mikrotikSession().http.end();
+
+  unsigned long elapsedMs = millis() - startMs;
+  mikrotikSession().requestCount++;
+  mikrotikSession().totalRequestMs += elapsedMs;
+  mikrotikSession().lastRequestMs = elapsedMs;
+  if (elapsedMs > mikrotikSession().maxRequestMs) {
+    mikrotikSession().maxRequestMs = elapsedMs;
   }
+  mikrotikSession().lastHttpCode = httpCode;
+  metricsRecordRouter(method.c_str(), path.c_str(), elapsedMs * 1000UL, httpCode <= 0 || httpCode >= 400);
+  snprintf(mikrotikSession().lastRequest, sizeof(mikrotikSession().lastRequest), "%s %s", method.c_str(), path.c_str());
+  Serial.printf("  → MikroTik %s %s: %d (%lu ms)\n", method.c_str(), path.c_str(), httpCode, elapsedMs);
+}
 
-  String payload;
-  serializeJson(payloadDoc, payload);
+String mikrotikRequestOnce(const String& method, const String& path, const String& jsonBody, int timeoutMs) {
+  unsigned long startMs = millis();
+  int httpCode = mikrotikBeginRequest(method, path, jsonBody, timeoutMs);
 
-  // Update or create profile
-  if (!targetProfile.isNull() && !needsRecreate) {
-    // Update existing profile (only when mode stays the same)
-    String targetName = targetProfile["name"] | profileName;
-    mikrotikRequest("PATCH", "/interface/wireless/security-profiles/" + targetName, payload);
-    return targetName;
+  String response = "";
+  if (httpCode > 0) {
+    response = mikrotikSession().http.getString();
+    mikrotikSession().responseBytes += response.length();
   } else {
-    // Create new profile
-    if (requiresPassword && password.length() == 0) {
-      Serial.println("  ERROR: Password required for secured profile");
-      return profileName;
-    }
-    payloadDoc["name"] = profileName;
-    String createPayload;
-    serializeJson(payloadDoc, createPayload);
-    mikrotikRequest("POST", "/interface/wireless/security-profiles/add", createPayload);
-    return profileName;
+    response = "{\"error\":\"Request failed\"}";
   }
+
+  mikrotikEndRequest(method, path, httpCode, startMs);
+  return response;
 }
 
-// ==================== CONNECTION LIST MANAGEMENT ====================
+// Several targets can be radios of one router, and their tasks then refresh
+// the same lists (/interface/wireless, /ip/address, ...) at the same time. An
+// identical GET to the same router and account that is already in flight on
+// another task is not sent again: the caller waits for that response instead.
+struct RouterFlight {
+  String key;
+  String response;
+  SemaphoreHandle_t done = nullptr;  // Given once per waiter when the response is in
+  int waiters = 0;
+  bool finished = false;
+};
 
-const char* CONNECT_LIST_COMMENT_PREFIX = "wifi-manager:ssid=";
+std::vector<RouterFlight*> routerFlights;  // In flight (SharedStateLock)
+unsigned long routerFlightsShared = 0;     // GETs answered from another task's request
+
+// Drop a waiter's reference (under SharedStateLock); the last one frees the flight
+void routerFlightRelease(RouterFlight* flight) {
+  if (flight->finished && flight->waiters == 0) {
+    vSemaphoreDelete(flight->done);
+    delete flight;
+  }
+}
 
-// Disable all connect-list entries
-void disableAllConnectionLists() {
-  String response = mikrotikRequest("GET", "/interface/wireless/connect-list");
-  DynamicJsonDocument doc(JSON_BUFFER_SECURITY_PROFILES);
-  DeserializationError error = deserializeJson(doc, response);
+String mikrotikGetShared(const String& path, int timeoutMs) {
+  const RouterTargetConfig& config = targetConfig();
+  String key = config.ip + " " + config.user + " " +
+               String(static_cast<unsigned long>(fnv1aHash(config.pass.c_str(), config.pass.length()))) + " " + path;
 
-  if (error) {
-    Serial.printf("  ERROR: Failed to parse connect-list: %s\n", error.c_str());
-    return;
+  RouterFlight* flight = nullptr;
+  bool leader = false;
+  {
+    SharedStateLock lock;
+    for (RouterFlight* pending : routerFlights) {
+      if (pending->key == key) {
+        flight = pending;
+        flight->waiters++;
+        break;
+      }
+    }
+    if (flight == nullptr) {
+      flight = new RouterFlight();
+      flight->key = key;
+      flight->done = xSemaphoreCreateCounting(ROUTER_TARGETS_MAX + 1, 0);
+      if (flight->done == nullptr) {
+        delete flight;
+        flight = nullptr;
+      } else {
+        routerFlights.push_back(flight);
+        leader = true;
+      }
+    }
+  }
+  if (flight == nullptr) {
+    return mikrotikRequestOnce("GET", path, String(), timeoutMs);
   }
 
-  if (doc.is<JsonArray>()) {
-    for (JsonObject entry : doc.as<JsonArray>()) {
-      String comment = entry["comment"] | "";
-      if (comment.startsWith(CONNECT_LIST_COMMENT_PREFIX)) {
-        String entryId = entry[".id"] | "";
-        if (entryId.length() > 0) {
-          Serial.printf("  Disabling connect-list entry: %s\n", entryId.c_str());
-          mikrotikRequest("PATCH", "/interface/wireless/connect-list/" + entryId, "{\"disabled\":\"yes\"}");
-        }
+  if (!leader) {
+    bool signalled = xSemaphoreTake(flight->done, pdMS_TO_TICKS(timeoutMs + 1000)) == pdTRUE;
+    String response;
+    bool shared;
+    {
+      SharedStateLock lock;
+      shared = signalled || flight->finished;
+      if (shared) {
+        response = flight->response;
+        routerFlightsShared++;
       }
+      flight->waiters--;
+      routerFlightRelease(flight);
     }
+    // The other task is stuck: ask ourselves
+    return shared ? response : mikrotikRequestOnce("GET", path, String(), timeoutMs);
   }
+
+  String response = mikrotikRequestOnce("GET", path, String(), timeoutMs);
+  SharedStateLock lock;
+  flight->response = response;
+  flight->finished = true;
+  routerFlights.erase(std::remove(routerFlights.begin(), routerFlights.end(), flight), routerFlights.end());
+  for (int i = 0; i < flight->waiters; i++) {
+    xSemaphoreGive(flight->done);
+  }
+  routerFlightRelease(flight);
+  return response;
 }
 
-// Delete connect-list for specific SSID
-void deleteConnectionList(String ssid) {
-  String comment = String(CONNECT_LIST_COMMENT_PREFIX) + ssid;
-  String response = mikrotikRequest("GET", "/interface/wireless/connect-list");
-  DynamicJsonDocument doc(JSON_BUFFER_SECURITY_PROFILES);
-  DeserializationError error = deserializeJson(doc, response);
+String mikrotikRequest(const String& method, const String& path, const String& jsonBody = String(), int timeoutMs = 15000) {
+  if (!mikrotikSessionPrepare()) {
+    Serial.println("  ERROR: MikroTik IP not configured");
+    return "{\"error\":\"mikrotik_ip_not_configured\"}";
+  }
+  // Waiting while holding the shared lock would stall the task that has to
+  // hand over the response, so such callers always ask the router themselves
+  bool holdsLock = sharedStateMutex != nullptr &&
+                   xSemaphoreGetMutexHolder(sharedStateMutex) == xTaskGetCurrentTaskHandle();
+  if (method == "GET" && routerTaskIndex() >= 0 && !holdsLock) {
+    return mikrotikGetShared(path, timeoutMs);
+  }
+  return mikrotikRequestOnce(method, path, jsonBody, timeoutMs);
+}
 
-  if (error) {
-    Serial.printf("  ERROR: Failed to parse connect-list: %s\n", error.c_str());
-    return;
+// Response body as a Stream: stops at Content-Length and decodes chunked
+// transfer encoding, so ArduinoJson can parse straight off the socket.
+struct HttpBodyStream : public Stream {
+  WiFiClient& client;
+  long remaining;       // bytes left in the body (-1: until close) or in the current chunk
+  bool chunked;
+  bool done = false;
+
+  HttpBodyStream(WiFiClient& c, long contentLength, bool isChunked)
+      : client(c), remaining(isChunked ? 0 : contentLength), chunked(isChunked) {
+    setTimeout(c.getTimeout());
   }
 
-  if (doc.is<JsonArray>()) {
-    for (JsonObject entry : doc.as<JsonArray>()) {
-      String entryComment = entry["comment"] | "";
-      if (entryComment == comment) {
-        String entryId = entry[".id"] | "";
-        if (entryId.length() > 0) {
-          Serial.printf("  Deleting connect-list for SSID: %s\n", ssid.c_str());
-          mikrotikRequest("DELETE", "/interface/wireless/connect-list/" + entryId, "");
-        }
+  // Read the next chunk-size line (blocking up to the client timeout)
+  bool nextChunk() {
+    if (done) {
+      return false;
+    }
+    if (remaining == 0) {
+      String sizeLine = client.readStringUntil('\n');
+      remaining = strtol(sizeLine.c_str(), nullptr, 16);
+      if (remaining <= 0) {
+        client.readStringUntil('\n');  // trailer terminator
+        done = true;
+        return false;
       }
     }
+    return true;
   }
-}
 
-// Ensure connection list exists for specific AP
-String ensureConnectionList(String ssid, String macAddress, String interfaceName, String securityProfile) {
-  String comment = String(CONNECT_LIST_COMMENT_PREFIX) + ssid;
-
-  // First, disable all other connect-lists
-  disableAllConnectionLists();
+  // True while body bytes are left (opens the next chunk when needed)
+  bool ready() {
+    if (!done && remaining == 0) {
+      if (chunked) {
+        return nextChunk();
+      }
+      done = true;
+    }
+    return !done;
+  }
 
-  // Check if entry already exists
-  String response = mikrotikRequest("GET", "/interface/wireless/connect-list");
-  DynamicJsonDocument doc(JSON_BUFFER_SECURITY_PROFILES);
-  DeserializationError error = deserializeJson(doc, response);
+  // Skip the rest of the body so the keep-alive socket can be reused
+  void drain() {
+    while (ready() && timedRead() >= 0) {
+    }
+  }
 
-  if (error) {
-    Serial.printf("  ERROR: Failed to parse connect-list: %s\n", error.c_str());
-    return "";
+  int available() override {
+    if (done || (chunked && remaining == 0 && !client.available())) {
+      return 0;
+    }
+    if (!ready()) {
+      return 0;
+    }
+    int avail = client.available();
+    return remaining < 0 ? avail : static_cast<int>(min<long>(avail, remaining));
   }
 
-  String existingId = "";
-  if (doc.is<JsonArray>()) {
-    for (JsonObject entry : doc.as<JsonArray>()) {
-      String entryComment = entry["comment"] | "";
-      if (entryComment == comment) {
-        existingId = entry[".id"] | "";
-        break;
+  int read() override {
+    if (!ready()) {
+      return -1;
+    }
+    int c = client.read();
+    if (c < 0) {
+      if (!client.connected() && remaining < 0) {
+        done = true;
       }
+      return -1;
     }
+    mikrotikSession().responseBytes++;
+    if (remaining > 0 && --remaining == 0 && chunked) {
+      client.readStringUntil('\n');  // CRLF after the chunk data
+    }
+    return c;
   }
 
-  // Build payload
-  DynamicJsonDocument payloadDoc(JSON_BUFFER_CONNECT_PAYLOAD);
-  payloadDoc["interface"] = interfaceName;
-  payloadDoc["ssid"] = ssid;
-  payloadDoc["mac-address"] = macAddress;
-  payloadDoc["security-profile"] = securityProfile;
-  payloadDoc["comment"] = comment;
-  payloadDoc["disabled"] = "no";
+  int peek() override {
+    return ready() ? client.peek() : -1;
+  }
 
-  String payload;
-  serializeJson(payloadDoc, payload);
+  size_t write(uint8_t) override {
+    return 0;
+  }
 
-  if (existingId.length() > 0) {
-    // Update existing entry
-    Serial.printf("  Updating connect-list for SSID: %s, MAC: %s\n", ssid.c_str(), macAddress.c_str());
-    mikrotikRequest("PATCH", "/interface/wireless/connect-list/" + existingId, payload);
-    return existingId;
-  } else {
-    // Create new entry
-    Serial.printf("  Creating connect-list for SSID: %s, MAC: %s\n", ssid.c_str(), macAddress.c_str());
-    mikrotikRequest("POST", "/interface/wireless/connect-list/add", payload);
-    return comment;
+  void flush() override {
   }
-}
+};
 
-// Note: tmpfs management removed - writing directly to main storage instead
+// GET a RouterOS list and hand each element (reduced by the filter) to visit()
+// one at a time, so peak memory does not grow with the number of entries.
+// visit() returns false to stop early. Returns false when the request or the
+// parse fails.
+bool mikrotikForEach(const String& path, JsonDocument& filter,
+                     std::function<bool(JsonObject)> visit) {
+  if (!mikrotikSessionPrepare()) {
+    Serial.println("  ERROR: MikroTik IP not configured");
+    return false;
+  }
 
-// ==================== API HANDLER ====================
+  unsigned long startMs = millis();
+  int httpCode = mikrotikBeginRequest("GET", path, "", 15000);
+  if (httpCode <= 0) {
+    mikrotikEndRequest("GET", path, httpCode, startMs);
+    return false;
+  }
 
-void handleConfig() {
-  // Return configured band modes and runtime parameters to the frontend
-  StaticJsonDocument<256> doc;
-  doc["band_2ghz"] = runtimeConfig.band2ghz;
-  doc["band_5ghz"] = runtimeConfig.band5ghz;
-  doc["scan_duration_ms"] = runtimeConfig.scanDurationSeconds * 1000;
-  doc["scan_min_ready_ms"] = runtimeConfig.scanDurationSeconds * 1000;
-  doc["scan_result_grace_ms"] = SCAN_RESULT_GRACE_MS;
-  doc["scan_timeout_ms"] = runtimeConfig.scanDurationSeconds * 1000 + SCAN_RESULT_GRACE_MS + SCAN_POLL_INTERVAL_MS;
-  doc["scan_poll_interval_ms"] = SCAN_POLL_INTERVAL_MS;
-  doc["scan_csv_filename"] = SCAN_CSV_FILENAME;
-  doc["signal_min_dbm"] = SIGNAL_MIN_DBM;
-  doc["signal_max_dbm"] = SIGNAL_MAX_DBM;
+  HTTPClient& http = mikrotikSession().http;
+  bool chunked = http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+  HttpBodyStream body(mikrotikSession().client, http.getSize(), chunked);
 
-  String json;
-  serializeJson(doc, json);
-  server.send(200, "application/json", json);
-}
+  bool ok = httpCode == HTTP_CODE_OK && body.find('[');
+  while (ok) {
+    while (body.peek() == ' ' || body.peek() == '\r' || body.peek() == '\n') {
+      body.read();
+    }
+    if (body.peek() == ']') {
+      break;
+    }
 
-void handleSettingsGet() {
-  DynamicJsonDocument doc(1024);
+    StaticJsonDocument<JSON_BUFFER_STREAM_ELEMENT> element;
+    DeserializationError error = deserializeJson(element, body, DeserializationOption::Filter(filter));
+    if (error) {
+      Serial.printf("  ERROR: Failed to parse %s: %s\n", path.c_str(), error.c_str());
+      ok = false;
+      break;
+    }
+    if (!visit(element.as<JsonObject>())) {
+      break;
+    }
+    if (!body.findUntil(",", "]")) {
+      break;  // reached the closing bracket
+    }
+  }
 
-  JsonObject wifiObj = doc.createNestedObject("wifi");
-  wifiObj["ssid"] = runtimeConfig.wifiSsid;
-  wifiObj["has_password"] = runtimeConfig.wifiPassword.length() > 0;
+  if (ok) {
+    body.drain();
+  }
+  mikrotikEndRequest("GET", path, httpCode, startMs, ok && body.done);
+  return ok;
+}
 
-  JsonObject mikrotikObj = doc.createNestedObject("mikrotik");
-  mikrotikObj["ip"] = runtimeConfig.mikrotikIp;
-  mikrotikObj["user"] = runtimeConfig.mikrotikUser;
-  mikrotikObj["has_password"] = runtimeConfig.mikrotikPass.length() > 0;
-  mikrotikObj["wlan_interface"] = runtimeConfig.mikrotikWlanInterface;
+// Properties of the configured WLAN interface that user actions read or change
+struct WirelessInterfaceState {
+  String id;
+  String mode;
+  String ssid;
+  String band;
+  String securityProfile;
+  String stationRoaming;
+  bool disabled = false;
+};
 
-  JsonObject bandsObj = doc.createNestedObject("bands");
-  bandsObj["band_2ghz"] = runtimeConfig.band2ghz;
-  bandsObj["band_5ghz"] = runtimeConfig.band5ghz;
-  bandsObj["channel_width_2ghz"] = runtimeConfig.channelWidth2ghz;
-  bandsObj["channel_width_5ghz"] = runtimeConfig.channelWidth5ghz;
+// Last known state of the configured interface. Kept current by our own PATCHes
+// and the status refresh; dropped on errors and MikroTik settings changes.
+struct WirelessInterfaceCache {
+  WirelessInterfaceState state;
+  bool valid = false;
+  unsigned long updatedAt = 0;
+  unsigned long hitCount = 0;
+  unsigned long fetchCount = 0;
+};
 
-  JsonObject scanObj = doc.createNestedObject("scan");
-  scanObj["duration_seconds"] = runtimeConfig.scanDurationSeconds;
+WirelessInterfaceCache& wirelessInterfaceCache();
 
-  JsonObject wirelessObj = doc.createNestedObject("wireless");
-  wirelessObj["station_roaming"] = runtimeConfig.stationRoaming;
+void wirelessInterfaceCacheInvalidate() {
+  wirelessInterfaceCache().valid = false;
+}
 
-  JsonObject statusObj = doc.createNestedObject("status");
-  statusObj["wifi_connected"] = WiFi.status() == WL_CONNECTED;
-  statusObj["captive_portal"] = captivePortalActive;
-  statusObj["ap_ssid"] = CAPTIVE_PORTAL_SSID;
+void wirelessInterfaceCacheStore(const WirelessInterfaceState& state) {
+  wirelessInterfaceCache().state = state;
+  wirelessInterfaceCache().valid = true;
+  wirelessInterfaceCache().updatedAt = millis();
+}
 
-  String output;
-  serializeJson(doc, output);
-  server.send(200, "application/json", output);
+// Read interface properties (REST names) from an object: a GET element or a PATCH payload
+void wirelessInterfaceStateApply(WirelessInterfaceState& state, JsonObjectConst values) {
+  if (values.containsKey(".id")) state.id = values[".id"] | "";
+  if (values.containsKey("mode")) state.mode = values["mode"] | "";
+  if (values.containsKey("ssid")) state.ssid = values["ssid"] | "";
+  if (values.containsKey("band")) state.band = values["band"] | "";
+  if (values.containsKey("security-profile")) state.securityProfile = values["security-profile"] | "";
+  if (values.containsKey("station-roaming")) state.stationRoaming = values["station-roaming"] | "";
+  if (values.containsKey("disabled")) state.disabled = asBool(values["disabled"] | "false");
+}
+
+// Record the outcome of a PATCH we sent to the configured interface
+void wirelessInterfaceCacheAfterPatch(const String& response, JsonDocument& patch) {
+  if (!wirelessInterfaceCache().valid) {
+    return;
+  }
+  if (response.indexOf("\"error\"") != -1) {
+    wirelessInterfaceCacheInvalidate();
+    return;
+  }
+  wirelessInterfaceStateApply(wirelessInterfaceCache().state, patch.as<JsonObjectConst>());
+  wirelessInterfaceCache().updatedAt = millis();
+}
+
+bool fetchWirelessInterfaceState(const String& name, WirelessInterfaceCache& cache, WirelessInterfaceState& stateOut) {
+  StaticJsonDocument<160> filter;
+  filter[0][".id"] = true;
+  filter[0]["mode"] = true;
+  filter[0]["ssid"] = true;
+  filter[0]["band"] = true;
+  filter[0]["security-profile"] = true;
+  filter[0]["station-roaming"] = true;
+  filter[0]["disabled"] = true;
+
+  // Let the router pick the interface by name instead of sending the whole list
+  DynamicJsonDocument ifaceDoc(JSON_BUFFER_INTERFACES);
+  String path = "/interface/wireless?name=" + urlEncode(name) +
+                "&.proplist=.id,mode,ssid,band,security-profile,station-roaming,disabled";
+  if (!mikrotikGetFiltered(path, ifaceDoc, filter) || !ifaceDoc.is<JsonArray>() || ifaceDoc.size() == 0) {
+    Serial.printf("  ERROR: Configured interface '%s' not found on MikroTik\n", name.c_str());
+    return false;
+  }
+
+  stateOut = WirelessInterfaceState();
+  wirelessInterfaceStateApply(stateOut, ifaceDoc[0].as<JsonObjectConst>());
+  if (stateOut.id.length() == 0) {
+    Serial.println("  ERROR: Configured interface found but missing .id");
+    return false;
+  }
+  cache.fetchCount++;
+  cache.state = stateOut;
+  cache.valid = true;
+  cache.updatedAt = millis();
+  return true;
+}
+
+bool fetchWirelessInterfaceState(WirelessInterfaceState& stateOut) {
+  return fetchWirelessInterfaceState(targetConfig().wlanInterface, wirelessInterfaceCache(), stateOut);
+}
+
+// Cached interface state, fetched from the router only when nothing is cached
+bool getWirelessInterfaceState(WirelessInterfaceState& stateOut) {
+  if (wirelessInterfaceCache().valid) {
+    wirelessInterfaceCache().hitCount++;
+    stateOut = wirelessInterfaceCache().state;
+    return true;
+  }
+  return fetchWirelessInterfaceState(stateOut);
+}
+
+// Second radio of a dual-radio router (wlan_interface_2), only used for
+// scanning. Its band may be changed outside the dashboard, so the cached
+// state is re-read after SECOND_RADIO_CACHE_MS.
+WirelessInterfaceCache& secondRadioCache();
+
+bool getSecondRadioState(WirelessInterfaceState& stateOut) {
+  if (targetConfig().secondInterface.length() == 0) {
+    return false;
+  }
+  if (secondRadioCache().valid && millis() - secondRadioCache().updatedAt < SECOND_RADIO_CACHE_MS) {
+    secondRadioCache().hitCount++;
+    stateOut = secondRadioCache().state;
+    return true;
+  }
+  return fetchWirelessInterfaceState(targetConfig().secondInterface, secondRadioCache(), stateOut);
+}
+
+bool fetchConfiguredWirelessInterface(String& interfaceIdOut, String& currentBandOut) {
+  WirelessInterfaceState state;
+  if (!getWirelessInterfaceState(state)) {
+    return false;
+  }
+  interfaceIdOut = state.id;
+  currentBandOut = state.band;
+  return true;
+}
+
+// ==================== MANAGED ENTRY INDEX ====================
+
+const char* CONNECT_LIST_COMMENT_PREFIX = "wifi-manager:ssid=";
+
+// Local copy of the router's security profiles and our connect-list entries.
+// Populated on first use, updated by every write we make and resynced after
+// MANAGED_INDEX_RESYNC_MS, after a failed write or via POST /api/profiles/resync,
+// so lookups by SSID or profile name need no REST round trip.
+struct IndexedProfile {
+  String id;
+  String name;
+  String mode;
+  String authTypes;
+  String ssid;  // From the PROFILE_COMMENT_PREFIX comment; empty for foreign profiles
+  uint32_t pskHash = 0;  // fnv1aHash of the WPA2 key, 0 when unknown
+};
+
+struct IndexedConnectEntry {
+  String id;
+  String ssid;
+  String macAddress;
+  String interfaceName;
+  String securityProfile;
+  bool disabled = false;
+};
+
+struct ManagedIndex {
+  std::vector<IndexedProfile> profiles;
+  std::vector<IndexedConnectEntry> connectList;
+  bool valid = false;
+  unsigned long syncedAt = 0;
+  unsigned long syncCount = 0;
+  unsigned long hitCount = 0;
+};
+
+ManagedIndex& managedIndex();
+
+// Fields kept per security-profile / connect-list element when streaming
+JsonDocument& profileListFilter() {
+  static StaticJsonDocument<256> filter;
+  if (filter.isNull()) {
+    filter[".id"] = true;
+    filter["name"] = true;
+    filter["comment"] = true;
+    filter["mode"] = true;
+    filter["authentication-types"] = true;
+    filter["disabled"] = true;
+    filter["wpa2-pre-shared-key"] = true;
+    filter["mac-address"] = true;
+    filter["interface"] = true;
+    filter["security-profile"] = true;
+  }
+  return filter;
+}
+
+// Only a hash of the key is kept in RAM (the router omits it without the "sensitive" policy)
+uint32_t pskHash(const String& psk) {
+  return psk.length() > 0 ? fnv1aHash(psk.c_str(), psk.length()) : 0;
+}
+
+void managedIndexInvalidate() {
+  managedIndex().valid = false;
+}
+
+bool managedIndexSync() {
+  unsigned long startMs = millis();
+  managedIndex().valid = false;
+  managedIndex().profiles.clear();
+  managedIndex().connectList.clear();
+
+  size_t prefixLength = strlen(PROFILE_COMMENT_PREFIX);
+  bool ok = mikrotikForEach("/interface/wireless/security-profiles"
+                            "?.proplist=.id,name,comment,mode,authentication-types,wpa2-pre-shared-key",
+                            profileListFilter(), [&](JsonObject profile) {
+    IndexedProfile entry;
+    entry.id = profile[".id"] | "";
+    entry.name = profile["name"] | "";
+    entry.mode = profile["mode"] | "";
+    entry.authTypes = profile["authentication-types"] | "";
+    entry.pskHash = pskHash(profile["wpa2-pre-shared-key"] | "");
+    String comment = profile["comment"] | "";
+    if (comment.startsWith(PROFILE_COMMENT_PREFIX)) {
+      entry.ssid = comment.substring(prefixLength);
+    }
+    managedIndex().profiles.push_back(entry);
+    return true;
+  });
+  if (!ok) {
+    return false;
+  }
+
+  prefixLength = strlen(CONNECT_LIST_COMMENT_PREFIX);
+  ok = mikrotikForEach("/interface/wireless/connect-list?.proplist=.id,comment,disabled,mac-address,interface,security-profile",
+                       profileListFilter(), [&](JsonObject item) {
+    String comment = item["comment"] | "";
+    if (comment.startsWith(CONNECT_LIST_COMMENT_PREFIX)) {
+      IndexedConnectEntry entry;
+      entry.id = item[".id"] | "";
+      entry.ssid = comment.substring(prefixLength);
+      entry.disabled = asBool(item["disabled"] | "false");
+      entry.macAddress = item["mac-address"] | "";
+      entry.interfaceName = item["interface"] | "";
+      entry.securityProfile = item["security-profile"] | "";
+      managedIndex().connectList.push_back(entry);
+    }
+    return true;
+  });
+  if (!ok) {
+    return false;
+  }
+
+  managedIndex().valid = true;
+  managedIndex().syncedAt = millis();
+  managedIndex().syncCount++;
+  Serial.printf("  Managed index: %u profiles, %u connect-list entries (%lu ms)\n",
+                static_cast<unsigned>(managedIndex().profiles.size()),
+                static_cast<unsigned>(managedIndex().connectList.size()), millis() - startMs);
+  return true;
+}
+
+// Load the index on first use or when the resync interval has passed
+bool managedIndexEnsure() {
+  if (managedIndex().valid && millis() - managedIndex().syncedAt < MANAGED_INDEX_RESYNC_MS) {
+    managedIndex().hitCount++;
+    return true;
+  }
+  return managedIndexSync();
+}
+
+IndexedProfile* managedIndexFindProfile(const String& name, const String& ssid) {
+  for (IndexedProfile& profile : managedIndex().profiles) {
+    if ((name.length() > 0 && profile.name == name) || (ssid.length() > 0 && profile.ssid == ssid)) {
+      return &profile;
+    }
+  }
+  return nullptr;
+}
+
+void managedIndexRemoveProfile(const String& name) {
+  for (size_t i = 0; i < managedIndex().profiles.size(); i++) {
+    if (managedIndex().profiles[i].name == name) {
+      managedIndex().profiles.erase(managedIndex().profiles.begin() + i);
+      return;
+    }
+  }
+}
+
+IndexedConnectEntry* managedIndexFindConnectEntry(const String& ssid) {
+  for (IndexedConnectEntry& entry : managedIndex().connectList) {
+    if (entry.ssid == ssid) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void managedIndexRemoveConnectEntry(const String& id) {
+  for (size_t i = 0; i < managedIndex().connectList.size(); i++) {
+    if (managedIndex().connectList[i].id == id) {
+      managedIndex().connectList.erase(managedIndex().connectList.begin() + i);
+      return;
+    }
+  }
+}
+
+// Write responses carry {"error":...} on failure; the index is then resynced on next use
+bool mikrotikWriteSucceeded(const String& response) {
+  if (response.indexOf("\"error\"") != -1) {
+    managedIndexInvalidate();
+    return false;
+  }
+  return true;
+}
+
+// ".id" of an entry created via .../add ({"ret":"*1A"})
+String mikrotikCreatedId(const String& response) {
+  StaticJsonDocument<64> doc;
+  if (deserializeJson(doc, response)) {
+    return "";
+  }
+  return doc["ret"] | "";
+}
+
+// ==================== SECURITY PROFILE MANAGEMENT ====================
+
+// actionOut: "unchanged", "updated", "created" or "recreated"
+String ensureSecurityProfile(const String& ssid, const String& password, bool requiresPassword,
+                             bool known, const String& requestedProfileName, String& actionOut) {
+  // Use profile name from frontend or fall back to truncated SSID
+  String profileName = requestedProfileName;
+  if (profileName.length() == 0) {
+    profileName = "client-" + ssid.substring(0, min(20, (int)ssid.length()));
+  }
+
+  String comment = String(PROFILE_COMMENT_PREFIX) + ssid;
+
+  // Find matching profile if it already exists
+  managedIndexEnsure();
+  IndexedProfile* existing = managedIndexFindProfile(profileName, ssid);
+  bool profileExists = existing != nullptr;
+  String targetName = profileExists && existing->name.length() > 0 ? existing->name : profileName;
+  String existingMode = profileExists ? existing->mode : "";
+
+  // Determine desired security mode
+  String desiredMode = requiresPassword ? "dynamic-keys" : "none";
+  String desiredAuthTypes = requiresPassword ? "wpa-psk,wpa2-psk" : "";
+
+  // Skip the PATCH when the profile already matches (key unchanged or not supplied)
+  if (profileExists && existing->ssid == ssid && existingMode == desiredMode &&
+      existing->authTypes == desiredAuthTypes &&
+      (!requiresPassword || password.length() == 0 || existing->pskHash == pskHash(password))) {
+    actionOut = "unchanged";
+    return targetName;
+  }
+
+  // If profile exists but mode differs -> delete and recreate
+  bool needsRecreate = false;
+  if (profileExists && existingMode != desiredMode) {
+    String response = mikrotikRequest("DELETE", "/interface/wireless/security-profiles/" + targetName, "");
+    if (mikrotikWriteSucceeded(response)) {
+      managedIndexRemoveProfile(targetName);
+    }
+    profileExists = false;  // Mark as deleted
+    needsRecreate = true;
+  }
+
+  // Build payload
+  DynamicJsonDocument payloadDoc(JSON_BUFFER_SECURITY_PAYLOAD);
+  payloadDoc["comment"] = comment;
+
+  if (requiresPassword) {
+    payloadDoc["mode"] = "dynamic-keys";
+    payloadDoc["authentication-types"] = desiredAuthTypes;
+    if (password.length() > 0) {
+      payloadDoc["wpa-pre-shared-key"] = password;
+      payloadDoc["wpa2-pre-shared-key"] = password;
+    } else {
+      Serial.println("  WARNING: requiresPassword=true but password is empty!");
+    }
+  } else {
+    payloadDoc["mode"] = "none";
+    payloadDoc["authentication-types"] = "";
+    payloadDoc["wpa-pre-shared-key"] = "";
+    payloadDoc["wpa2-pre-shared-key"] = "";
+  }
+
+  String payload;
+  serializeJson(payloadDoc, payload);
+
+  // Update or create profile
+  if (profileExists && !needsRecreate) {
+    // Update existing profile (only when mode stays the same)
+    String response = mikrotikRequest("PATCH", "/interface/wireless/security-profiles/" + targetName, payload);
+    if (mikrotikWriteSucceeded(response)) {
+      if (IndexedProfile* updated = managedIndexFindProfile(targetName, "")) {
+        updated->ssid = ssid;
+        updated->authTypes = desiredAuthTypes;
+        if (password.length() > 0 || !requiresPassword) {
+          updated->pskHash = pskHash(password);
+        }
+      }
+    }
+    actionOut = "updated";
+    return targetName;
+  } else {
+    // Create new profile
+    if (requiresPassword && password.length() == 0) {
+      Serial.println("  ERROR: Password required for secured profile");
+      actionOut = "missing_password";
+      return profileName;
+    }
+    payloadDoc["name"] = profileName;
+    String createPayload;
+    serializeJson(payloadDoc, createPayload);
+    String response = mikrotikRequest("POST", "/interface/wireless/security-profiles/add", createPayload);
+    if (mikrotikWriteSucceeded(response) && managedIndex().valid) {
+      IndexedProfile created;
+      created.id = mikrotikCreatedId(response);
+      created.name = profileName;
+      created.mode = desiredMode;
+      created.authTypes = desiredAuthTypes;
+      created.ssid = ssid;
+      created.pskHash = pskHash(password);
+      managedIndex().profiles.push_back(created);
+    }
+    actionOut = needsRecreate ? "recreated" : "created";
+    return profileName;
+  }
+}
+
+// ==================== CONNECTION LIST MANAGEMENT ====================
+
+// Disable all connect-list entries (entries already disabled are skipped)
+void disableAllConnectionLists(const String& exceptSsid = "") {
+  if (!managedIndexEnsure()) {
+    Serial.println("  ERROR: Failed to read connect-list");
+    return;
+  }
+
+  for (IndexedConnectEntry& entry : managedIndex().connectList) {
+    if (entry.disabled || entry.id.length() == 0 || (exceptSsid.length() > 0 && entry.ssid == exceptSsid)) {
+      continue;
+    }
+    Serial.printf("  Disabling connect-list entry: %s\n", entry.id.c_str());
+    String response = mikrotikRequest("PATCH", "/interface/wireless/connect-list/" + entry.id, "{\"disabled\":\"yes\"}");
+    if (!mikrotikWriteSucceeded(response)) {
+      return;
+    }
+    entry.disabled = true;
+  }
+}
+
+// Delete connect-list for specific SSID
+// Returns the number of entries deleted
+int deleteConnectionList(const String& ssid) {
+  int deleted = 0;
+  if (!managedIndexEnsure()) {
+    Serial.println("  ERROR: Failed to read connect-list");
+    return deleted;
+  }
+
+  while (IndexedConnectEntry* entry = managedIndexFindConnectEntry(ssid)) {
+    String entryId = entry->id;
+    Serial.printf("  Deleting connect-list for SSID: %s\n", ssid.c_str());
+    String response = mikrotikRequest("DELETE", "/interface/wireless/connect-list/" + entryId, "");
+    if (!mikrotikWriteSucceeded(response)) {
+      break;
+    }
+    managedIndexRemoveConnectEntry(entryId);
+    deleted++;
+  }
+  return deleted;
+}
+
+// Ensure connection list exists for specific AP
+// actionOut: "unchanged", "updated" or "created"
+String ensureConnectionList(const String& ssid, const String& macAddress, const String& interfaceName,
+                            const String& securityProfile, String& actionOut) {
+  String comment = String(CONNECT_LIST_COMMENT_PREFIX) + ssid;
+
+  // First, disable all other connect-lists (the index is loaded here at the latest)
+  disableAllConnectionLists(ssid);
+  if (!managedIndex().valid) {
+    Serial.println("  ERROR: Failed to read connect-list");
+    return "";
+  }
+
+  // Check if entry already exists
+  IndexedConnectEntry* existing = managedIndexFindConnectEntry(ssid);
+  String existingId = existing != nullptr ? existing->id : "";
+
+  if (existing != nullptr && !existing->disabled && existing->macAddress.equalsIgnoreCase(macAddress) &&
+      existing->interfaceName == interfaceName && existing->securityProfile == securityProfile) {
+    actionOut = "unchanged";
+    return existingId;
+  }
+
+  // Build payload
+  DynamicJsonDocument payloadDoc(JSON_BUFFER_CONNECT_PAYLOAD);
+  payloadDoc["interface"] = interfaceName;
+  payloadDoc["ssid"] = ssid;
+  payloadDoc["mac-address"] = macAddress;
+  payloadDoc["security-profile"] = securityProfile;
+  payloadDoc["comment"] = comment;
+  payloadDoc["disabled"] = "no";
+
+  String payload;
+  serializeJson(payloadDoc, payload);
+
+  if (existingId.length() > 0) {
+    // Update existing entry
+    Serial.printf("  Updating connect-list for SSID: %s, MAC: %s\n", ssid.c_str(), macAddress.c_str());
+    String response = mikrotikRequest("PATCH", "/interface/wireless/connect-list/" + existingId, payload);
+    if (mikrotikWriteSucceeded(response)) {
+      existing->disabled = false;
+      existing->macAddress = macAddress;
+      existing->interfaceName = interfaceName;
+      existing->securityProfile = securityProfile;
+    }
+    actionOut = "updated";
+    return existingId;
+  } else {
+    // Create new entry
+    Serial.printf("  Creating connect-list for SSID: %s, MAC: %s\n", ssid.c_str(), macAddress.c_str());
+    String response = mikrotikRequest("POST", "/interface/wireless/connect-list/add", payload);
+    if (mikrotikWriteSucceeded(response)) {
+      IndexedConnectEntry created;
+      created.id = mikrotikCreatedId(response);
+      created.ssid = ssid;
+      created.macAddress = macAddress;
+      created.interfaceName = interfaceName;
+      created.securityProfile = securityProfile;
+      if (created.id.length() > 0) {
+        managedIndex().connectList.push_back(created);
+      } else {
+        managedIndexInvalidate();
+      }
+    }
+    actionOut = "created";
+    return comment;
+  }
+}
+
+// ==================== STATUS CACHE ====================
+
+// Shared /api/status snapshot: refreshed from loop() while clients are polling,
+// so any number of browser tabs cost one set of router requests per TTL.
+struct StatusCache {
+  bool valid = false;
+  bool stale = false;
+  String payload = "";
+  unsigned long refreshedAt = 0;
+  unsigned long lastClientRequest = 0;
+  unsigned long lastRefreshDurationMs = 0;
+  uint32_t payloadHash = 0;       // Over the digested fields; changes only when the status does
+  unsigned long unchangedCount = 0;
+  bool stationBusy = false;       // Connected, connecting or unknown: no background scans
+};
+
+StatusCache& statusCache();
+
+// Link quality samples of one target (lib/RouterParse/src/SignalHistory.h),
+// taken by the status refresh every HISTORY_SAMPLE_INTERVAL_MS
+struct LinkHistory {
+  SignalHistoryBuffer<HISTORY_CAPACITY> samples;
+  unsigned long sampledAt = 0;
+  bool sampled = false;
+};
+
+LinkHistory& linkHistory();
+
+bool linkHistoryDue(unsigned long now) {
+  return HISTORY_SAMPLE_INTERVAL_MS > 0 &&
+         (!linkHistory().sampled || now - linkHistory().sampledAt >= HISTORY_SAMPLE_INTERVAL_MS);
+}
+
+// Call under SharedStateLock. A refresh that failed only restarts the interval:
+// the gap shows in the sample ages rather than as a link drop.
+void recordLinkHistory(HistorySample sample, bool valid) {
+  unsigned long now = millis();
+  if (!linkHistoryDue(now)) {
+    return;
+  }
+  if (valid) {
+    sample.time = static_cast<uint16_t>(now / 1000);
+    signalHistoryAdd(linkHistory().samples, sample);
+  }
+  linkHistory().sampledAt = now;
+  linkHistory().sampled = true;
+}
+
+void clearLinkHistory() {
+  SharedStateLock lock;
+  signalHistoryClear(linkHistory().samples);
+  linkHistory().sampled = false;
+}
+
+// Bare hex form of the snapshot hash, as returned in X-Status-Version
+String statusVersionToken(uint32_t hash) {
+  char token[12];
+  snprintf(token, sizeof(token), "%08lx", static_cast<unsigned long>(hash));
+  return String(token);
+}
+
+// GET a RouterOS resource and keep only the fields selected by the filter
+bool mikrotikGetFiltered(const String& path, JsonDocument& doc, JsonDocument& filter) {
+  String response = mikrotikRequest("GET", path);
+  DeserializationError error = deserializeJson(doc, response, DeserializationOption::Filter(filter));
+  if (error) {
+    Serial.printf("  ERROR: Failed to parse %s: %s\n", path.c_str(), error.c_str());
+    return false;
+  }
+  return doc.is<JsonArray>() || doc.is<JsonObject>();
+}
+
+// Result of fetchStatusSnapshot(): the payload served by /api/status plus the
+// flags callers act on, so none of them has to search the serialized JSON
+struct StatusSnapshot {
+  String payload;
+  bool connected = false;
+  bool connecting = false;
+  bool failed = false;  // The router could not be read ("error" in the payload)
+  HistorySample link = {0, HISTORY_NO_SIGNAL, HISTORY_NO_CCQ, 0, 0};
+};
+
+// Digest the router state into the compact object the frontend renders
+// (connected, SSID, band, signal, IP, gateway, DNS). Only the properties we
+// need are requested via .proplist; address, route and DNS lookups are
+// skipped entirely while no link is up.
+StatusSnapshot fetchStatusSnapshot() {
+  StatusSnapshot snapshot;
+  StaticJsonDocument<768> out;
+  out["connected"] = false;
+
+  StaticJsonDocument<256> ifaceFilter;
+  ifaceFilter[0][".id"] = true;
+  ifaceFilter[0]["name"] = true;
+  ifaceFilter[0]["mode"] = true;
+  ifaceFilter[0]["ssid"] = true;
+  ifaceFilter[0]["band"] = true;
+  ifaceFilter[0]["security-profile"] = true;
+  ifaceFilter[0]["station-roaming"] = true;
+  ifaceFilter[0]["disabled"] = true;
+  ifaceFilter[0]["running"] = true;
+  DynamicJsonDocument ifaceDoc(JSON_BUFFER_STATUS);
+  if (!mikrotikGetFiltered("/interface/wireless?.proplist=.id,name,mode,ssid,band,security-profile,station-roaming,disabled,running",
+                           ifaceDoc, ifaceFilter)) {
+    out["error"] = "interfaces_unavailable";
+    snapshot.failed = true;
+    serializeJson(out, snapshot.payload);
+    return snapshot;
+  }
+
+  // Refresh the cached state of the configured interface while we have it
+  bool configuredFound = false;
+  for (JsonObject iface : ifaceDoc.as<JsonArray>()) {
+    String ifaceName = iface["name"] | "";
+    if (ifaceName == targetConfig().wlanInterface && iface.containsKey(".id")) {
+      WirelessInterfaceState state;
+      wirelessInterfaceStateApply(state, iface);
+      wirelessInterfaceCacheStore(state);
+      configuredFound = true;
+      break;
+    }
+  }
+  if (!configuredFound) {
+    wirelessInterfaceCacheInvalidate();
+  }
+
+  StaticJsonDocument<128> regFilter;
+  regFilter[0]["interface"] = true;
+  regFilter[0]["ssid"] = true;
+  regFilter[0]["radio-name"] = true;
+  regFilter[0]["signal-strength"] = true;
+  regFilter[0]["signal-to-noise"] = true;
+  regFilter[0]["tx-rate"] = true;
+  regFilter[0]["rx-rate"] = true;
+  regFilter[0]["tx-ccq"] = true;
+  DynamicJsonDocument regDoc(JSON_BUFFER_STATUS);
+  mikrotikGetFiltered("/interface/wireless/registration-table?.proplist=interface,ssid,radio-name,signal-strength,signal-to-noise,tx-rate,rx-rate,tx-ccq",
+                      regDoc, regFilter);
+
+  const char* activeInterface = statusDigestLink(ifaceDoc.as<JsonArrayConst>(), regDoc.as<JsonArrayConst>(), out);
+  snapshot.link = statusDigestLinkSample(regDoc.as<JsonArrayConst>(), activeInterface);
+  snapshot.connected = out["connected"] | false;
+  snapshot.connecting = out["connecting"] | false;
+
+  if (activeInterface[0] != '\0') {
+    // IP address (prefer dynamic/DHCP entries)
+    StaticJsonDocument<128> addrFilter;
+    addrFilter[0]["address"] = true;
+    addrFilter[0]["network"] = true;
+    addrFilter[0]["interface"] = true;
+    addrFilter[0]["actual-interface"] = true;
+    addrFilter[0]["dynamic"] = true;
+    DynamicJsonDocument addrDoc(JSON_BUFFER_STATUS);
+    if (mikrotikGetFiltered("/ip/address?.proplist=address,network,interface,actual-interface,dynamic", addrDoc, addrFilter)) {
+      statusDigestAddress(addrDoc.as<JsonArrayConst>(), activeInterface, out);
+    }
+
+    // Gateway: active default route via the wireless interface
+    StaticJsonDocument<128> routeFilter;
+    routeFilter[0]["dst-address"] = true;
+    routeFilter[0]["gateway"] = true;
+    routeFilter[0]["immediate-gw"] = true;
+    routeFilter[0]["active"] = true;
+    DynamicJsonDocument routeDoc(JSON_BUFFER_STATUS);
+    if (mikrotikGetFiltered("/ip/route?dst-address=0.0.0.0/0&.proplist=dst-address,gateway,immediate-gw,active", routeDoc, routeFilter)) {
+      statusDigestGateway(routeDoc.as<JsonArrayConst>(), activeInterface, out);
+    }
+
+    // DNS servers
+    StaticJsonDocument<64> dnsFilter;
+    dnsFilter["servers"] = true;
+    StaticJsonDocument<256> dnsDoc;
+    if (mikrotikGetFiltered("/ip/dns?.proplist=servers", dnsDoc, dnsFilter)) {
+      statusDigestDns(dnsDoc["servers"] | "", out);
+    }
+  }
+
+  serializeJson(out, snapshot.payload);
+  return snapshot;
+}
+
+void refreshStatusCache() {
+  unsigned long startMs = millis();
+  StatusSnapshot snapshot = fetchStatusSnapshot();
+  SharedStateLock lock;
+  recordLinkHistory(snapshot.link, !snapshot.failed);
+  statusCache().payload = snapshot.payload;
+  statusCache().payloadHash = fnv1aHash(snapshot.payload.c_str(), snapshot.payload.length());
+  statusCache().stationBusy = snapshot.connected || snapshot.connecting || snapshot.failed;
+  statusCache().refreshedAt = millis();
+  statusCache().lastRefreshDurationMs = statusCache().refreshedAt - startMs;
+  statusCache().valid = true;
+  statusCache().stale = false;
+}
+
+// Mark the snapshot outdated after we changed the router (served until refreshed)
+void invalidateStatusCache() {
+  statusCache().stale = true;
+}
+
+// Forget the snapshot entirely (router or credentials changed)
+void clearStatusCache() {
+  SharedStateLock lock;
+  statusCache().valid = false;
+  statusCache().stale = false;
+  statusCache().payload = "";
+  statusCache().payloadHash = 0;
+}
+
+void handleStatusCacheTasks() {
+  if (captivePortalActive || WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+
+  unsigned long now = millis();
+  // Nobody is watching: only the history samples keep talking to the router
+  if (!statusCache().valid || now - statusCache().lastClientRequest > STATUS_CACHE_IDLE_MS) {
+    if (linkHistoryDue(now)) {
+      refreshStatusCache();
+    }
+    return;
+  }
+
+  if (statusCache().stale || now - statusCache().refreshedAt >= STATUS_CACHE_TTL_MS) {
+    refreshStatusCache();
+  }
+}
+
+// Note: tmpfs management removed - writing directly to main storage instead
+
+// ==================== EVENT STREAM ====================
+
+// GET /api/events is a Server-Sent Events stream. Each open dashboard keeps
+// one connection and gets pushed what it would otherwise poll for:
+//   status       the /api/status snapshot, whenever it changes
+//   scan         progress of the running scan, or its failure
+//   scan-result  the finished /api/scan/result table
+// all for the target selected when the stream was opened (?target=).
+// The socket is taken over from WebServer (like a deferred request) and only
+// written from loop(), so a slow browser never holds up the router task.
+struct EventClient {
+  WiFiClient client;
+  bool active = false;
+  size_t target = 0;
+  unsigned long lastWriteAt = 0;
+  uint32_t statusHash = 0;
+  String scanKey = "";
+  uint32_t resultHash = 0;
+};
+
+EventClient eventClients[SSE_MAX_CLIENTS];
+unsigned long eventsSent = 0;
+unsigned long eventsDropped = 0;
+unsigned long lastEventCheck = 0;
+
+int eventClientCount() {
+  int count = 0;
+  for (const auto& eventClient : eventClients) {
+    if (eventClient.active) count++;
+  }
+  return count;
+}
+
+void eventClientClose(EventClient& eventClient) {
+  eventClient.client.stop();
+  eventClient.client = WiFiClient();
+  eventClient.active = false;
+  eventClient.scanKey = "";
+}
+
+// Write raw bytes; a short write means the browser is gone or stuck
+bool eventClientWrite(EventClient& eventClient, const uint8_t* data, size_t length) {
+  size_t written = eventClient.client.write(data, length);
+  if (written != length) {
+    Serial.println("  Event client dropped (write failed)");
+    eventsDropped++;
+    eventClientClose(eventClient);
+    return false;
+  }
+  eventClient.lastWriteAt = millis();
+  return true;
+}
+
+bool eventClientWrite(EventClient& eventClient, const char* text) {
+  return eventClientWrite(eventClient, reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+bool eventClientSend(EventClient& eventClient, const char* event, const String& data) {
+  // Payloads are serialized JSON and never contain newlines, so one data: line is enough
+  ScratchScope scratch;
+  size_t length = 0;
+  const char* head = scratch.format(length, "event: %s\ndata: ", event);
+  if (!eventClientWrite(eventClient, reinterpret_cast<const uint8_t*>(head), length) ||
+      !eventClientWrite(eventClient, reinterpret_cast<const uint8_t*>(data.c_str()), data.length()) ||
+      !eventClientWrite(eventClient, reinterpret_cast<const uint8_t*>("\n\n"), 2)) {
+    return false;
+  }
+  eventsSent++;
+  return true;
+}
+
+// Identifies what the "scan" event would say; a new event goes out when it changes.
+// Caller holds the shared state lock.
+String scanEventKey() {
+  if (scanState().isScanning) {
+    StaticJsonDocument<192> doc;
+    describeScanProgress(doc);
+    return String(scanState().startTime) + ":" + doc["stage"].as<const char*>() + ":" +
+           String(doc["attempts"].as<int>());
+  }
+  if (scanState().errorStatus.length() > 0) {
+    return String(scanState().startTime) + ":" + scanState().errorStatus;
+  }
+  return "";
+}
+
+String scanEventPayload() {
+  StaticJsonDocument<256> doc;
+  if (scanState().isScanning) {
+    describeScanProgress(doc);
+  } else {
+    doc["status"] = scanState().errorStatus;
+    doc["error"] = scanState().error;
+  }
+  String payload;
+  serializeJson(doc, payload);
+  return payload;
+}
+
+void handleEvents() {
+  if (!ensureOperationAllowed()) return;
+
+  EventClient* slot = nullptr;
+  for (auto& eventClient : eventClients) {
+    if (!eventClient.active) {
+      slot = &eventClient;
+      break;
+    }
+  }
+  if (slot == nullptr) {
+    server.send(503, "application/json", "{\"error\":\"busy\"}");
+    return;
+  }
+
+  slot->client = server.detachClient();
+  slot->active = true;
+  slot->target = currentTargetIndex();
+  slot->statusHash = 0;  // Current snapshot goes out with the first check
+  {
+    // Old scan results and failures are not replayed to new clients
+    SharedStateLock lock;
+    slot->scanKey = scanEventKey();
+    slot->resultHash = scanState().hasResult ? scanState().resultHash : 0;
+  }
+
+  // retry: tells EventSource how soon to reconnect after a drop
+  eventClientWrite(*slot, "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: text/event-stream\r\n"
+                          "Cache-Control: no-cache\r\n"
+                          "Access-Control-Allow-Origin: *\r\n"
+                          "Connection: keep-alive\r\n\r\n"
+                          "retry: 3000\n\n");
+  statusCache().lastClientRequest = millis();
+  Serial.printf("Event client connected (%d/%d)\n", eventClientCount(), SSE_MAX_CLIENTS);
+}
+
+// Push changes of one target to the clients watching it
+void handleTargetEventTasks(size_t target, unsigned long now) {
+  TargetScope scope(target);
+
+  // An open stream counts as a watching client: keep the snapshot fresh
+  statusCache().lastClientRequest = now;
+
+  // Copy only what some client is missing; the writes happen without the lock
+  uint32_t statusHash = 0;
+  uint32_t resultHash = 0;
+  String scanKey;
+  String statusPayload;
+  String scanPayload;
+  String resultPayload;
+  {
+    SharedStateLock lock;
+    statusHash = statusCache().valid ? statusCache().payloadHash : 0;
+    // A benchmark download is not the user's scan: nothing to push until it is restored
+    if (!scanState().benchmark) {
+      resultHash = scanState().hasResult ? scanState().resultHash : 0;
+      scanKey = scanEventKey();
+    }
+
+    bool needStatus = false;
+    bool needScan = false;
+    bool needResult = false;
+    for (const auto& eventClient : eventClients) {
+      if (!eventClient.active || eventClient.target != target) continue;
+      needStatus = needStatus || (statusHash != 0 && eventClient.statusHash != statusHash);
+      needScan = needScan || (scanKey.length() > 0 && eventClient.scanKey != scanKey);
+      needResult = needResult || (resultHash != 0 && eventClient.resultHash != resultHash);
+    }
+    if (needStatus) statusPayload = statusCache().payload;
+    if (needScan) scanPayload = scanEventPayload();
+    if (needResult) resultPayload = scanState().result;
+  }
+
+  for (auto& eventClient : eventClients) {
+    if (!eventClient.active || eventClient.target != target) continue;
+
+    if (statusPayload.length() > 0 && eventClient.statusHash != statusHash) {
+      if (!eventClientSend(eventClient, "status", statusPayload)) continue;
+      eventClient.statusHash = statusHash;
+    }
+    if (scanPayload.length() > 0 && eventClient.scanKey != scanKey) {
+      if (!eventClientSend(eventClient, "scan", scanPayload)) continue;
+      eventClient.scanKey = scanKey;
+    }
+    if (resultPayload.length() > 0 && eventClient.resultHash != resultHash) {
+      if (!eventClientSend(eventClient, "scan-result", resultPayload)) continue;
+      eventClient.resultHash = resultHash;
+    }
+
+    // SSE comment line keeps proxies and the browser from timing out an idle stream
+    if (now - eventClient.lastWriteAt >= SSE_KEEPALIVE_MS) {
+      eventClientWrite(eventClient, ": keepalive\n\n");
+    }
+  }
+}
+
+void handleEventTasks() {
+  unsigned long now = millis();
+  if (now - lastEventCheck < SSE_CHECK_INTERVAL_MS) {
+    return;
+  }
+  lastEventCheck = now;
+
+  bool watched[ROUTER_TARGETS_MAX] = {};
+  for (auto& eventClient : eventClients) {
+    if (eventClient.active && !eventClient.client.connected()) {
+      eventClientClose(eventClient);
+    }
+    if (eventClient.active && eventClient.target < ROUTER_TARGETS_MAX) {
+      watched[eventClient.target] = true;
+    }
+  }
+  for (size_t target = 0; target < ROUTER_TARGETS_MAX; target++) {
+    if (watched[target]) {
+      handleTargetEventTasks(target, now);
+    }
+  }
+}
+
+// ==================== API HANDLER ====================
+
+void handleConfig() {
+  // Return configured band modes and runtime parameters to the frontend
+  String json;
+  {
+    SharedStateLock lock;
+    StaticJsonDocument<640> doc;
+    doc["band_2ghz"] = runtimeConfig.band2ghz;
+    doc["band_5ghz"] = runtimeConfig.band5ghz;
+    doc["scan_duration_ms"] = runtimeConfig.scanDurationSeconds * 1000;
+    doc["scan_min_ready_ms"] = runtimeConfig.scanDurationSeconds * 1000;
+    doc["scan_result_grace_ms"] = SCAN_RESULT_GRACE_MS;
+    doc["scan_timeout_ms"] = runtimeConfig.scanDurationSeconds * 1000 + SCAN_RESULT_GRACE_MS + SCAN_POLL_INTERVAL_MS;
+    doc["scan_poll_interval_ms"] = SCAN_POLL_INTERVAL_MS;
+    doc["scan_csv_filename"] = targetScanFilename();
+    doc["scan_mode"] = runtimeConfig.scanMode;
+    doc["scan_scheduler_interval_ms"] = SCAN_SCHEDULER_INTERVAL_MS;
+    doc["signal_min_dbm"] = SIGNAL_MIN_DBM;
+    doc["signal_max_dbm"] = SIGNAL_MAX_DBM;
+
+    // Selectable with ?target=<name> on every API call
+    doc["target"] = routerTargetConfigAt(currentTargetIndex()).name;
+    JsonArray targetsArr = doc.createNestedArray("targets");
+    for (size_t i = 0; i < routerTargetCount(); i++) {
+      RouterTargetConfig config = routerTargetConfigAt(i);
+      JsonObject targetObj = targetsArr.createNestedObject();
+      targetObj["name"] = config.name;
+      targetObj["wlan_interface"] = config.wlanInterface;
+    }
+
+    serializeJson(doc, json);
+  }
+  server.send(200, "application/json", json);
+}
+
+void handleDiagnostics() {
+  StaticJsonDocument<3584> doc;
+
+  doc["target"] = targetConfig().name;
+  JsonArray targetsArr = doc.createNestedArray("targets");
+  {
+    SharedStateLock lock;
+    for (size_t i = 0; i < routerTargetCount(); i++) {
+      RouterTargetConfig config = routerTargetConfigAt(i);
+      JsonObject targetObj = targetsArr.createNestedObject();
+      targetObj["name"] = config.name;
+      targetObj["ip"] = config.ip;
+      targetObj["wlan_interface"] = config.wlanInterface;
+      targetObj["queued"] = routerTasks[i].queue != nullptr ? uxQueueMessagesWaiting(routerTasks[i].queue) : 0;
+      targetObj["processed"] = routerTasks[i].processed;
+      targetObj["rejected"] = routerTasks[i].rejected;
+      targetObj["coalesced"] = routerTasks[i].coalesced;
+    }
+  }
+
+  JsonObject sessionObj = doc.createNestedObject("mikrotik_session");
+  sessionObj["requests"] = mikrotikSession().requestCount;
+  sessionObj["failures"] = mikrotikSession().failureCount;
+  sessionObj["reconnects"] = mikrotikSession().reconnectCount;
+  sessionObj["reused"] = mikrotikSession().reusedCount;
+  sessionObj["total_ms"] = mikrotikSession().totalRequestMs;
+  sessionObj["avg_ms"] = mikrotikSession().requestCount > 0 ? mikrotikSession().totalRequestMs / mikrotikSession().requestCount : 0;
+  sessionObj["max_ms"] = mikrotikSession().maxRequestMs;
+  sessionObj["last_ms"] = mikrotikSession().lastRequestMs;
+  sessionObj["last_code"] = mikrotikSession().lastHttpCode;
+  sessionObj["last_request"] = static_cast<const char*>(mikrotikSession().lastRequest);
+  sessionObj["connected"] = static_cast<bool>(mikrotikSession().client.connected());
+
+  JsonObject statusObj = doc.createNestedObject("status_cache");
+  statusObj["valid"] = statusCache().valid;
+  statusObj["age_ms"] = statusCache().valid ? millis() - statusCache().refreshedAt : 0;
+  statusObj["refresh_ms"] = statusCache().lastRefreshDurationMs;
+  statusObj["ttl_ms"] = STATUS_CACHE_TTL_MS;
+  statusObj["version"] = statusVersionToken(statusCache().payloadHash);
+  statusObj["unchanged"] = statusCache().unchangedCount;
+
+  describeScanScheduler(doc.createNestedObject("scan_scheduler"));
+
+  JsonObject eventsObj = doc.createNestedObject("events");
+  eventsObj["clients"] = eventClientCount();
+  eventsObj["max_clients"] = SSE_MAX_CLIENTS;
+  eventsObj["sent"] = eventsSent;
+  eventsObj["dropped"] = eventsDropped;
+
+  JsonObject scanObj = doc.createNestedObject("scan_cache");
+  scanObj["valid"] = scanState().hasResult;
+  scanObj["age_ms"] = scanState().hasResult ? millis() - scanState().resultTimestamp : 0;
+  scanObj["bytes"] = scanState().result.length();
+  scanObj["hits"] = scanState().cacheHits;
+  scanObj["not_modified"] = scanState().notModifiedCount;
+  scanObj["last_scan_ms"] = scanState().lastScanDurationMs;
+  scanObj["mode"] = runtimeConfig.scanMode;
+
+  JsonObject indexObj = doc.createNestedObject("managed_index");
+  indexObj["valid"] = managedIndex().valid;
+  indexObj["age_ms"] = managedIndex().valid ? millis() - managedIndex().syncedAt : 0;
+  indexObj["profiles"] = managedIndex().profiles.size();
+  indexObj["connect_entries"] = managedIndex().connectList.size();
+  indexObj["syncs"] = managedIndex().syncCount;
+  indexObj["hits"] = managedIndex().hitCount;
+
+  const RouterTaskSlot& task = routerTasks[currentTargetIndex()];
+  JsonObject taskObj = doc.createNestedObject("router_task");
+  taskObj["enabled"] = task.queue != nullptr;
+  taskObj["queued"] = task.queue != nullptr ? uxQueueMessagesWaiting(task.queue) : 0;
+  taskObj["processed"] = task.processed;
+  taskObj["rejected"] = task.rejected;
+  taskObj["coalesced"] = task.coalesced;
+  taskObj["shared_router_requests"] = routerFlightsShared;
+  taskObj["max_wait_ms"] = task.maxWaitMs;
+  taskObj["max_run_ms"] = task.maxRunMs;
+  taskObj["last_command"] = task.lastCommand;
+  taskObj["paused"] = routerTaskPaused;
+  if (task.handle != nullptr) {
+    taskObj["stack_size"] = ROUTER_TASK_STACK_SIZE;
+    taskObj["stack_free"] = uxTaskGetStackHighWaterMark(task.handle);
+  }
+
+  JsonObject ifaceObj = doc.createNestedObject("wlan_interface");
+  ifaceObj["valid"] = wirelessInterfaceCache().valid;
+  ifaceObj["id"] = wirelessInterfaceCache().state.id;
+  ifaceObj["band"] = wirelessInterfaceCache().state.band;
+  ifaceObj["age_ms"] = wirelessInterfaceCache().valid ? millis() - wirelessInterfaceCache().updatedAt : 0;
+  ifaceObj["hits"] = wirelessInterfaceCache().hitCount;
+  ifaceObj["fetches"] = wirelessInterfaceCache().fetchCount;
+
+  doc["free_heap"] = ESP.getFreeHeap();
+  JsonObject heapObj = doc.createNestedObject("heap");
+  heapObj["free"] = ESP.getFreeHeap();
+  heapObj["min_free"] = ESP.getMinFreeHeap();
+  heapObj["largest_block"] = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  JsonArray arenasArr = heapObj.createNestedArray("scratch");
+  for (const ScratchArena& arena : scratchArenas) {
+    JsonObject arenaObj = arenasArr.createNestedObject();
+    arenaObj["size"] = sizeof(arena.buffer);
+    arenaObj["high_water"] = arena.highWater;
+    arenaObj["overflows"] = arena.overflows;
+  }
+  doc["uptime_ms"] = millis();
+
+  String json;
+  serializeJson(doc, json);
+  apiSend(200, "application/json", json);
+}
+
+void handleSettingsGet() {
+  String output;
+  {
+    SharedStateLock lock;
+    DynamicJsonDocument doc(1536);
+
+    JsonObject wifiObj = doc.createNestedObject("wifi");
+    wifiObj["ssid"] = runtimeConfig.wifiSsid;
+    wifiObj["has_password"] = runtimeConfig.wifiPassword.length() > 0;
+
+    JsonObject mikrotikObj = doc.createNestedObject("mikrotik");
+    mikrotikObj["ip"] = runtimeConfig.mikrotikIp;
+    mikrotikObj["user"] = runtimeConfig.mikrotikUser;
+    mikrotikObj["has_password"] = runtimeConfig.mikrotikPass.length() > 0;
+    mikrotikObj["wlan_interface"] = runtimeConfig.mikrotikWlanInterface;
+    mikrotikObj["wlan_interface_2"] = runtimeConfig.mikrotikSecondInterface;
+
+    JsonArray targetsArr = doc.createNestedArray("targets");
+    for (const RouterTargetConfig& target : runtimeConfig.extraTargets) {
+      JsonObject targetObj = targetsArr.createNestedObject();
+      targetObj["name"] = target.name;
+      targetObj["ip"] = target.ip;
+      targetObj["user"] = target.user;
+      targetObj["has_password"] = target.pass.length() > 0;
+      targetObj["wlan_interface"] = target.wlanInterface;
+      targetObj["wlan_interface_2"] = target.secondInterface;
+    }
+
+    JsonObject bandsObj = doc.createNestedObject("bands");
+    bandsObj["band_2ghz"] = runtimeConfig.band2ghz;
+    bandsObj["band_5ghz"] = runtimeConfig.band5ghz;
+    bandsObj["channel_width_2ghz"] = runtimeConfig.channelWidth2ghz;
+    bandsObj["channel_width_5ghz"] = runtimeConfig.channelWidth5ghz;
+
+    JsonObject scanObj = doc.createNestedObject("scan");
+    scanObj["duration_seconds"] = runtimeConfig.scanDurationSeconds;
+    scanObj["mode"] = runtimeConfig.scanMode;
+
+    JsonObject wirelessObj = doc.createNestedObject("wireless");
+    wirelessObj["station_roaming"] = runtimeConfig.stationRoaming;
+
+    JsonObject statusObj = doc.createNestedObject("status");
+    statusObj["wifi_connected"] = WiFi.status() == WL_CONNECTED;
+    statusObj["captive_portal"] = captivePortalActive;
+    statusObj["ap_ssid"] = CAPTIVE_PORTAL_SSID;
+
+    serializeJson(doc, output);
+  }
+  server.send(200, "application/json", output);
+}
+
+// Parse and apply a settings update under the caller's lock; the response
+// body goes to `output` and is sent once the lock is released
+int applySettingsUpdate(const String& body, String& output) {
+  DynamicJsonDocument doc(2560);
+  DeserializationError error = deserializeJson(doc, body);
+  if (error) {
+    output = "{\"error\":\"Invalid JSON\"}";
+    return 400;
+  }
+
+  bool wifiChanged = false;
+  bool mikrotikChanged = false;
+  bool bandsChanged = false;
+  bool scanChanged = false;
+  bool wirelessChanged = false;
+
+  JsonObject wifiObj = doc["wifi"].as<JsonObject>();
+  if (!wifiObj.isNull()) {
+    if (wifiObj.containsKey("ssid")) {
+      String newSsid = wifiObj["ssid"].as<String>();
+      newSsid.trim();
+      if (newSsid != runtimeConfig.wifiSsid) {
+        runtimeConfig.wifiBssid = "";
+        runtimeConfig.wifiChannel = 0;
+      }
+      runtimeConfig.wifiSsid = newSsid;
+      wifiChanged = true;
+    }
+    if (wifiObj.containsKey("password")) {
+      if (wifiObj["password"].is<String>()) {
+        runtimeConfig.wifiPassword = wifiObj["password"].as<String>();
+        wifiChanged = true;
+      }
+    }
+  }
+
+  JsonObject mikrotikObj = doc["mikrotik"].as<JsonObject>();
+  if (!mikrotikObj.isNull()) {
+    if (mikrotikObj.containsKey("ip")) {
+      String newIp = mikrotikObj["ip"].as<String>();
+      newIp.trim();
+      runtimeConfig.mikrotikIp = newIp;
+      mikrotikChanged = true;
+    }
+    if (mikrotikObj.containsKey("user")) {
+      String newUser = mikrotikObj["user"].as<String>();
+      newUser.trim();
+      runtimeConfig.mikrotikUser = newUser;
+      mikrotikChanged = true;
+    }
+    if (mikrotikObj.containsKey("password")) {
+      if (mikrotikObj["password"].is<String>()) {
+        runtimeConfig.mikrotikPass = mikrotikObj["password"].as<String>();
+        mikrotikChanged = true;
+      }
+    }
+    if (mikrotikObj.containsKey("wlan_interface")) {
+      String newIface = mikrotikObj["wlan_interface"].as<String>();
+      newIface.trim();
+      runtimeConfig.mikrotikWlanInterface = newIface;
+      mikrotikChanged = true;
+    }
+    if (mikrotikObj.containsKey("wlan_interface_2")) {
+      String newSecond = mikrotikObj["wlan_interface_2"].as<String>();
+      newSecond.trim();
+      runtimeConfig.mikrotikSecondInterface = newSecond;
+      mikrotikChanged = true;
+    }
+  }
+
+  // "targets" replaces the whole list of additional routers
+  if (doc["targets"].is<JsonArray>()) {
+    std::vector<RouterTargetConfig> previous = runtimeConfig.extraTargets;
+    parseRouterTargets(doc["targets"].as<JsonArrayConst>(), previous, runtimeConfig.extraTargets);
+    mikrotikChanged = true;
+  }
+
+  JsonObject bandsObj = doc["bands"].as<JsonObject>();
+  if (!bandsObj.isNull()) {
+    if (bandsObj.containsKey("band_2ghz")) {
+      String newBand2 = bandsObj["band_2ghz"].as<String>();
+      newBand2.trim();
+      runtimeConfig.band2ghz = newBand2;
+      bandsChanged = true;
+    }
+    if (bandsObj.containsKey("band_5ghz")) {
+      String newBand5 = bandsObj["band_5ghz"].as<String>();
+      newBand5.trim();
+      runtimeConfig.band5ghz = newBand5;
+      bandsChanged = true;
+    }
+    if (bandsObj.containsKey("channel_width_2ghz")) {
+      String newCw2 = bandsObj["channel_width_2ghz"].as<String>();
+      newCw2.trim();
+      runtimeConfig.channelWidth2ghz = newCw2;
+      bandsChanged = true;
+    }
+    if (bandsObj.containsKey("channel_width_5ghz")) {
+      String newCw5 = bandsObj["channel_width_5ghz"].as<String>();
+      newCw5.trim();
+      runtimeConfig.channelWidth5ghz = newCw5;
+      bandsChanged = true;
+    }
+  }
+
+  JsonObject scanObj = doc["scan"].as<JsonObject>();
+  if (!scanObj.isNull()) {
+    if (scanObj.containsKey("duration_seconds")) {
+      int newDuration = scanObj["duration_seconds"] | runtimeConfig.scanDurationSeconds;
+      if (newDuration <= 0) {
+        output = "{\"error\":\"invalid_scan_duration\"}";
+        return 400;
+      }
+      runtimeConfig.scanDurationSeconds = newDuration;
+      scanChanged = true;
+    }
+    if (scanObj.containsKey("mode")) {
+      String newMode = scanObj["mode"].as<String>();
+      newMode.trim();
+      if (!isValidScanMode(newMode)) {
+        output = "{\"error\":\"invalid_scan_mode\"}";
+        return 400;
+      }
+      runtimeConfig.scanMode = newMode;
+      scanChanged = true;
+    }
+  }
+
+  JsonObject wirelessObj = doc["wireless"].as<JsonObject>();
+  if (!wirelessObj.isNull()) {
+    if (wirelessObj.containsKey("station_roaming")) {
+      runtimeConfig.stationRoaming = wirelessObj["station_roaming"] | runtimeConfig.stationRoaming;
+      wirelessChanged = true;
+    }
+  }
+
+  if (!(wifiChanged || mikrotikChanged || bandsChanged || scanChanged || wirelessChanged)) {
+    DynamicJsonDocument response(128);
+    response["success"] = true;
+    response["wifi_changed"] = false;
+    response["mikrotik_changed"] = false;
+    response["bands_changed"] = false;
+    response["captive_portal"] = captivePortalActive;
+    serializeJson(response, output);
+    return 200;
+  }
+
+  markConfigDirty();
+
+  if (mikrotikChanged) {
+    // Every target resyncs on its own task; this one right away
+    routerTargetsGeneration++;
+    routerTargetSync();
+  }
+
+  if (wifiChanged) {
+    // WiFi mode changes belong to loop(), which owns the WiFi state machine
+    runOnLoop([]() {
+      wifiReconnectPending = true;
+      wifiUseCachedAp = true;
+      lastReconnectAttempt = 0;
+      startCaptivePortal();
+    });
+  }
+
+  DynamicJsonDocument response(256);
+  response["success"] = true;
+  response["wifi_changed"] = wifiChanged;
+  response["mikrotik_changed"] = mikrotikChanged;
+  response["bands_changed"] = bandsChanged;
+  response["scan_changed"] = scanChanged;
+  response["wireless_changed"] = wirelessChanged;
+  // startCaptivePortal() runs on loop() after this response: report the portal it is about to open
+  response["captive_portal"] = captivePortalActive || wifiChanged;
+
+  serializeJson(response, output);
+  return 200;
 }
 
 void handleSettingsUpdate() {
-  String body = server.arg("plain");
+  String body = apiArg("plain");
+  String output;
+  int code;
+  {
+    SharedStateLock lock;
+    code = applySettingsUpdate(body, output);
+  }
+  apiSend(code, "application/json", output);
+}
+
+// ==================== OTA SUPPORT ====================
+
+void setupArduinoOTA() {
+  if (!OTA_ENABLE || otaServiceReady || WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+
+  ArduinoOTA.setHostname(OTA_HOSTNAME);
+  if (OTA_PASSWORD != nullptr && OTA_PASSWORD[0] != '\0') {
+    ArduinoOTA.setPassword(OTA_PASSWORD);
+  }
+
+  ArduinoOTA.onStart([]() {
+    const char* type = ArduinoOTA.getCommand() == U_FLASH ? "firmware" : "filesystem";
+    Serial.printf("ArduinoOTA update started (%s)\n", type);
+    routerTaskPaused = true;  // Leave the radio to the upload
+    flushConfig();            // Pending settings must not be lost to the restart
+  });
+
+  ArduinoOTA.onEnd([]() {
+    Serial.println("ArduinoOTA update finished, restarting...");
+  });
+
+  ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
+    if (total == 0) {
+      return;
+    }
+    unsigned int percent = (progress * 100U) / total;
+    Serial.printf("ArduinoOTA progress: %u%%\n", percent);
+  });
+
+  ArduinoOTA.onError([](ota_error_t error) {
+    Serial.printf("ArduinoOTA error[%u]\n", static_cast<unsigned int>(error));
+    routerTaskPaused = false;
+    switch (error) {
+      case OTA_AUTH_ERROR:
+        Serial.println("  → Auth failed");
+        break;
+      case OTA_BEGIN_ERROR:
+        Serial.println("  → Begin failed");
+        break;
+      case OTA_CONNECT_ERROR:
+        Serial.println("  → Connect failed");
+        break;
+      case OTA_RECEIVE_ERROR:
+        Serial.println("  → Receive failed");
+        break;
+      case OTA_END_ERROR:
+        Serial.println("  → Finalize failed");
+        break;
+      default:
+        Serial.println("  → Unknown error");
+        break;
+    }
+  });
+
+  ArduinoOTA.begin();
+  otaServiceReady = true;
+  Serial.printf("ArduinoOTA ready (hostname: %s)\n", OTA_HOSTNAME);
+}
+
+void handleStatus() {
+  if (!ensureOperationAllowed()) return;
+  statusCache().lastClientRequest = millis();
+
+  // First client after boot (or after idling) fetches synchronously,
+  // on the router task when it is enabled
+  unsigned long age = millis() - statusCache().refreshedAt;
+  if (!statusCache().valid || age > STATUS_CACHE_IDLE_MS) {
+    if (deferToRouterTask(handleStatus)) {
+      return;
+    }
+    refreshStatusCache();
+    age = 0;
+  }
+
+  // The snapshot hash doubles as version token: browsers revalidate with
+  // If-None-Match (304), scripts pass ?since=<version> and get {"unchanged":true}.
+  // The payload is copied under the lock and sent after it, so a stalled
+  // client cannot hold up the router tasks.
+  String version;
+  String etag;
+  String payload;
+  bool notModified = false;
+  bool unchanged = false;
+  {
+    SharedStateLock lock;
+    version = statusVersionToken(statusCache().payloadHash);
+    etag = makeEtag(statusCache().payloadHash, "-s");
+    notModified = clientHasEtag(etag);
+    unchanged = !notModified && apiArg("since") == version;
+    if (notModified || unchanged) {
+      statusCache().unchangedCount++;
+    } else {
+      payload = statusCache().payload;
+    }
+  }
+
+  apiSendHeader("X-Status-Age", String(age));
+  apiSendHeader("X-Status-Version", version);
+  apiSendHeader("ETag", etag);
+  apiSendHeader("Cache-Control", "no-cache");
+  if (notModified) {
+    apiSend(304);
+    return;
+  }
+  if (unchanged) {
+    apiSend(200, "application/json", "{\"unchanged\":true}");
+    return;
+  }
+  apiSend(200, "application/json", payload);
+}
+
+// Start a save-file scan on MikroTik with a very short timeout.
+// Response is irrelevant; MikroTik continues the scan and CSV is fetched later
+void scanTriggerSaveFile(const String& interfaceId, const String& filename) {
+  DynamicJsonDocument scanDoc(JSON_BUFFER_SCAN_REQUEST);
+  scanDoc[".id"] = interfaceId;  // Use interface ID (e.g. "*3"), not name (e.g. "wlan2")
+  scanDoc["duration"] = String(runtimeConfig.scanDurationSeconds);
+  scanDoc["save-file"] = filename;
+
+  String scanBody;
+  serializeJson(scanDoc, scanBody);
+
+  // Short timeout (500ms) just to trigger; response is ignored
+  mikrotikRequest("POST", "/interface/wireless/scan", scanBody, 500);
+}
+
+// The companion radio goes first: its file is downloaded first, and the
+// requested band's file (which the probe watches) lands last
+void scanTriggerSaveFile() {
+  if (scanState().companionInterfaceId.length() > 0) {
+    scanTriggerSaveFile(scanState().companionInterfaceId, scanState().companionCsvFilename);
+  }
+  scanTriggerSaveFile(scanState().interfaceId, scanState().csvFilename);
+}
+
+bool bandIs5ghz(const String& band) {
+  return band.startsWith("5ghz");
+}
+
+// Switch the interface to the band if needed (or use the radio already on it)
+// and start the scan; the router task's fetcher collects the result. False
+// when the interface is missing. Background scans never switch: they take
+// the band the radio is on.
+bool scanBegin(String band, bool background) {
+  String wlanId;
+  String currentBand;
+  if (!fetchConfiguredWirelessInterface(wlanId, currentBand)) {
+    return false;
+  }
+  if (background) {
+    // Background scans never reconfigure the router: they scan the frequency
+    // range the radio is on and file the result under that configured band
+    band = bandIs5ghz(currentBand) ? runtimeConfig.band5ghz : runtimeConfig.band2ghz;
+  }
+
+  bool restMode = runtimeConfig.scanMode == "rest";
+  String scanInterfaceId = wlanId;
+  String scanInterfaceName = targetConfig().wlanInterface;
+  String companionId;
+  String companionName;
+  String companionBand;
+
+  // Dual-radio router with the radios on different bands: scan both at once
+  // on the frequency range they are already on, and switch neither. REST mode
+  // reads one scan response per connection, so it keeps scanning one band.
+  WirelessInterfaceState second;
+  bool dualBand = !restMode && band.length() > 0 && getSecondRadioState(second) && !second.disabled &&
+                  bandIs5ghz(second.band) != bandIs5ghz(currentBand);
+  unsigned long settleMs = 0;
+  if (dualBand) {
+    companionBand = bandIs5ghz(band) ? runtimeConfig.band2ghz : runtimeConfig.band5ghz;
+    if (bandIs5ghz(second.band) == bandIs5ghz(band)) {
+      scanInterfaceId = second.id;
+      scanInterfaceName = targetConfig().secondInterface;
+      companionId = wlanId;
+      companionName = targetConfig().wlanInterface;
+    } else {
+      companionId = second.id;
+      companionName = targetConfig().secondInterface;
+    }
+  } else if (!background && band.length() > 0 && currentBand != band) {
+    // Switch MikroTik band
+    DynamicJsonDocument bandDoc(JSON_BUFFER_SECURITY_PAYLOAD);
+    bandDoc["band"] = band;
+    // Set matching channel-width to avoid invalid combinations (e.g. 80MHz on 2.4GHz)
+    bool is5ghz = bandIs5ghz(band);
+    String channelWidth = is5ghz ? runtimeConfig.channelWidth5ghz : runtimeConfig.channelWidth2ghz;
+    if (channelWidth.length() > 0) {
+      bandDoc["channel-width"] = channelWidth;
+    }
+    String bandPayload;
+    serializeJson(bandDoc, bandPayload);
+    String bandResponse = mikrotikRequest("PATCH", "/interface/wireless/" + wlanId, bandPayload);
+    wirelessInterfaceCacheAfterPatch(bandResponse, bandDoc);
+    // Radio needs a moment on the new band: the fetcher triggers the scan after that
+    settleMs = BAND_SWITCH_SETTLE_MS;
+  }
 
-  DynamicJsonDocument doc(1536);
-  DeserializationError error = deserializeJson(doc, body);
-  if (error) {
-    server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+  // Stamp of the previous save-file, so the fetcher sees when the new one has landed
+  String csvFilename = scanFilenameFor(scanInterfaceName);
+  String fileStamp;
+  bool probe = !restMode && SCAN_READY_PROBE_ENABLED && scanFileStamp(csvFilename, fileStamp);
+
+  // Update scan state before triggering (clear any cached results)
+  {
+    SharedStateLock lock;
+    scanFetcherReset();
+    scanFetcherArmProbe(probe, fileStamp);
+    scanState().isScanning = true;
+    scanState().hasResult = false;
+    scanState().result = "";
+    scanState().errorStatus = "";
+    scanState().error = "";
+    scanState().resultTimestamp = 0;
+    scanState().startTime = millis();
+    scanState().band = band;
+    scanState().csvFilename = csvFilename;
+    scanState().companionBand = companionBand;
+    scanState().companionInterfaceId = companionId;
+    scanState().companionCsvFilename = dualBand ? scanFilenameFor(companionName) : "";
+    scanState().companionPending = dualBand;
+    scanState().expectedDurationMs = static_cast<unsigned long>(runtimeConfig.scanDurationSeconds) * 1000UL;
+    scanState().minReadyMs = scanState().expectedDurationMs + settleMs;
+    scanState().pollIntervalMs = SCAN_POLL_INTERVAL_MS;
+    scanState().resultTimeoutMs = scanState().expectedDurationMs + settleMs +
+                                static_cast<unsigned long>(SCAN_RESULT_GRACE_MS) +
+                                scanState().pollIntervalMs;
+    scanState().interfaceId = scanInterfaceId;
+    scanState().restMode = restMode;
+    scanState().background = background;
+    scanState().triggerAt = scanState().startTime + settleMs;
+    scanState().triggerPending = !scanState().restMode && settleMs > 0;
+  }
+
+  // REST mode: the fetcher issues the scan itself and reads the response
+  if (!scanState().restMode && settleMs == 0) {
+    scanTriggerSaveFile();
+  }
+
+  return true;
+}
+
+void handleScanStart() {
+  if (!ensureOperationAllowed()) return;
+  String band = apiArg("band");
+  if (band == "") band = runtimeConfig.band2ghz;
+
+  // Check if a scan is already running
+  if (scanState().isScanning) {
+    unsigned long elapsedMs = millis() - scanState().startTime;
+    unsigned long timeoutMs = scanState().resultTimeoutMs > 0 ? scanState().resultTimeoutMs
+                                                             : (static_cast<unsigned long>(runtimeConfig.scanDurationSeconds) * 1000UL + SCAN_RESULT_GRACE_MS + SCAN_POLL_INTERVAL_MS);
+
+    // If the scan is too old, reset it (cleanup abandoned scans)
+    if (elapsedMs > timeoutMs) {
+      Serial.printf("Scan state expired (elapsed: %lu ms, timeout: %lu ms) - resetting\n", elapsedMs, timeoutMs);
+      SharedStateLock lock;
+      scanState().isScanning = false;
+      scanState().hasResult = false;
+      scanState().result = "";
+      scanFetcherReset();
+      // Continue with new scan below
+    } else {
+      // Scan is still valid, return info to client
+      StaticJsonDocument<256> doc;
+      doc["status"] = "already_scanning";
+      doc["band"] = scanState().band;
+      doc["background"] = scanState().background;
+      doc["elapsed_ms"] = elapsedMs;
+      doc["duration_ms"] = scanState().expectedDurationMs;
+      doc["min_ready_ms"] = scanState().minReadyMs;
+      doc["timeout_ms"] = scanState().resultTimeoutMs;
+      doc["poll_interval_ms"] = scanState().pollIntervalMs;
+      doc["csv_filename"] = scanState().csvFilename;
+      if (scanState().companionBand.length() > 0) doc["companion_band"] = scanState().companionBand;
+      String response;
+      serializeJson(doc, response);
+      apiSend(200, "application/json", response);
+      return;
+    }
+  }
+
+  if (!scanBegin(band, false)) {
+    apiSend(404, "application/json", "{\"error\":\"Configured WLAN interface not found\"}");
     return;
   }
 
-  bool wifiChanged = false;
-  bool mikrotikChanged = false;
-  bool bandsChanged = false;
-  bool scanChanged = false;
-  bool wirelessChanged = false;
+  // Immediately confirm that the scan started
+  StaticJsonDocument<256> responseDoc;
+  responseDoc["status"] = "started";
+  responseDoc["duration_ms"] = scanState().expectedDurationMs;
+  responseDoc["min_ready_ms"] = scanState().minReadyMs;
+  responseDoc["timeout_ms"] = scanState().resultTimeoutMs;
+  responseDoc["poll_interval_ms"] = scanState().pollIntervalMs;
+  responseDoc["csv_filename"] = scanState().csvFilename;
+  responseDoc["mode"] = scanState().restMode ? "rest" : "ftp";
+  if (scanState().companionBand.length() > 0) {
+    responseDoc["companion_band"] = scanState().companionBand;  // Scanned alongside on the other radio
+  }
 
-  JsonObject wifiObj = doc["wifi"].as<JsonObject>();
-  if (!wifiObj.isNull()) {
-    if (wifiObj.containsKey("ssid")) {
-      String newSsid = wifiObj["ssid"].as<String>();
-      newSsid.trim();
-      runtimeConfig.wifiSsid = newSsid;
-      wifiChanged = true;
+  String response;
+  serializeJson(responseDoc, response);
+  apiSend(200, "application/json", response);
+}
+
+// ==================== JSON WRITER ====================
+
+// Table-built JSON goes through JsonWriter (lib/RouterParse/src/JsonWriter.h)
+// into one of these sinks, JSON_WRITER_CHUNK_SIZE bytes at a time.
+using JsonWriter = BasicJsonWriter<JSON_WRITER_CHUNK_SIZE>;
+
+struct StringJsonSink : JsonSink {
+  String& out;
+  explicit StringJsonSink(String& target) : out(target) {}
+  void write(const char* data, size_t length) override { out.concat(data, length); }
+};
+
+// Body of a chunked response, after server.send() with CONTENT_LENGTH_UNKNOWN
+struct ServerJsonSink : JsonSink {
+  void write(const char* data, size_t length) override { server.sendContent(data, length); }
+};
+
+// ==================== SCAN RESULT TABLE ====================
+
+// Parsing and de-duplication live in lib/RouterParse/src/ScanTable.h
+ScanTable& scanTable();
+
+// {"ssid","mac","signal","frequency","privacy","known"[,"age_ms"]}
+// ("privacy" is null when the scan mode cannot tell)
+void writeScanNetworkJson(JsonWriter& json, const ScanNetwork& network, long ageMs = -1) {
+  char mac[18];
+  char numbers[96];
+  formatMacAddress(network.bssid, mac);
+  json.raw("{\"ssid\":").string(network.ssid);
+  int length = snprintf(numbers, sizeof(numbers), ",\"mac\":\"%s\",\"signal\":%d,\"frequency\":%u,\"privacy\":%s,\"known\":%s",
+                        mac, network.signal, network.frequency,
+                        (network.flags & SCAN_FLAG_PRIVACY_UNKNOWN) ? "null" : (network.flags & SCAN_FLAG_PRIVACY) ? "true" : "false",
+                        (network.flags & SCAN_FLAG_KNOWN) ? "true" : "false");
+  json.raw(numbers, static_cast<size_t>(length));
+  if (ageMs >= 0) {
+    json.raw(",\"age_ms\":").number(ageMs);
+  }
+  json.raw("}", 1);
+}
+
+// Compact JSON array of the last scan
+void writeScanTableJson(JsonWriter& json) {
+  json.raw("[", 1);
+  for (size_t i = 0; i < scanTable().count; i++) {
+    if (i > 0) json.raw(",", 1);
+    writeScanNetworkJson(json, scanTable().entries[i]);
+  }
+  json.raw("]", 1);
+}
+
+// ==================== SCAN RESULT STORE ====================
+
+// Networks per configured band, merged across scans the way the dashboard's
+// mergeNetworkResults() does: a BSSID is updated by every scan that sees it
+// and dropped once it has not been seen for SCAN_STORE_MAX_AGE_MS. Filled by
+// client and background scans alike, so /api/scan/networks answers at once.
+struct StoredNetwork {
+  ScanNetwork network;
+  unsigned long seenAt;
+};
+
+struct BandScanStore {
+  String band = "";
+  StoredNetwork entries[SCAN_MAX_NETWORKS];
+  size_t count = 0;
+  unsigned long updatedAt = 0;
+  unsigned long scanCount = 0;
+  bool restMode = false;
+};
+
+BandScanStore* scanStores();       // [0] = band2ghz, [1] = band5ghz
+String& scanStoreProfilesJson();   // Managed profiles as of the last scan
+
+// Store for a configured band, reset when the band configuration changed
+BandScanStore* scanStoreFor(const String& band) {
+  int index = -1;
+  if (band.length() > 0 && band == runtimeConfig.band2ghz) index = 0;
+  else if (band.length() > 0 && band == runtimeConfig.band5ghz) index = 1;
+  if (index < 0) {
+    return nullptr;
+  }
+  BandScanStore& store = scanStores()[index];
+  if (store.band != band) {
+    store.band = band;
+    store.count = 0;
+    store.updatedAt = 0;
+    store.scanCount = 0;
+  }
+  return &store;
+}
+
+// Fold the finished scanTable into the band's store. Caller holds the shared state lock.
+void scanStoreMerge(const String& band, bool restMode, const String& profilesJson) {
+  BandScanStore* store = scanStoreFor(band);
+  if (store == nullptr) {
+    return;
+  }
+  unsigned long now = millis();
+
+  for (size_t i = 0; i < scanTable().count; i++) {
+    const ScanNetwork& network = scanTable().entries[i];
+    StoredNetwork* slot = nullptr;
+    for (size_t j = 0; j < store->count; j++) {
+      if (memcmp(store->entries[j].network.bssid, network.bssid, sizeof(network.bssid)) == 0) {
+        slot = &store->entries[j];
+        break;
+      }
     }
-    if (wifiObj.containsKey("password")) {
-      if (wifiObj["password"].is<String>()) {
-        runtimeConfig.wifiPassword = wifiObj["password"].as<String>();
-        wifiChanged = true;
+    if (slot == nullptr && store->count < SCAN_MAX_NETWORKS) {
+      slot = &store->entries[store->count++];
+    }
+    if (slot == nullptr) {
+      // Full: the network seen longest ago makes room
+      slot = &store->entries[0];
+      for (size_t j = 1; j < store->count; j++) {
+        if (store->entries[j].seenAt < slot->seenAt) {
+          slot = &store->entries[j];
+        }
       }
     }
+    ScanNetwork merged = network;
+    // A REST scan cannot tell encryption: keep what an earlier FTP scan found
+    if ((merged.flags & SCAN_FLAG_PRIVACY_UNKNOWN) && slot->seenAt != 0 &&
+        memcmp(slot->network.bssid, network.bssid, sizeof(network.bssid)) == 0 &&
+        !(slot->network.flags & SCAN_FLAG_PRIVACY_UNKNOWN)) {
+      merged.flags = (merged.flags & ~(SCAN_FLAG_PRIVACY | SCAN_FLAG_PRIVACY_UNKNOWN)) |
+                     (slot->network.flags & SCAN_FLAG_PRIVACY);
+    }
+    slot->network = merged;
+    slot->seenAt = now;
   }
 
-  JsonObject mikrotikObj = doc["mikrotik"].as<JsonObject>();
-  if (!mikrotikObj.isNull()) {
-    if (mikrotikObj.containsKey("ip")) {
-      String newIp = mikrotikObj["ip"].as<String>();
-      newIp.trim();
-      runtimeConfig.mikrotikIp = newIp;
-      mikrotikChanged = true;
+  // Drop networks that have not shown up for a while
+  size_t kept = 0;
+  for (size_t j = 0; j < store->count; j++) {
+    if (now - store->entries[j].seenAt <= SCAN_STORE_MAX_AGE_MS) {
+      store->entries[kept++] = store->entries[j];
     }
-    if (mikrotikObj.containsKey("user")) {
-      String newUser = mikrotikObj["user"].as<String>();
-      newUser.trim();
-      runtimeConfig.mikrotikUser = newUser;
-      mikrotikChanged = true;
+  }
+  store->count = kept;
+  store->updatedAt = now;
+  store->scanCount++;
+  store->restMode = restMode;
+  scanStoreProfilesJson() = profilesJson;
+}
+
+// Background scans keep the stores warm while the station is idle, every
+// SCAN_SCHEDULER_INTERVAL_MS after the last scan finished. They scan the band
+// the radios are on (see scanBegin()), so they never reconfigure the router.
+struct ScanScheduler {
+  unsigned long nextAt = 0;
+  unsigned long started = 0;
+  unsigned long skipped = 0;
+};
+
+ScanScheduler& scanScheduler();
+
+void scanSchedulerDefer() {
+  scanScheduler().nextAt = millis() + SCAN_SCHEDULER_INTERVAL_MS;
+}
+
+void describeScanScheduler(JsonObject obj) {
+  obj["interval_ms"] = SCAN_SCHEDULER_INTERVAL_MS;
+  obj["started"] = scanScheduler().started;
+  obj["skipped"] = scanScheduler().skipped;
+  JsonArray storesArr = obj.createNestedArray("stores");
+  for (size_t i = 0; i < 2; i++) {
+    const BandScanStore& store = scanStores()[i];
+    if (store.band.length() == 0) continue;
+    JsonObject storeObj = storesArr.createNestedObject();
+    storeObj["band"] = store.band;
+    storeObj["networks"] = store.count;
+    storeObj["scans"] = store.scanCount;
+    storeObj["age_ms"] = store.updatedAt > 0 ? millis() - store.updatedAt : 0;
+  }
+}
+
+// {"band","age_ms","scans","mode","networks":[... with "age_ms"],"profiles"}
+// Caller holds the shared state lock.
+void writeScanStoreJson(JsonWriter& json, const BandScanStore& store) {
+  unsigned long now = millis();
+  json.raw("{\"band\":").string(store.band);
+  json.raw(",\"age_ms\":");
+  if (store.updatedAt > 0) {
+    json.number(now - store.updatedAt);
+  } else {
+    json.raw("null", 4);
+  }
+  json.raw(",\"scans\":").number(store.scanCount);
+  json.raw(",\"mode\":").string(store.restMode ? "rest" : "ftp");
+  json.raw(",\"networks\":[");
+  for (size_t i = 0; i < store.count; i++) {
+    if (i > 0) json.raw(",", 1);
+    writeScanNetworkJson(json, store.entries[i].network, static_cast<long>(now - store.entries[i].seenAt));
+  }
+  json.raw("],\"profiles\":").raw(scanStoreProfilesJson());
+  json.raw("}", 1);
+}
+
+// ==================== METRICS ENDPOINT ====================
+
+LatencyHistogram metricsSnapshot(const LatencyHistogram& live) {
+  portENTER_CRITICAL(&metricsMux);
+  LatencyHistogram copy = live;
+  portEXIT_CRITICAL(&metricsMux);
+  return copy;
+}
+
+// Microseconds as decimal milliseconds ("12.345") or seconds ("0.012345")
+void writeMetricTime(JsonWriter& out, uint64_t us, bool seconds) {
+  char text[24];
+  uint64_t unit = seconds ? 1000000ULL : 1000ULL;
+  int length = snprintf(text, sizeof(text), seconds ? "%lu.%06lu" : "%lu.%03lu",
+                        static_cast<unsigned long>(us / unit), static_cast<unsigned long>(us % unit));
+  out.raw(text, static_cast<size_t>(length));
+}
+
+// {"count","sum_ms","max_ms","buckets":[cumulative counts per bucket_le_ms, then +Inf]}
+void writeHistogramJson(JsonWriter& out, const LatencyHistogram& live) {
+  LatencyHistogram histogram = metricsSnapshot(live);
+  out.raw("{\"count\":").number(static_cast<unsigned long>(histogram.count));
+  out.raw(",\"sum_ms\":");
+  writeMetricTime(out, histogram.sumUs, false);
+  out.raw(",\"max_ms\":");
+  writeMetricTime(out, histogram.maxUs, false);
+  out.raw(",\"buckets\":[");
+  unsigned long cumulative = 0;
+  for (size_t i = 0; i <= METRIC_BUCKET_COUNT; i++) {
+    cumulative += histogram.buckets[i];
+    if (i > 0) out.raw(",", 1);
+    out.number(cumulative);
+  }
+  out.raw("]}");
+}
+
+void writeMetricsJson(JsonWriter& out) {
+  out.raw("{\"uptime_ms\":").number(millis());
+  out.raw(",\"bucket_le_ms\":[");
+  for (size_t i = 0; i < METRIC_BUCKET_COUNT; i++) {
+    if (i > 0) out.raw(",", 1);
+    writeMetricTime(out, METRIC_BUCKETS_US[i], false);
+  }
+  out.raw("],\"heap\":{\"free\":").number(static_cast<unsigned long>(ESP.getFreeHeap()));
+  out.raw(",\"min_free\":").number(static_cast<unsigned long>(ESP.getMinFreeHeap()));
+  out.raw(",\"largest_block\":").number(static_cast<unsigned long>(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)));
+  out.raw("},\"loop\":");
+  writeHistogramJson(out, loopMetrics);
+
+  out.raw(",\"endpoints\":{");
+  bool first = true;
+  for (const EndpointMetric& metric : endpointMetrics) {
+    if (metric.name == nullptr) continue;
+    if (!first) out.raw(",", 1);
+    first = false;
+    out.key(metric.name);
+    writeHistogramJson(out, metric.latency);
+  }
+
+  out.raw("},\"router\":{");
+  first = true;
+  for (size_t i = 0; i < METRICS_MAX_ROUTER_PATHS; i++) {
+    RouterPathMetric metric = metricsRouterSnapshot(i);
+    if (metric.key[0] == '\0') continue;
+    if (!first) out.raw(",", 1);
+    first = false;
+    out.key(metric.key);
+    out.raw("{\"failures\":").number(static_cast<unsigned long>(metric.failures));
+    out.raw(",\"latency\":");
+    writeHistogramJson(out, metric.latency);
+    out.raw("}", 1);
+  }
+
+  ScanMetrics scan = metricsScanSnapshot();
+  out.raw("},\"scan\":{\"completed\":").number(static_cast<unsigned long>(scan.completed));
+  out.raw(",\"failed\":").number(static_cast<unsigned long>(scan.failed));
+  out.raw(",\"bytes\":").number(static_cast<unsigned long>(scan.bytes));
+  out.raw(",\"ftp_connect\":");
+  writeHistogramJson(out, scan.connect);
+  out.raw(",\"transfer\":");
+  writeHistogramJson(out, scan.transfer);
+  out.raw("}}");
+}
+
+void writePrometheusHeader(JsonWriter& out, const char* name, const char* type, const char* help) {
+  char line[160];
+  int length = snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  out.raw(line, static_cast<size_t>(min(length, static_cast<int>(sizeof(line) - 1))));
+}
+
+void writePrometheusValue(JsonWriter& out, const char* name, unsigned long value) {
+  char line[96];
+  int length = snprintf(line, sizeof(line), "%s %lu\n", name, value);
+  out.raw(line, static_cast<size_t>(min(length, static_cast<int>(sizeof(line) - 1))));
+}
+
+// One histogram series; label may be nullptr
+void writeHistogramPrometheus(JsonWriter& out, const char* name, const char* labelName, const char* labelValue,
+                              const LatencyHistogram& live) {
+  LatencyHistogram histogram = metricsSnapshot(live);
+  char labels[80] = "";
+  if (labelName != nullptr) {
+    snprintf(labels, sizeof(labels), "%s=\"%s\",", labelName, labelValue);
+  }
+  char line[200];
+  unsigned long cumulative = 0;
+  for (size_t i = 0; i <= METRIC_BUCKET_COUNT; i++) {
+    cumulative += histogram.buckets[i];
+    int length;
+    if (i < METRIC_BUCKET_COUNT) {
+      length = snprintf(line, sizeof(line), "%s_bucket{%sle=\"%lu.%06lu\"} %lu\n", name, labels,
+                        static_cast<unsigned long>(METRIC_BUCKETS_US[i] / 1000000UL),
+                        static_cast<unsigned long>(METRIC_BUCKETS_US[i] % 1000000UL), cumulative);
+    } else {
+      length = snprintf(line, sizeof(line), "%s_bucket{%sle=\"+Inf\"} %lu\n", name, labels, cumulative);
     }
-    if (mikrotikObj.containsKey("password")) {
-      if (mikrotikObj["password"].is<String>()) {
-        runtimeConfig.mikrotikPass = mikrotikObj["password"].as<String>();
-        mikrotikChanged = true;
+    out.raw(line, static_cast<size_t>(min(length, static_cast<int>(sizeof(line) - 1))));
+  }
+  if (labelName != nullptr) {
+    labels[strlen(labels) - 1] = '\0';  // Drop the trailing comma
+  }
+  const char* open = labelName != nullptr ? "{" : "";
+  const char* close = labelName != nullptr ? "}" : "";
+  int length = snprintf(line, sizeof(line), "%s_sum%s%s%s ", name, open, labels, close);
+  out.raw(line, static_cast<size_t>(min(length, static_cast<int>(sizeof(line) - 1))));
+  writeMetricTime(out, histogram.sumUs, true);
+  length = snprintf(line, sizeof(line), "\n%s_count%s%s%s %lu\n", name, open, labels, close,
+                    static_cast<unsigned long>(histogram.count));
+  out.raw(line, static_cast<size_t>(min(length, static_cast<int>(sizeof(line) - 1))));
+}
+
+void writeMetricsPrometheus(JsonWriter& out) {
+  writePrometheusHeader(out, "wifimgr_uptime_seconds", "gauge", "Time since boot");
+  writePrometheusValue(out, "wifimgr_uptime_seconds", millis() / 1000UL);
+  writePrometheusHeader(out, "wifimgr_heap_free_bytes", "gauge", "Free heap");
+  writePrometheusValue(out, "wifimgr_heap_free_bytes", ESP.getFreeHeap());
+  writePrometheusHeader(out, "wifimgr_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+  writePrometheusValue(out, "wifimgr_heap_min_free_bytes", ESP.getMinFreeHeap());
+  writePrometheusHeader(out, "wifimgr_heap_largest_free_block_bytes", "gauge", "Largest allocatable heap block");
+  writePrometheusValue(out, "wifimgr_heap_largest_free_block_bytes", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+  writePrometheusHeader(out, "wifimgr_loop_iteration_seconds", "histogram", "Duration of one loop() pass");
+  writeHistogramPrometheus(out, "wifimgr_loop_iteration_seconds", nullptr, nullptr, loopMetrics);
+
+  writePrometheusHeader(out, "wifimgr_http_request_seconds", "histogram", "API request time until answered");
+  for (const EndpointMetric& metric : endpointMetrics) {
+    if (metric.name == nullptr) continue;
+    writeHistogramPrometheus(out, "wifimgr_http_request_seconds", "endpoint", metric.name, metric.latency);
+  }
+
+  writePrometheusHeader(out, "wifimgr_router_request_seconds", "histogram", "RouterOS REST round trip");
+  for (size_t i = 0; i < METRICS_MAX_ROUTER_PATHS; i++) {
+    RouterPathMetric metric = metricsRouterSnapshot(i);
+    if (metric.key[0] == '\0') continue;
+    writeHistogramPrometheus(out, "wifimgr_router_request_seconds", "request", metric.key, metric.latency);
+  }
+  writePrometheusHeader(out, "wifimgr_router_request_failures_total", "counter", "Failed RouterOS REST requests");
+  for (size_t i = 0; i < METRICS_MAX_ROUTER_PATHS; i++) {
+    RouterPathMetric metric = metricsRouterSnapshot(i);
+    if (metric.key[0] == '\0') continue;
+    char line[96];
+    int length = snprintf(line, sizeof(line), "wifimgr_router_request_failures_total{request=\"%s\"} %lu\n",
+                          metric.key, static_cast<unsigned long>(metric.failures));
+    out.raw(line, static_cast<size_t>(min(length, static_cast<int>(sizeof(line) - 1))));
+  }
+
+  ScanMetrics scan = metricsScanSnapshot();
+  writePrometheusHeader(out, "wifimgr_scan_ftp_connect_seconds", "histogram", "FTP control connection setup");
+  writeHistogramPrometheus(out, "wifimgr_scan_ftp_connect_seconds", nullptr, nullptr, scan.connect);
+  writePrometheusHeader(out, "wifimgr_scan_transfer_seconds", "histogram", "Scan result download");
+  writeHistogramPrometheus(out, "wifimgr_scan_transfer_seconds", nullptr, nullptr, scan.transfer);
+  writePrometheusHeader(out, "wifimgr_scan_bytes_total", "counter", "Scan result bytes downloaded");
+  writePrometheusValue(out, "wifimgr_scan_bytes_total", static_cast<unsigned long>(scan.bytes));
+  writePrometheusHeader(out, "wifimgr_scans_total", "counter", "Finished scan downloads by result");
+  char line[96];
+  int length = snprintf(line, sizeof(line), "wifimgr_scans_total{result=\"completed\"} %lu\nwifimgr_scans_total{result=\"failed\"} %lu\n",
+                        static_cast<unsigned long>(scan.completed), static_cast<unsigned long>(scan.failed));
+  out.raw(line, static_cast<size_t>(min(length, static_cast<int>(sizeof(line) - 1))));
+}
+
+// GET /api/metrics: JSON by default; Prometheus text with ?format=prometheus
+// or when the scraper asks for text/plain or OpenMetrics
+void handleMetrics() {
+  String format = server.arg("format");
+  String accept = server.header("Accept");
+  bool prometheus = format == "prometheus" ||
+                    (format.length() == 0 && (accept.indexOf("text/plain") >= 0 || accept.indexOf("openmetrics") >= 0));
+
+  server.sendHeader("Cache-Control", "no-store");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, prometheus ? "text/plain; version=0.0.4" : "application/json", "");
+  ServerJsonSink sink;
+  {
+    JsonWriter out(sink);
+    if (prometheus) {
+      writeMetricsPrometheus(out);
+    } else {
+      writeMetricsJson(out);
+    }
+  }
+  server.sendContent("");
+}
+
+// ==================== SIGNAL HISTORY ====================
+
+// One column of /api/history; LONG_MIN from `value` is written as null
+void writeHistoryColumn(JsonWriter& json, const char* name, const HistoryBucket* buckets, size_t count,
+                        long (*value)(const HistoryBucket&)) {
+  json.raw(",").key(name).raw("[", 1);
+  for (size_t i = 0; i < count; i++) {
+    if (i > 0) json.raw(",", 1);
+    long v = value(buckets[i]);
+    if (v == LONG_MIN) {
+      json.raw("null", 4);
+    } else {
+      json.number(v);
+    }
+  }
+  json.raw("]", 1);
+}
+
+// GET /api/history[?points=N][&window=<seconds>]: the target's link history,
+// oldest first, averaged into at most N points (default HISTORY_DEFAULT_POINTS)
+// as parallel arrays: age_s (seconds before now), signal and signal_min (dBm),
+// ccq (%), tx_rate and rx_rate (Mbps). null where a point had no link.
+void handleHistory() {
+  long points = server.hasArg("points") ? server.arg("points").toInt() : static_cast<long>(HISTORY_DEFAULT_POINTS);
+  points = constrain(points, 1L, static_cast<long>(HISTORY_CAPACITY));
+  long window = constrain(server.arg("window").toInt(), 0L, 65535L);
+
+  std::vector<HistoryBucket> buckets(static_cast<size_t>(points));
+  size_t count;
+  size_t samples;
+  String target;
+  {
+    SharedStateLock lock;
+    count = signalHistoryDownsample(linkHistory().samples, static_cast<uint16_t>(millis() / 1000),
+                                    static_cast<uint32_t>(window), buckets.data(), buckets.size());
+    samples = linkHistory().samples.count;
+    target = routerTargetConfigAt(currentTargetIndex()).name;
+  }
+
+  server.sendHeader("Cache-Control", "no-store");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  ServerJsonSink sink;
+  {
+    JsonWriter json(sink);
+    json.raw("{\"target\":").string(target);
+    json.raw(",\"interval_ms\":").number(static_cast<unsigned long>(HISTORY_SAMPLE_INTERVAL_MS));
+    json.raw(",\"samples\":").number(static_cast<unsigned long>(samples));
+    json.raw(",\"points\":").number(static_cast<unsigned long>(count));
+    const HistoryBucket* data = buckets.data();
+    writeHistoryColumn(json, "age_s", data, count, [](const HistoryBucket& b) -> long { return b.ageS; });
+    writeHistoryColumn(json, "signal", data, count,
+                       [](const HistoryBucket& b) -> long { return b.linked > 0 ? b.signalAvg : LONG_MIN; });
+    writeHistoryColumn(json, "signal_min", data, count,
+                       [](const HistoryBucket& b) -> long { return b.linked > 0 ? b.signalMin : LONG_MIN; });
+    writeHistoryColumn(json, "ccq", data, count,
+                       [](const HistoryBucket& b) -> long { return b.ccqSamples > 0 ? b.ccqAvg : LONG_MIN; });
+    writeHistoryColumn(json, "tx_rate", data, count,
+                       [](const HistoryBucket& b) -> long { return b.linked > 0 ? b.txRateAvg : LONG_MIN; });
+    writeHistoryColumn(json, "rx_rate", data, count,
+                       [](const HistoryBucket& b) -> long { return b.linked > 0 ? b.rxRateAvg : LONG_MIN; });
+    json.raw("}", 1);
+  }
+  server.sendContent("");
+}
+
+// ==================== SCAN RESULT FETCHER ====================
+
+// The CSV written by "save-file" is pulled over FTP by a small state machine
+// driven from loop(), so the web server keeps serving other clients while the
+// router is slow. /api/scan/result only reports progress until it completes.
+enum ScanFetchStage {
+  FETCH_IDLE,
+  FETCH_WELCOME,
+  FETCH_USER,
+  FETCH_PASS,
+  FETCH_PASV,
+  FETCH_RETR,
+  FETCH_TRANSFER,
+  FETCH_NEXT_FILE,
+  FETCH_REST_HEADERS,
+  FETCH_REST_BODY
+};
+
+struct ScanFetcher {
+  ScanFetchStage stage = FETCH_IDLE;
+  WiFiClient control;
+  WiFiClient data;
+  String line = "";
+  char csvLine[SCAN_CSV_LINE_MAX];
+  size_t csvLineLength = 0;
+  size_t bytes = 0;
+  bool restArrayOpen = false;
+  bool probeEnabled = false;        // Check the save-file over REST before each FTP download
+  String baselineStamp = "";        // Save-file stamp from before the scan ("" = no file)
+  unsigned long probeIntervalMs = 0;
+  int probes = 0;
+  int attempts = 0;
+  unsigned long stageStartedAt = 0;
+  unsigned long nextAttemptAt = 0;
+  unsigned long transferStartedUs = 0;
+};
+
+// ==================== ROUTER TARGETS ====================
+
+// Every router/interface pair the dashboard manages is a target with its own
+// REST session, caches and scan state. Target 0 is the "mikrotik" section of
+// the config, further ones come from "targets". Code below reaches the state
+// of the target it is working for through the accessors (scanState(),
+// mikrotikSession(), ...), which resolve to the calling router task's target
+// or, on loop(), to the one selected with TargetScope.
+struct RouterTarget {
+  RouterTargetConfig config;
+  uint32_t configGeneration = 0;  // routerTargetsGeneration the config was copied at
+  bool active = false;            // Configured (index < routerTargetCount())
+  MikrotikSession session;
+  WirelessInterfaceCache interfaceCache;
+  WirelessInterfaceCache secondRadioCache;
+  ManagedIndex managedIndex;
+  StatusCache statusCache;
+  LinkHistory history;
+  ScanState scan;
+  ScanFetcher fetcher;
+  ScanTableBuffer<SCAN_MAX_NETWORKS> table;
+  BandScanStore stores[2];
+  String profilesJson = "[]";
+  ScanScheduler scheduler;
+};
+
+RouterTarget* routerTargets[ROUTER_TARGETS_MAX] = {};  // See routerTargetAt()
+
+// State of target `index`, allocated the first time the target is used, so
+// slots that are never configured cost no memory. A removed target keeps its
+// state (its task keeps running too) until the slot is configured again.
+RouterTarget& routerTargetAt(size_t index) {
+  if (routerTargets[index] == nullptr) {
+    SharedStateLock lock;
+    if (routerTargets[index] == nullptr) {
+      routerTargets[index] = new RouterTarget();
+    }
+  }
+  return *routerTargets[index];
+}
+
+RouterTarget& currentTarget() {
+  return routerTargetAt(currentTargetIndex());
+}
+
+ScanState& scanState() { return currentTarget().scan; }
+ScanFetcher& scanFetcher() { return currentTarget().fetcher; }
+ScanTable& scanTable() { return currentTarget().table; }
+BandScanStore* scanStores() { return currentTarget().stores; }
+String& scanStoreProfilesJson() { return currentTarget().profilesJson; }
+StatusCache& statusCache() { return currentTarget().statusCache; }
+LinkHistory& linkHistory() { return currentTarget().history; }
+MikrotikSession& mikrotikSession() { return currentTarget().session; }
+WirelessInterfaceCache& wirelessInterfaceCache() { return currentTarget().interfaceCache; }
+WirelessInterfaceCache& secondRadioCache() { return currentTarget().secondRadioCache; }
+ManagedIndex& managedIndex() { return currentTarget().managedIndex; }
+ScanScheduler& scanScheduler() { return currentTarget().scheduler; }
+const RouterTargetConfig& targetConfig() { return currentTarget().config; }
+
+// Copy the target's settings after a change and drop everything derived from
+// the old router. Runs on the target's own task (or loop() without tasks),
+// which owns its session socket.
+void routerTargetSync() {
+  RouterTarget& target = currentTarget();
+  if (target.configGeneration == routerTargetsGeneration) {
+    return;
+  }
+  {
+    SharedStateLock lock;
+    size_t index = currentTargetIndex();
+    target.active = index < routerTargetCount();
+    target.config = target.active ? routerTargetConfigAt(index) : RouterTargetConfig();
+    target.configGeneration = routerTargetsGeneration;
+  }
+  mikrotikSessionReset();
+  clearStatusCache();
+  clearLinkHistory();
+  managedIndexInvalidate();
+  wirelessInterfaceCacheInvalidate();
+  secondRadioCache().valid = false;
+}
+
+// Save-file name on the router for a scan on `interfaceName`: the primary
+// interface of target 0 keeps the historical name, every other interface
+// prefixes the file name so scans on one router do not collide
+// ("tmp1/wlan-scan.csv" -> "tmp1/wlan2-wlan-scan.csv")
+String scanFilenameFor(const String& interfaceName) {
+  String filename = SCAN_CSV_FILENAME;
+  if (currentTargetIndex() == 0 && interfaceName == targetConfig().wlanInterface) {
+    return filename;
+  }
+  int slash = filename.lastIndexOf('/');
+  return filename.substring(0, slash + 1) + interfaceName + "-" + filename.substring(slash + 1);
+}
+
+String targetScanFilename() {
+  return scanFilenameFor(targetConfig().wlanInterface);
+}
+
+// Index for ?target= (number or name), -1 if it names no configured target
+int findRouterTarget(const String& selector) {
+  if (selector.length() == 0) {
+    return 0;
+  }
+  size_t count = routerTargetCount();
+  bool numeric = true;
+  for (size_t i = 0; i < selector.length(); i++) {
+    if (!isdigit(static_cast<unsigned char>(selector[i]))) numeric = false;
+  }
+  if (numeric) {
+    long index = selector.toInt();
+    return index >= 0 && static_cast<size_t>(index) < count ? static_cast<int>(index) : -1;
+  }
+  SharedStateLock lock;
+  for (size_t i = 0; i < count; i++) {
+    if (routerTargetConfigAt(i).name == selector) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+const char* scanFetchStageName(ScanFetchStage stage) {
+  switch (stage) {
+    case FETCH_IDLE: return "waiting";
+    case FETCH_WELCOME: return "connect";
+    case FETCH_USER:
+    case FETCH_PASS: return "login";
+    case FETCH_PASV:
+    case FETCH_RETR: return "request";
+    case FETCH_TRANSFER:
+    case FETCH_NEXT_FILE: return "transfer";
+    case FETCH_REST_HEADERS: return "scanning";
+    case FETCH_REST_BODY: return "transfer";
+  }
+  return "unknown";
+}
+
+void scanFetcherSetStage(ScanFetchStage stage) {
+  scanFetcher().stage = stage;
+  scanFetcher().stageStartedAt = millis();
+  scanFetcher().line = "";
+}
+
+void scanFetcherAbort() {
+  if (scanFetcher().stage != FETCH_IDLE) {
+    scanFetcher().control.print("QUIT\r\n");
+  }
+  scanFetcher().data.stop();
+  scanFetcher().control.stop();
+  scanFetcher().csvLineLength = 0;
+  scanFetcher().bytes = 0;
+  scanFetcher().restArrayOpen = false;
+  scanFetcherSetStage(FETCH_IDLE);
+}
+
+void scanFetcherReset() {
+  scanFetcherAbort();
+  scanFetcher().attempts = 0;
+  scanFetcher().nextAttemptAt = 0;
+  scanFetcher().probeEnabled = false;
+  scanFetcher().baselineStamp = "";
+  scanFetcher().probeIntervalMs = SCAN_PROBE_MIN_INTERVAL_MS;
+  scanFetcher().probes = 0;
+}
+
+void scanFetcherArmProbe(bool enabled, const String& baselineStamp) {
+  scanFetcher().probeEnabled = enabled;
+  scanFetcher().baselineStamp = baselineStamp;
+}
+
+// One filtered REST lookup of the save-file; stamp combines size and
+// timestamps ("" when the file does not exist). False if the lookup failed.
+bool scanFileStamp(const String& filename, String& stampOut) {
+  StaticJsonDocument<128> filter;
+  filter[0]["size"] = true;
+  filter[0]["last-modified"] = true;
+  filter[0]["creation-time"] = true;
+  StaticJsonDocument<384> doc;
+  if (!mikrotikGetFiltered("/file?name=" + urlEncode(filename) + "&.proplist=size,last-modified,creation-time", doc, filter) ||
+      !doc.is<JsonArray>()) {
+    return false;
+  }
+  JsonArray files = doc.as<JsonArray>();
+  if (files.size() == 0) {
+    stampOut = "";
+    return true;
+  }
+  JsonObject file = files[0];
+  stampOut = String(file["size"] | "0") + "|" + (file["last-modified"] | "") + "|" + (file["creation-time"] | "");
+  return true;
+}
+
+// True once the save-file differs from the pre-scan stamp and is not empty.
+// Misses back off from SCAN_PROBE_MIN_INTERVAL_MS up to the poll interval.
+bool scanFileReady(unsigned long now) {
+  String stamp;
+  scanFetcher().probes++;
+  if (!scanFileStamp(scanState().csvFilename, stamp)) {
+    Serial.println("  Scan file probe failed - polling over FTP instead");
+    scanFetcher().probeEnabled = false;
+    return true;
+  }
+  if (stamp.length() > 0 && stamp != scanFetcher().baselineStamp && !stamp.startsWith("0|")) {
+    return true;
+  }
+  scanFetcher().nextAttemptAt = now + scanFetcher().probeIntervalMs;
+  scanFetcher().probeIntervalMs = min(scanFetcher().probeIntervalMs * 2, scanState().pollIntervalMs);
+  return false;
+}
+
+// Collect one complete line from the control connection without blocking
+bool pollControlLine(String& lineOut) {
+  WiFiClient& client = scanFetcher().control;
+  while (client.available()) {
+    char c = static_cast<char>(client.read());
+    if (c == '\r') {
+      continue;
+    }
+    if (c != '\n') {
+      if (scanFetcher().line.length() < 256) {
+        scanFetcher().line += c;
       }
+      continue;
     }
-    if (mikrotikObj.containsKey("wlan_interface")) {
-      String newIface = mikrotikObj["wlan_interface"].as<String>();
-      newIface.trim();
-      runtimeConfig.mikrotikWlanInterface = newIface;
-      mikrotikChanged = true;
+    lineOut = scanFetcher().line;
+    scanFetcher().line = "";
+    return true;
+  }
+  return false;
+}
+
+// Collect one complete FTP reply without blocking.
+// Multi-line replies ("220-...") are skipped until the final "220 " line.
+bool ftpPollReply(String& replyOut) {
+  String line;
+  while (pollControlLine(line)) {
+    if (line.length() >= 4 && line[3] == '-') {
+      continue;
+    }
+    replyOut = line;
+    return true;
+  }
+  return false;
+}
+
+// REST mode: POST /interface/wireless/scan on a dedicated connection. The router
+// answers once the scan duration has elapsed; HTTP/1.0 avoids chunked encoding
+// so the body can be stream-parsed element by element.
+bool restScanSendRequest() {
+  if (!mikrotikSessionPrepare()) {
+    return false;
+  }
+  if (!scanFetcher().control.connect(targetConfig().ip.c_str(), 80, FTP_CONNECT_TIMEOUT_MS)) {
+    return false;
+  }
+
+  StaticJsonDocument<JSON_BUFFER_SCAN_REQUEST> scanDoc;
+  scanDoc[".id"] = scanState().interfaceId;
+  scanDoc["duration"] = String(runtimeConfig.scanDurationSeconds);
+  String scanBody;
+  serializeJson(scanDoc, scanBody);
+
+  WiFiClient& client = scanFetcher().control;
+  client.print("POST /rest/interface/wireless/scan HTTP/1.0\r\n");
+  client.printf("Host: %s\r\n", targetConfig().ip.c_str());
+  client.printf("Authorization: %s\r\n", mikrotikSession().authHeader.c_str());
+  client.print("Content-Type: application/json\r\n");
+  client.printf("Content-Length: %u\r\n", static_cast<unsigned>(scanBody.length()));
+  client.print("Connection: close\r\n\r\n");
+  client.print(scanBody);
+  return true;
+}
+
+// Parse a few array elements per loop() iteration; returns true when the array is done
+// Passes a stream through and counts the bytes read from it, so REST scans
+// report bytes received like the FTP download does
+class CountingStream : public Stream {
+ public:
+  CountingStream(Stream& inner, size_t& count) : inner_(inner), count_(count) {}
+  int available() override { return inner_.available(); }
+  int peek() override { return inner_.peek(); }
+  int read() override {
+    int c = inner_.read();
+    if (c >= 0) count_++;
+    return c;
+  }
+  size_t write(uint8_t) override { return 0; }
+
+ private:
+  Stream& inner_;
+  size_t& count_;
+};
+
+bool restScanParseBody() {
+  CountingStream client(scanFetcher().control, scanFetcher().bytes);
+  client.setTimeout(FTP_REPLY_TIMEOUT_MS);
+
+  if (!scanFetcher().restArrayOpen) {
+    if (!client.find('[')) {
+      return true;
     }
+    scanFetcher().restArrayOpen = true;
   }
 
-  JsonObject bandsObj = doc["bands"].as<JsonObject>();
-  if (!bandsObj.isNull()) {
-    if (bandsObj.containsKey("band_2ghz")) {
-      String newBand2 = bandsObj["band_2ghz"].as<String>();
-      newBand2.trim();
-      runtimeConfig.band2ghz = newBand2;
-      bandsChanged = true;
+  StaticJsonDocument<128> filter;
+  filter["address"] = true;
+  filter["ssid"] = true;
+  filter["channel"] = true;
+  filter["sig"] = true;
+  filter["privacy"] = true;
+
+  for (int parsed = 0; parsed < 4 && client.available(); parsed++) {
+    while (client.peek() == ' ' || client.peek() == '\r' || client.peek() == '\n') {
+      client.read();
     }
-    if (bandsObj.containsKey("band_5ghz")) {
-      String newBand5 = bandsObj["band_5ghz"].as<String>();
-      newBand5.trim();
-      runtimeConfig.band5ghz = newBand5;
-      bandsChanged = true;
+    if (client.peek() == ']') {
+      return true;
     }
-    if (bandsObj.containsKey("channel_width_2ghz")) {
-      String newCw2 = bandsObj["channel_width_2ghz"].as<String>();
-      newCw2.trim();
-      runtimeConfig.channelWidth2ghz = newCw2;
-      bandsChanged = true;
+    StaticJsonDocument<384> entry;
+    DeserializationError error = deserializeJson(entry, client, DeserializationOption::Filter(filter));
+    if (error) {
+      Serial.printf("  REST scan: parse error %s\n", error.c_str());
+      return true;
     }
-    if (bandsObj.containsKey("channel_width_5ghz")) {
-      String newCw5 = bandsObj["channel_width_5ghz"].as<String>();
-      newCw5.trim();
-      runtimeConfig.channelWidth5ghz = newCw5;
-      bandsChanged = true;
+    scanTableAddRestEntry(scanTable(), entry.as<JsonObjectConst>());
+    if (!client.findUntil(",", "]")) {
+      return true;
     }
   }
+  return false;
+}
 
-  JsonObject scanObj = doc["scan"].as<JsonObject>();
-  if (!scanObj.isNull()) {
-    if (scanObj.containsKey("duration_seconds")) {
-      int newDuration = scanObj["duration_seconds"] | runtimeConfig.scanDurationSeconds;
-      if (newDuration <= 0) {
-        server.send(400, "application/json", "{\"error\":\"invalid_scan_duration\"}");
-        return;
-      }
-      runtimeConfig.scanDurationSeconds = newDuration;
-      scanChanged = true;
-    }
+// Parse PASV response: 227 Entering Passive Mode (h1,h2,h3,h4,p1,p2)
+int parsePasvPort(const String& pasvResponse) {
+  int startIdx = pasvResponse.indexOf('(');
+  int endIdx = pasvResponse.indexOf(')');
+  if (startIdx <= 0 || endIdx <= startIdx) {
+    return 0;
+  }
+  String portInfo = pasvResponse.substring(startIdx + 1, endIdx);
+  int lastComma = portInfo.lastIndexOf(',');
+  int secondLastComma = portInfo.lastIndexOf(',', lastComma - 1);
+  if (lastComma <= 0 || secondLastComma <= 0) {
+    return 0;
   }
+  int p1 = portInfo.substring(secondLastComma + 1, lastComma).toInt();
+  int p2 = portInfo.substring(lastComma + 1).toInt();
+  return p1 * 256 + p2;
+}
 
-  JsonObject wirelessObj = doc["wireless"].as<JsonObject>();
-  if (!wirelessObj.isNull()) {
-    if (wirelessObj.containsKey("station_roaming")) {
-      runtimeConfig.stationRoaming = wirelessObj["station_roaming"] | runtimeConfig.stationRoaming;
-      wirelessChanged = true;
+// Build profiles JSON for known-network metadata and flag known networks in the scan table
+String buildManagedProfilesJson() {
+  String profilesJson;
+  StringJsonSink sink(profilesJson);
+  JsonWriter json(sink);
+  json.raw("[", 1);
+  bool firstProfile = true;
+  managedIndexEnsure();
+  for (const IndexedProfile& profile : managedIndex().profiles) {
+    if (profile.ssid.length() == 0) {
+      continue;
     }
-  }
+    if (!firstProfile) json.raw(",", 1);
+    firstProfile = false;
 
-  if (!(wifiChanged || mikrotikChanged || bandsChanged || wirelessChanged)) {
-    DynamicJsonDocument response(128);
-    response["success"] = true;
-    response["wifi_changed"] = false;
-    response["mikrotik_changed"] = false;
-    response["bands_changed"] = false;
-    response["captive_portal"] = captivePortalActive;
-    String output;
-    serializeJson(response, output);
-    server.send(200, "application/json", output);
-    return;
-  }
+    scanTableMarkKnown(scanTable(), profile.ssid.c_str());
 
-  if (!saveRuntimeConfigToFile()) {
-    server.send(500, "application/json", "{\"error\":\"Failed to save configuration\"}");
-    return;
+    json.raw("{\"ssid\":").string(profile.ssid);
+    json.raw(",\"name\":").string(profile.name);
+    json.raw(",\"mode\":").string(profile.mode);
+    json.raw(",\"authentication-types\":").string(profile.authTypes);
+    json.raw("}", 1);
   }
+  json.raw("]", 1);
+  json.flush();
+  return profilesJson;
+}
 
-  if (wifiChanged) {
-    wifiReconnectPending = true;
-    lastReconnectAttempt = 0;
-    startCaptivePortal();
+// Feed downloaded CSV bytes into the line parser
+void scanFetcherFeedCsv(const uint8_t* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    char c = static_cast<char>(data[i]);
+    if (c == '\n') {
+      scanFetcher().csvLine[scanFetcher().csvLineLength] = '\0';
+      scanTableParseCsvLine(scanTable(), scanFetcher().csvLine);
+      scanFetcher().csvLineLength = 0;
+    } else if (scanFetcher().csvLineLength < SCAN_CSV_LINE_MAX - 1) {
+      scanFetcher().csvLine[scanFetcher().csvLineLength++] = c;
+    }
   }
-
-  DynamicJsonDocument response(256);
-  response["success"] = true;
-  response["wifi_changed"] = wifiChanged;
-  response["mikrotik_changed"] = mikrotikChanged;
-  response["bands_changed"] = bandsChanged;
-  response["scan_changed"] = scanChanged;
-  response["wireless_changed"] = wirelessChanged;
-  response["captive_portal"] = captivePortalActive;
-
-  String output;
-  serializeJson(response, output);
-  server.send(200, "application/json", output);
 }
 
-// ==================== OTA SUPPORT ====================
+// Bytes downloaded by benchmark scans (kept out of scanMetrics)
+unsigned long benchScanBytes = 0;
 
-void setupArduinoOTA() {
-  if (!OTA_ENABLE || otaServiceReady || WiFi.status() != WL_CONNECTED) {
-    return;
+// First file of a dual-radio scan: mark known networks and fold the table
+// into the companion band's store (served by /api/scan/networks)
+void scanFetcherCompleteCompanion() {
+  if (scanFetcher().csvLineLength > 0) {
+    scanFetcherFeedCsv(reinterpret_cast<const uint8_t*>("\n"), 1);
+  }
+  Serial.printf("  Parsed %u networks on the second radio (%s)\n", static_cast<unsigned>(scanTable().count),
+                scanState().companionBand.c_str());
+  if (!scanState().benchmark) {
+    metricsRecordScan(micros() - scanFetcher().transferStartedUs, scanFetcher().bytes, false);
+  } else {
+    benchScanBytes += scanFetcher().bytes;
   }
 
-  ArduinoOTA.setHostname(OTA_HOSTNAME);
-  if (OTA_PASSWORD != nullptr && OTA_PASSWORD[0] != '\0') {
-    ArduinoOTA.setPassword(OTA_PASSWORD);
+  String profilesJson = buildManagedProfilesJson();
+  SharedStateLock lock;
+  if (!scanState().benchmark) {
+    scanStoreMerge(scanState().companionBand, false, profilesJson);
   }
+  scanState().companionPending = false;
+}
 
-  ArduinoOTA.onStart([]() {
-    const char* type = ArduinoOTA.getCommand() == U_FLASH ? "firmware" : "filesystem";
-    Serial.printf("ArduinoOTA update started (%s)\n", type);
-  });
+// Mark known networks and build the /api/scan/result payload
+void scanFetcherComplete() {
+  if (scanFetcher().csvLineLength > 0) {
+    scanFetcherFeedCsv(reinterpret_cast<const uint8_t*>("\n"), 1);
+  }
+  Serial.printf("  Parsed %u networks from %u %s bytes (%d attempt(s))\n", static_cast<unsigned>(scanTable().count),
+                static_cast<unsigned>(scanFetcher().bytes), scanState().restMode ? "REST" : "CSV", scanFetcher().attempts);
+  if (!scanState().benchmark) {
+    metricsRecordScan(micros() - scanFetcher().transferStartedUs, scanFetcher().bytes, true);
+  } else {
+    benchScanBytes += scanFetcher().bytes;
+  }
 
-  ArduinoOTA.onEnd([]() {
-    Serial.println("ArduinoOTA update finished, restarting...");
-  });
+  String profilesJson = buildManagedProfilesJson();
 
-  ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-    if (total == 0) {
-      return;
-    }
-    unsigned int percent = (progress * 100U) / total;
-    Serial.printf("ArduinoOTA progress: %u%%\n", percent);
-  });
+  scanState().lastScanDurationMs = millis() - scanState().startTime;
 
-  ArduinoOTA.onError([](ota_error_t error) {
-    Serial.printf("ArduinoOTA error[%u]\n", static_cast<unsigned int>(error));
-    switch (error) {
-      case OTA_AUTH_ERROR:
-        Serial.println("  → Auth failed");
-        break;
-      case OTA_BEGIN_ERROR:
-        Serial.println("  → Begin failed");
-        break;
-      case OTA_CONNECT_ERROR:
-        Serial.println("  → Connect failed");
-        break;
-      case OTA_RECEIVE_ERROR:
-        Serial.println("  → Receive failed");
-        break;
-      case OTA_END_ERROR:
-        Serial.println("  → Finalize failed");
-        break;
-      default:
-        Serial.println("  → Unknown error");
-        break;
+  String result;
+  result.reserve(scanTable().count * 100 + profilesJson.length() + 96);
+  {
+    StringJsonSink sink(result);
+    JsonWriter json(sink);
+    json.raw("{\"band\":").string(scanState().band);
+    json.raw(",\"mode\":").string(scanState().restMode ? "rest" : "ftp");
+    json.raw(",\"scan_ms\":").number(scanState().lastScanDurationMs);
+    if (scanState().companionBand.length() > 0) {
+      json.raw(",\"companion_band\":").string(scanState().companionBand);
     }
-  });
+    json.raw(",\"networks\":");
+    writeScanTableJson(json);
+    json.raw(",\"profiles\":").raw(profilesJson);
+    json.raw("}", 1);
+  }
 
-  ArduinoOTA.begin();
-  otaServiceReady = true;
-  Serial.printf("ArduinoOTA ready (hostname: %s)\n", OTA_HOSTNAME);
+  SharedStateLock lock;
+  if (!scanState().benchmark) {
+    scanStoreMerge(scanState().band, scanState().restMode, profilesJson);
+    scanSchedulerDefer();
+  }
+  scanState().result = result;
+  scanState().resultHash = fnv1aHash(result.c_str(), result.length()) ^ scanState().startTime;
+  scanState().resultEtag = makeEtag(scanState().resultHash);
+  scanState().hasResult = true;
+  scanState().resultTimestamp = millis();
+  scanState().isScanning = false;
+
+  // Note: CSV file is kept on MikroTik and overwritten on next scan (same filename)
 }
 
-void handleStatus() {
-  if (!ensureOperationAllowed()) return;
-  // Fetch required data from MikroTik
-  String interfacesResp = mikrotikRequest("GET", "/interface/wireless");
-  String registrationResp = mikrotikRequest("GET", "/interface/wireless/registration-table");
-  String addressesResp = mikrotikRequest("GET", "/ip/address");
-  String routesResp = mikrotikRequest("GET", "/ip/route");
-  String dnsResp = mikrotikRequest("GET", "/ip/dns");
-
-  // Minimal JSON wrapper without parsing (string concatenation)
-  String output = "{\"interfaces\":";
-  output += interfacesResp;
-  output += ",\"registration\":";
-  output += registrationResp;
-  output += ",\"addresses\":";
-  output += addressesResp;
-  output += ",\"routes\":";
-  output += routesResp;
-  output += ",\"dns\":";
-  output += dnsResp;
-  output += "}";
+void scanFetcherFail(const char* status, const char* error) {
+  Serial.printf("  Scan fetch failed: %s\n", error);
+  if (scanState().benchmark) {
+    benchScanBytes += scanFetcher().bytes;  // Zeroed by the abort
+  }
+  scanFetcherAbort();
+  SharedStateLock lock;
+  if (!scanState().benchmark) {
+    metricsRecordScanFailure();
+    scanSchedulerDefer();
+  }
+  scanState().isScanning = false;
+  scanState().errorStatus = status;
+  scanState().error = error;
+}
 
-  server.send(200, "application/json", output);
+// CSV not there yet (or FTP hiccup): try again after the poll interval
+void scanFetcherRetryLater() {
+  scanFetcherAbort();
+  scanFetcher().nextAttemptAt = millis() + scanState().pollIntervalMs;
 }
 
-void handleScanStart() {
-  if (!ensureOperationAllowed()) return;
-  String band = server.arg("band");
-  if (band == "") band = runtimeConfig.band2ghz;
+void handleScanFetchTasks() {
+  if (!scanState().isScanning) {
+    if (scanFetcher().stage != FETCH_IDLE) {
+      scanFetcherAbort();
+    }
+    return;
+  }
 
-  // Check if a scan is already running
-  if (scanState.isScanning) {
-    unsigned long elapsedMs = millis() - scanState.startTime;
-    unsigned long timeoutMs = scanState.resultTimeoutMs > 0 ? scanState.resultTimeoutMs
-                                                             : (static_cast<unsigned long>(runtimeConfig.scanDurationSeconds) * 1000UL + SCAN_RESULT_GRACE_MS + SCAN_POLL_INTERVAL_MS);
+  unsigned long now = millis();
+  unsigned long elapsedMs = now - scanState().startTime;
+  if (static_cast<long>(now - scanState().triggerAt) < 0) {
+    return;  // Band switch still settling
+  }
+  if (scanState().triggerPending) {
+    scanState().triggerPending = false;
+    scanTriggerSaveFile();
+    return;
+  }
+  if (elapsedMs < scanState().minReadyMs && !scanState().restMode) {
+    return;
+  }
 
-    // If the scan is too old, reset it (cleanup abandoned scans)
-    if (elapsedMs > timeoutMs) {
-      Serial.printf("Scan state expired (elapsed: %lu ms, timeout: %lu ms) - resetting\n", elapsedMs, timeoutMs);
-      scanState.isScanning = false;
-      scanState.hasResult = false;
-      scanState.result = "";
-      // Continue with new scan below
-    } else {
-      // Scan is still valid, return info to client
-      StaticJsonDocument<256> doc;
-      doc["status"] = "already_scanning";
-      doc["elapsed_ms"] = elapsedMs;
-      doc["duration_ms"] = scanState.expectedDurationMs;
-      doc["min_ready_ms"] = scanState.minReadyMs;
-      doc["timeout_ms"] = scanState.resultTimeoutMs;
-      doc["poll_interval_ms"] = scanState.pollIntervalMs;
-      doc["csv_filename"] = scanState.csvFilename;
-      String response;
-      serializeJson(doc, response);
-      server.send(200, "application/json", response);
-      return;
-    }
+  // Timeout guard - a running transfer may finish, anything else gives up
+  bool transferring = scanFetcher().stage == FETCH_TRANSFER || scanFetcher().stage == FETCH_REST_BODY;
+  if (elapsedMs > scanState().resultTimeoutMs && !transferring) {
+    Serial.printf("  Scan timeout after %lu ms (limit %lu ms)\n", elapsedMs, scanState().resultTimeoutMs);
+    scanFetcherFail("timeout", "Scan result file not found after timeout - check MikroTik scan configuration");
+    return;
   }
 
-  String wlanId;
-  String currentBand;
-  if (!fetchConfiguredWirelessInterface(wlanId, currentBand)) {
-    server.send(404, "application/json", "{\"error\":\"Configured WLAN interface not found\"}");
+  // The REST scan only answers after the scan duration (covered by the guard above)
+  if (scanFetcher().stage != FETCH_IDLE && !transferring && scanFetcher().stage != FETCH_REST_HEADERS &&
+      now - scanFetcher().stageStartedAt > FTP_REPLY_TIMEOUT_MS) {
+    Serial.printf("  FTP: no reply during '%s' - retrying\n", scanFetchStageName(scanFetcher().stage));
+    scanFetcherRetryLater();
     return;
   }
-  String wlanName = runtimeConfig.mikrotikWlanInterface;
 
-  // Switch MikroTik band if necessary
-  if (band.length() > 0 && currentBand != band) {
-    DynamicJsonDocument bandDoc(JSON_BUFFER_SECURITY_PAYLOAD);
-    bandDoc["band"] = band;
-    // Set matching channel-width to avoid invalid combinations (e.g. 80MHz on 2.4GHz)
-    bool is5ghz = band.startsWith("5ghz");
-    String channelWidth = is5ghz ? runtimeConfig.channelWidth5ghz : runtimeConfig.channelWidth2ghz;
-    if (channelWidth.length() > 0) {
-      bandDoc["channel-width"] = channelWidth;
+  String reply;
+  switch (scanFetcher().stage) {
+    case FETCH_IDLE:
+      if (static_cast<long>(now - scanFetcher().nextAttemptAt) < 0) {
+        return;
+      }
+      // A REST lookup is far cheaper than an FTP login that ends in a failed RETR
+      if (!scanState().restMode && scanFetcher().probeEnabled && !scanFileReady(now)) {
+        return;
+      }
+      scanFetcher().attempts++;
+      if (scanState().restMode) {
+        if (!restScanSendRequest()) {
+          Serial.println("  REST scan request failed - retrying");
+          scanFetcherRetryLater();
+          return;
+        }
+        scanFetcherSetStage(FETCH_REST_HEADERS);
+        return;
+      }
+      {
+        unsigned long connectStartUs = micros();
+        bool connected = scanFetcher().control.connect(targetConfig().ip.c_str(), 21, FTP_CONNECT_TIMEOUT_MS);
+        if (!scanState().benchmark) {
+          metricsRecord(scanMetrics.connect, micros() - connectStartUs);
+        }
+        if (!connected) {
+          Serial.println("  FTP connection failed - retrying");
+          scanFetcherRetryLater();
+          return;
+        }
+      }
+      scanFetcherSetStage(FETCH_WELCOME);
+      return;
+
+    case FETCH_WELCOME:
+      if (!ftpPollReply(reply)) return;
+      scanFetcher().control.printf("USER %s\r\n", targetConfig().user.c_str());
+      scanFetcherSetStage(FETCH_USER);
+      return;
+
+    case FETCH_USER:
+      if (!ftpPollReply(reply)) return;
+      scanFetcher().control.printf("PASS %s\r\n", targetConfig().pass.c_str());
+      scanFetcherSetStage(FETCH_PASS);
+      return;
+
+    case FETCH_PASS:
+      if (!ftpPollReply(reply)) return;
+      if (!reply.startsWith("230")) {
+        Serial.printf("FTP: Login failed: %s\n", reply.c_str());
+        scanFetcherFail("error", "FTP login failed - check MikroTik credentials and ftp policy");
+        return;
+      }
+      scanFetcher().control.print("PASV\r\n");
+      scanFetcherSetStage(FETCH_PASV);
+      return;
+
+    case FETCH_PASV: {
+      if (!ftpPollReply(reply)) return;
+      int dataPort = parsePasvPort(reply);
+      if (dataPort == 0 || !scanFetcher().data.connect(targetConfig().ip.c_str(), dataPort, FTP_CONNECT_TIMEOUT_MS)) {
+        Serial.printf("FTP: Data connection failed (%s)\n", reply.c_str());
+        scanFetcherRetryLater();
+        return;
+      }
+      String expectedFile = scanState().companionPending ? scanState().companionCsvFilename
+                            : scanState().csvFilename.length() > 0 ? scanState().csvFilename
+                                                                    : targetScanFilename();
+      scanFetcher().control.printf("RETR %s\r\n", expectedFile.c_str());
+      scanFetcherSetStage(FETCH_RETR);
+      return;
     }
-    String bandPayload;
-    serializeJson(bandDoc, bandPayload);
-    mikrotikRequest("PATCH", "/interface/wireless/" + wlanId, bandPayload);
-    delay(500);
-  }
 
-  // Update scan state before triggering (clear any cached results)
-  scanState.isScanning = true;
-  scanState.hasResult = false;
-  scanState.result = "";
-  scanState.resultTimestamp = 0;
-  scanState.startTime = millis();
-  scanState.band = band;
-  scanState.csvFilename = SCAN_CSV_FILENAME;
-  scanState.expectedDurationMs = static_cast<unsigned long>(runtimeConfig.scanDurationSeconds) * 1000UL;
-  scanState.minReadyMs = scanState.expectedDurationMs;
-  scanState.pollIntervalMs = SCAN_POLL_INTERVAL_MS;
-  scanState.resultTimeoutMs = scanState.expectedDurationMs +
-                              static_cast<unsigned long>(SCAN_RESULT_GRACE_MS) +
-                              scanState.pollIntervalMs;
-
-  // Trigger scan on MikroTik with a very short timeout
-  // Response is irrelevant; MikroTik continues the scan and CSV is fetched later
-  DynamicJsonDocument scanDoc(JSON_BUFFER_SCAN_REQUEST);
-  scanDoc[".id"] = wlanId;  // Use interface ID (e.g. "*3"), not name (e.g. "wlan2")
-  scanDoc["duration"] = String(runtimeConfig.scanDurationSeconds);
-  scanDoc["save-file"] = scanState.csvFilename;
+    case FETCH_RETR:
+      if (!ftpPollReply(reply)) return;
+      // 150/125 = file status ok, starting transfer; anything else = file doesn't exist yet
+      if (!reply.startsWith("150") && !reply.startsWith("125")) {
+        Serial.println("  CSV not available yet - retrying");
+        scanFetcherRetryLater();
+        return;
+      }
+      scanTableClear(scanTable());
+      scanFetcher().csvLineLength = 0;
+      scanFetcher().bytes = 0;
+      scanFetcher().transferStartedUs = micros();
+      scanFetcherSetStage(FETCH_TRANSFER);
+      return;
 
-  String scanBody;
-  serializeJson(scanDoc, scanBody);
+    case FETCH_TRANSFER: {
+      // Bounded amount of work per loop() iteration
+      uint8_t buffer[512];
+      int available = scanFetcher().data.available();
+      if (available > 0) {
+        int bytesRead = scanFetcher().data.read(buffer, min(available, static_cast<int>(sizeof(buffer))));
+        if (bytesRead > 0) {
+          scanFetcherFeedCsv(buffer, bytesRead);
+          scanFetcher().bytes += bytesRead;
+          scanFetcher().stageStartedAt = now;  // Reset timeout
+        }
+        return;
+      }
+      if (scanFetcher().data.connected()) {
+        if (now - scanFetcher().stageStartedAt > FTP_TRANSFER_TIMEOUT_MS) {
+          Serial.println("FTP: Download timeout");
+          scanFetcherRetryLater();
+        }
+        return;
+      }
+      if (scanState().companionPending) {
+        scanFetcherCompleteCompanion();
+        scanFetcher().data.stop();
+        scanFetcherSetStage(FETCH_NEXT_FILE);
+        return;
+      }
+      scanFetcherComplete();
+      scanFetcherAbort();
+      return;
+    }
 
-  // Short timeout (500ms) just to trigger; response is ignored
-  mikrotikRequest("POST", "/interface/wireless/scan", scanBody, 500);
+    case FETCH_NEXT_FILE:
+      // "226 Transfer complete" for the companion file, then the requested
+      // band's file over the same login
+      if (!ftpPollReply(reply)) return;
+      scanFetcher().control.print("PASV\r\n");
+      scanFetcherSetStage(FETCH_PASV);
+      return;
 
-  // Immediately confirm that the scan started
-  StaticJsonDocument<160> responseDoc;
-  responseDoc["status"] = "started";
-  responseDoc["duration_ms"] = scanState.expectedDurationMs;
-  responseDoc["min_ready_ms"] = scanState.minReadyMs;
-  responseDoc["timeout_ms"] = scanState.resultTimeoutMs;
-  responseDoc["poll_interval_ms"] = scanState.pollIntervalMs;
-  responseDoc["csv_filename"] = scanState.csvFilename;
+    case FETCH_REST_HEADERS: {
+      String line;
+      while (pollControlLine(line)) {
+        if (line.startsWith("HTTP/")) {
+          int code = line.substring(line.indexOf(' ') + 1).toInt();
+          if (code != 200) {
+            Serial.printf("  REST scan: %s\n", line.c_str());
+            scanFetcherFail("error", "REST scan rejected by MikroTik - check the test policy or use FTP mode");
+            return;
+          }
+        } else if (line.length() == 0) {
+          scanTableClear(scanTable());
+          scanFetcher().transferStartedUs = micros();
+          scanFetcherSetStage(FETCH_REST_BODY);
+          return;
+        }
+      }
+      if (!scanFetcher().control.connected() && !scanFetcher().control.available()) {
+        scanFetcherRetryLater();
+      }
+      return;
+    }
 
-  String response;
-  serializeJson(responseDoc, response);
-  server.send(200, "application/json", response);
+    case FETCH_REST_BODY:
+      if (!scanFetcher().control.available()) {
+        if (scanFetcher().control.connected()) {
+          if (now - scanFetcher().stageStartedAt > FTP_TRANSFER_TIMEOUT_MS) {
+            Serial.println("  REST scan: body timeout");
+            scanFetcherComplete();
+            scanFetcherAbort();
+          }
+          return;
+        }
+      } else if (!restScanParseBody()) {
+        scanFetcher().stageStartedAt = now;
+        return;
+      }
+      scanFetcherComplete();
+      scanFetcherAbort();
+      return;
+  }
 }
 
-// Helper: Read FTP response line
-String ftpReadLine(WiFiClient &client, unsigned long timeoutMs = 2000) {
-  unsigned long start = millis();
-  while (!client.available() && (millis() - start < timeoutMs)) {
-    delay(10);
+void handleScanSchedulerTasks() {
+  if (SCAN_SCHEDULER_INTERVAL_MS == 0 || captivePortalActive || WiFi.status() != WL_CONNECTED ||
+      scanState().isScanning) {
+    return;
   }
-  if (client.available()) {
-    return client.readStringUntil('\n');
+  unsigned long now = millis();
+  if (static_cast<long>(now - scanScheduler().nextAt) < 0) {
+    return;
   }
-  return "";
-}
+  scanSchedulerDefer();
 
-// Download file via FTP and stream directly to output WiFiClient
-// Returns number of bytes streamed, or 0 on error
-size_t ftpDownloadFileStream(const char* filename, WiFiClient &outputClient, unsigned long timeoutMs = 8000) {
-  WiFiClient ftpClient;
-  WiFiClient ftpDataClient;
+  // A scan takes the station off its channel: only while it is neither
+  // connected nor connecting (re-checked unless the snapshot is fresh)
+  if (!statusCache().valid || statusCache().stale || now - statusCache().refreshedAt > STATUS_CACHE_TTL_MS) {
+    refreshStatusCache();
+  }
+  if (statusCache().stationBusy) {
+    scanScheduler().skipped++;
+    return;
+  }
 
-  Serial.printf("FTP: Connecting to %s:21...\n", runtimeConfig.mikrotikIp.c_str());
+  // Only the band the radio is on (and the second radio's): scanBegin() picks it
+  Serial.println("Background scan");
+  if (scanBegin("", true)) {
+    scanScheduler().started++;
+  }
+}
 
-  if (!ftpClient.connect(runtimeConfig.mikrotikIp.c_str(), 21)) {
-    Serial.println("FTP: Connection failed");
-    return 0;
+// GET /api/scan/networks?band=<band>: the merged store, served without router traffic
+void handleScanNetworks() {
+  if (!ensureOperationAllowed()) return;
+  // Built under the lock, sent after it (the store is too large to copy on the stack)
+  String body;
+  {
+    SharedStateLock lock;
+    String band = server.hasArg("band") ? server.arg("band") : runtimeConfig.band2ghz;
+    BandScanStore* store = scanStoreFor(band);
+    if (store != nullptr) {
+      StringJsonSink sink(body);
+      JsonWriter json(sink);
+      writeScanStoreJson(json, *store);
+    }
+  }
+  if (body.length() == 0) {
+    server.send(404, "application/json", "{\"error\":\"unknown_band\"}");
+    return;
   }
+  server.sendHeader("Cache-Control", "no-cache");
+  server.send(200, "application/json", body);
+}
 
-  ftpClient.setTimeout(2000);
+// ==================== BENCHMARK ====================
 
-  // Read welcome
-  String welcome = ftpReadLine(ftpClient);
-  Serial.printf("FTP: %s\n", welcome.c_str());
+// POST /api/bench runs each test N times back to back against the configured
+// router (on the router task) and reports the latency spread. For comparing
+// firmware builds on the same setup; expect the UI to lag while it runs.
+struct BenchTest {
+  const char* name;
+  bool (*run)();
+};
 
-  // Login
-  ftpClient.printf("USER %s\r\n", runtimeConfig.mikrotikUser.c_str());
-  ftpReadLine(ftpClient);
+bool benchStatus() {
+  return !fetchStatusSnapshot().failed;
+}
 
-  ftpClient.printf("PASS %s\r\n", runtimeConfig.mikrotikPass.c_str());
-  String loginResp = ftpReadLine(ftpClient);
-  if (!loginResp.startsWith("230")) {
-    Serial.printf("FTP: Login failed: %s\n", loginResp.c_str());
-    ftpClient.stop();
-    return 0;
-  }
+bool benchInterface() {
+  WirelessInterfaceState state;
+  return fetchWirelessInterfaceState(state);
+}
 
-  // Enter passive mode
-  ftpClient.print("PASV\r\n");
-  String pasvResponse = ftpReadLine(ftpClient);
-  Serial.printf("FTP PASV: %s\n", pasvResponse.c_str());
+bool benchProfiles() {
+  size_t count = 0;
+  return mikrotikForEach("/interface/wireless/security-profiles"
+                         "?.proplist=.id,name,comment,mode,authentication-types,wpa2-pre-shared-key",
+                         profileListFilter(), [&](JsonObject) {
+    count++;
+    return true;
+  });
+}
 
-  // Parse PASV response: 227 Entering Passive Mode (h1,h2,h3,h4,p1,p2)
-  int dataPort = 0;
-  int startIdx = pasvResponse.indexOf('(');
-  int endIdx = pasvResponse.indexOf(')');
-  if (startIdx > 0 && endIdx > startIdx) {
-    String portInfo = pasvResponse.substring(startIdx + 1, endIdx);
-    int lastComma = portInfo.lastIndexOf(',');
-    int secondLastComma = portInfo.lastIndexOf(',', lastComma - 1);
-    if (lastComma > 0 && secondLastComma > 0) {
-      int p1 = portInfo.substring(secondLastComma + 1, lastComma).toInt();
-      int p2 = portInfo.substring(lastComma + 1).toInt();
-      dataPort = p1 * 256 + p2;
-      Serial.printf("FTP: Data port: %d\n", dataPort);
-    }
+// Download and parse the last save-file again through the normal fetcher,
+// without starting a new scan on the router. Runs on the live fetcher, so the
+// user's scan state and table are saved first and put back afterwards; the
+// result handlers report a pending scan meanwhile.
+bool benchScanFetch() {
+  ScanState saved;
+  std::vector<ScanNetwork> savedEntries;
+  size_t savedDropped = 0;
+  {
+    SharedStateLock lock;
+    saved = scanState();
+    savedEntries.assign(scanTable().entries, scanTable().entries + scanTable().count);
+    savedDropped = scanTable().dropped;
+    scanFetcherReset();
+    unsigned long now = millis();
+    scanState().isScanning = true;
+    scanState().benchmark = true;
+    scanState().hasResult = false;
+    scanState().result = "";
+    scanState().resultEtag = "";
+    scanState().background = true;
+    scanState().restMode = false;
+    scanState().triggerPending = false;
+    scanState().errorStatus = "";
+    scanState().error = "";
+    scanState().csvFilename = targetScanFilename();
+    scanState().companionBand = "";
+    scanState().companionInterfaceId = "";
+    scanState().companionPending = false;
+    scanState().startTime = now;
+    scanState().triggerAt = now;
+    scanState().minReadyMs = 0;
+    scanState().pollIntervalMs = SCAN_POLL_INTERVAL_MS;
+    scanState().resultTimeoutMs = SCAN_RESULT_GRACE_MS;
   }
-
-  if (dataPort == 0) {
-    Serial.println("FTP: Failed to parse PASV response");
-    ftpClient.stop();
-    return 0;
+  while (scanState().isScanning) {
+    handleScanFetchTasks();
+    delay(1);
   }
+  SharedStateLock lock;
+  bool ok = scanState().errorStatus.length() == 0;
+  scanFetcherReset();
+  scanState() = std::move(saved);
+  std::copy(savedEntries.begin(), savedEntries.end(), scanTable().entries);
+  scanTable().count = savedEntries.size();
+  scanTable().dropped = savedDropped;
+  return ok;
+}
 
-  // Connect data channel
-  if (!ftpDataClient.connect(runtimeConfig.mikrotikIp.c_str(), dataPort)) {
-    Serial.println("FTP: Data connection failed");
-    ftpClient.stop();
-    return 0;
-  }
+const BenchTest BENCH_TESTS[] = {
+  {"status", benchStatus},
+  {"interface", benchInterface},
+  {"profiles", benchProfiles},
+  {"scan", benchScanFetch},
+};
 
-  // Request file
-  ftpClient.printf("RETR %s\r\n", filename);
-  String retrResp = ftpReadLine(ftpClient);
-  Serial.printf("FTP RETR: %s\n", retrResp.c_str());
-  if (!retrResp.startsWith("150") && !retrResp.startsWith("125")) {
-    Serial.println("FTP: RETR failed");
-    ftpDataClient.stop();
-    ftpClient.stop();
+float benchPercentileMs(const std::vector<uint32_t>& sortedUs, int percentile) {
+  if (sortedUs.empty()) {
     return 0;
   }
+  size_t index = (sortedUs.size() * percentile + 99) / 100;
+  index = index > 0 ? index - 1 : 0;
+  return sortedUs[min(index, sortedUs.size() - 1)] / 1000.0f;
+}
 
-  // Stream file content directly to output client
-  unsigned long start = millis();
-  ftpDataClient.setTimeout(1000);
-  size_t totalBytes = 0;
-  uint8_t buffer[512];
+// POST /api/bench?iterations=10&tests=status,interface,profiles,scan
+void handleBench() {
+  if (!ensureOperationAllowed()) return;
+  if (!BENCH_ENABLED) {
+    apiSend(404, "application/json", "{\"error\":\"bench_disabled\"}");
+    return;
+  }
+  if (scanState().isScanning) {
+    apiSend(409, "application/json", "{\"error\":\"scan_running\"}");
+    return;
+  }
+  int iterations = apiHasArg("iterations") ? apiArg("iterations").toInt() : 10;
+  iterations = constrain(iterations, 1, BENCH_MAX_ITERATIONS);
+  String selected = apiArg("tests");
 
-  while (ftpDataClient.connected() || ftpDataClient.available()) {
-    if (millis() - start > timeoutMs) {
-      Serial.println("FTP: Download timeout");
-      break;
+  DynamicJsonDocument doc(1536);
+  doc["iterations"] = iterations;
+  uint32_t heapBefore = ESP.getFreeHeap();
+  uint32_t heapLow = heapBefore;
+  JsonObject results = doc.createNestedObject("tests");
+  std::vector<uint32_t> samples;
+  samples.reserve(iterations);
+
+  for (const BenchTest& test : BENCH_TESTS) {
+    if (selected.length() > 0 && ("," + selected + ",").indexOf("," + String(test.name) + ",") < 0) {
+      continue;
+    }
+    JsonObject result = results.createNestedObject(test.name);
+    if (strcmp(test.name, "scan") == 0 && runtimeConfig.scanMode == "rest") {
+      result["skipped"] = "rest_mode";  // Would run a real scan on every iteration
+      continue;
     }
 
-    if (ftpDataClient.available()) {
-      int bytesRead = ftpDataClient.read(buffer, sizeof(buffer));
-      if (bytesRead > 0) {
-        outputClient.write(buffer, bytesRead);
-        totalBytes += bytesRead;
-        start = millis();  // Reset timeout
-      }
-    } else {
-      delay(1);
+    samples.clear();
+    int failures = 0;
+    unsigned long bytesBefore = mikrotikSession().responseBytes + benchScanBytes;
+    unsigned long requestsBefore = mikrotikSession().requestCount;
+    for (int i = 0; i < iterations; i++) {
+      unsigned long startUs = micros();
+      bool ok = test.run();
+      samples.push_back(micros() - startUs);
+      if (!ok) failures++;
+      heapLow = min(heapLow, ESP.getFreeHeap());
     }
+    std::sort(samples.begin(), samples.end());
+
+    uint64_t totalUs = 0;
+    for (uint32_t sample : samples) totalUs += sample;
+    result["failures"] = failures;
+    result["min_ms"] = samples.front() / 1000.0f;
+    result["median_ms"] = benchPercentileMs(samples, 50);
+    result["p99_ms"] = benchPercentileMs(samples, 99);
+    result["max_ms"] = samples.back() / 1000.0f;
+    result["avg_ms"] = static_cast<float>(totalUs / samples.size()) / 1000.0f;
+    result["bytes"] = mikrotikSession().responseBytes + benchScanBytes - bytesBefore;
+    result["router_requests"] = mikrotikSession().requestCount - requestsBefore;
+    Serial.printf("  Bench %s: median %.1f ms, p99 %.1f ms, %d failure(s)\n", test.name,
+                  result["median_ms"].as<float>(), result["p99_ms"].as<float>(), failures);
   }
 
-  Serial.printf("FTP: Streamed %d bytes\n", totalBytes);
+  JsonObject heap = doc.createNestedObject("heap");
+  heap["before"] = heapBefore;
+  heap["low_water"] = heapLow;
+  heap["min_since_boot"] = ESP.getMinFreeHeap();
+  heap["after"] = ESP.getFreeHeap();
 
-  ftpDataClient.stop();
-  ftpReadLine(ftpClient);  // Read transfer complete message
-  ftpClient.print("QUIT\r\n");
-  ftpClient.stop();
+  String json;
+  serializeJson(doc, json);
+  apiSend(200, "application/json", json);
+}
 
-  return totalBytes;
+// Progress of the running scan, shared by /api/scan/result and the event stream
+void describeScanProgress(JsonDocument& doc) {
+  unsigned long elapsedMs = millis() - scanState().startTime;
+  doc["status"] = "pending";
+  doc["stage"] = elapsedMs < scanState().minReadyMs ? "scanning" : scanFetchStageName(scanFetcher().stage);
+  doc["elapsed_ms"] = elapsedMs;
+  doc["attempts"] = scanFetcher().attempts;
+  doc["probes"] = scanFetcher().probes;
+  doc["bytes"] = scanFetcher().bytes;
 }
 
 void handleScanResult() {
   if (!ensureOperationAllowed()) return;
 
-  // Serve cached result if one exists
-  if (scanState.hasResult) {
-    unsigned long cacheAge = millis() - scanState.resultTimestamp;
+  // Decide and copy under the lock, send after it: a slow client must not
+  // hold up the router tasks
+  bool cached = false;
+  bool notModified = false;
+  String etag;
+  String response;
+  {
+    SharedStateLock lock;
+
+    // Serve cached result if one exists
+    if (scanState().hasResult) {
+      unsigned long cacheAge = millis() - scanState().resultTimestamp;
+
+      // Check if cache is still valid
+      if (cacheAge <= SCAN_RESULT_CACHE_MS) {
+        // Cache still valid, serve result (can be retrieved multiple times).
+        // Clients revalidate with If-None-Match and get a body-less 304.
+        cached = true;
+        etag = scanState().resultEtag;
+        notModified = clientHasEtag(etag);
+        if (notModified) {
+          scanState().notModifiedCount++;
+        } else {
+          scanState().cacheHits++;
+          response = scanState().result;
+        }
+      } else {
+        // Cache expired, clean up
+        Serial.printf("Scan result cache expired (age: %lu ms) - cleaning up\n", cacheAge);
+        scanState().hasResult = false;
+        scanState().result = "";
+        scanState().resultEtag = "";
+        scanState().isScanning = false;
+        // Fall through to "no_result" response
+      }
+    }
 
-    // Check if cache is still valid
-    if (cacheAge <= SCAN_RESULT_CACHE_MS) {
-      // Cache still valid, serve result (can be retrieved multiple times)
-      server.send(200, "application/json", scanState.result);
-      return;
+    if (cached) {
+      // Sent below
+    } else if (scanState().benchmark) {
+      // The fetcher is busy with /api/bench: the user's result is back afterwards
+      response = "{\"status\":\"pending\",\"stage\":\"scanning\"}";
+    } else if (!scanState().isScanning && scanState().errorStatus.length() > 0) {
+      // Report a failed fetch once, then fall back to "no_result"
+      StaticJsonDocument<256> doc;
+      doc["status"] = scanState().errorStatus;
+      doc["error"] = scanState().error;
+      scanState().errorStatus = "";
+      scanState().error = "";
+      serializeJson(doc, response);
+    } else if (!scanState().isScanning) {
+      // If no scan is running, return informative status
+      response = "{\"status\":\"no_result\",\"error\":\"No scan in progress\"}";
     } else {
-      // Cache expired, clean up
-      Serial.printf("Scan result cache expired (age: %lu ms) - cleaning up\n", cacheAge);
-      scanState.hasResult = false;
-      scanState.result = "";
-      scanState.isScanning = false;
-      // Fall through to "no_result" response
+      // Still scanning or downloading: report progress only
+      StaticJsonDocument<192> doc;
+      describeScanProgress(doc);
+      serializeJson(doc, response);
     }
   }
 
-  // If no scan is running, return informative status
-  if (!scanState.isScanning) {
-    server.send(200, "application/json", "{\"status\":\"no_result\",\"error\":\"No scan in progress\"}");
-    return;
-  }
-
-  // Skip CSV lookup until the expected MikroTik scan duration elapsed
-  unsigned long elapsedMs = millis() - scanState.startTime;
-  unsigned long minReadyMs = scanState.minReadyMs > 0 ? scanState.minReadyMs
-                                                     : static_cast<unsigned long>(runtimeConfig.scanDurationSeconds) * 1000UL;
-  unsigned long timeoutMs = scanState.resultTimeoutMs > 0 ? scanState.resultTimeoutMs
-                                                          : (minReadyMs + SCAN_RESULT_GRACE_MS + SCAN_POLL_INTERVAL_MS);
-
-  if (elapsedMs < minReadyMs) {
-    server.send(200, "application/json", "{\"status\":\"pending\"}");
-    return;
+  if (cached) {
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
   }
-
-  // Timeout guard - only after minimum scan duration has passed
-  if (elapsedMs > timeoutMs) {
-    Serial.printf("  Scan timeout after %lu ms (limit %lu ms)\n", elapsedMs, timeoutMs);
-    scanState.isScanning = false;
-    server.send(200, "application/json", "{\"status\":\"timeout\",\"error\":\"Scan result file not found after timeout - check MikroTik scan configuration\"}");
+  if (notModified) {
+    server.send(304);
     return;
   }
+  server.send(200, "application/json", response);
+}
 
-  // Try to download CSV directly via FTP (no need to check via REST API first)
-  String expectedFile = scanState.csvFilename.length() > 0 ? scanState.csvFilename : String(SCAN_CSV_FILENAME);
-  Serial.printf("  Attempting FTP download of: %s\n", expectedFile.c_str());
-
-  // Get profiles for metadata
-  DynamicJsonDocument profilesDoc(JSON_BUFFER_SCAN_RESPONSE);
-  String profilesResponse = mikrotikRequest("GET", "/interface/wireless/security-profiles");
-  deserializeJson(profilesDoc, profilesResponse);
-
-  // Build profiles JSON manually
-  String profilesJson = "[";
-  bool firstProfile = true;
-  if (profilesDoc.is<JsonArray>()) {
-    for (JsonObject profile : profilesDoc.as<JsonArray>()) {
-      String comment = profile["comment"] | "";
-      if (comment.startsWith(PROFILE_COMMENT_PREFIX)) {
-        if (!firstProfile) profilesJson += ",";
-        firstProfile = false;
-
-        String ssid = comment.substring(strlen(PROFILE_COMMENT_PREFIX));
-        String name = profile["name"] | "";
-        String mode = profile["mode"] | "";
-        String authTypes = profile["authentication-types"] | "";
-
-        // Escape JSON strings
-        ssid.replace("\"", "\\\"");
-        name.replace("\"", "\\\"");
-        mode.replace("\"", "\\\"");
-        authTypes.replace("\"", "\\\"");
-
-        profilesJson += "{";
-        profilesJson += "\"ssid\":\"" + ssid + "\",";
-        profilesJson += "\"name\":\"" + name + "\",";
-        profilesJson += "\"mode\":\"" + mode + "\",";
-        profilesJson += "\"authentication-types\":\"" + authTypes + "\"";
-        profilesJson += "}";
-      }
-    }
-  }
-  profilesJson += "]";
-
-  // First, check if CSV file exists by trying a quick FTP download
-  // We must check BEFORE sending HTTP headers!
-  size_t csvBytes = 0;
-  bool ftpConnected = false;
-  WiFiClient ftpClient;
-  WiFiClient ftpDataClient;
-  int dataPort = 0;
+// Same cached table as /api/scan/result in the compact binary encoding
+void handleScanResultBinary() {
+  if (!ensureOperationAllowed()) return;
 
+  // Only loop() serves this route, so the static buffer has a single user.
+  // The table is encoded under the lock and sent after it.
+  static uint8_t buffer[7 + 255 + SCAN_MAX_NETWORKS * (11 + 32)];
+  size_t length = 0;
+  bool available = false;
+  bool scanning = false;
+  bool notModified = false;
+  String etag;
   {
-    // Quick FTP check
-    if (ftpClient.connect(runtimeConfig.mikrotikIp.c_str(), 21)) {
-      ftpClient.setTimeout(2000);
-      ftpReadLine(ftpClient);  // Welcome
-      ftpClient.printf("USER %s\r\n", runtimeConfig.mikrotikUser.c_str());
-      ftpReadLine(ftpClient);
-      ftpClient.printf("PASS %s\r\n", runtimeConfig.mikrotikPass.c_str());
-      String loginResp = ftpReadLine(ftpClient);
-
-      if (loginResp.startsWith("230")) {
-        ftpClient.print("PASV\r\n");
-        String pasvResp = ftpReadLine(ftpClient);
-
-        int startIdx = pasvResp.indexOf('(');
-        int endIdx = pasvResp.indexOf(')');
-        if (startIdx > 0 && endIdx > startIdx) {
-          String portInfo = pasvResp.substring(startIdx + 1, endIdx);
-          int lastComma = portInfo.lastIndexOf(',');
-          int secondLastComma = portInfo.lastIndexOf(',', lastComma - 1);
-          if (lastComma > 0 && secondLastComma > 0) {
-            int p1 = portInfo.substring(secondLastComma + 1, lastComma).toInt();
-            int p2 = portInfo.substring(lastComma + 1).toInt();
-            dataPort = p1 * 256 + p2;
-          }
-        }
-
-        if (dataPort > 0 && ftpDataClient.connect(runtimeConfig.mikrotikIp.c_str(), dataPort)) {
-          ftpClient.printf("RETR %s\r\n", expectedFile.c_str());
-          String retrResp = ftpReadLine(ftpClient);
-
-          // Check if file exists (150 = file status ok, starting transfer)
-          if (retrResp.startsWith("150")) {
-            ftpConnected = true;
-            // Keep connections open for streaming
-          } else {
-            // File doesn't exist yet
-            ftpDataClient.stop();
-            ftpClient.print("QUIT\r\n");
-            ftpClient.stop();
-            Serial.println("  CSV not available yet - returning pending");
-            scanState.isScanning = true;  // Keep scanning state
-            server.send(200, "application/json", "{\"status\":\"pending\"}");
-            return;
-          }
-        }
+    SharedStateLock lock;
+    // The router task refills the table during /api/bench: never encode it then
+    available = !scanState().benchmark && scanState().hasResult &&
+                millis() - scanState().resultTimestamp <= SCAN_RESULT_CACHE_MS;
+    scanning = scanState().isScanning;
+    if (available) {
+      etag = makeEtag(scanState().resultHash, "-b");
+      notModified = clientHasEtag(etag);
+      if (notModified) {
+        scanState().notModifiedCount++;
+      } else {
+        length = scanTableToBinary(scanTable(), buffer, sizeof(buffer), scanState().band.c_str());
+        scanState().cacheHits++;
       }
     }
   }
 
-  if (!ftpConnected) {
-    Serial.println("  FTP connection failed - returning pending");
-    scanState.isScanning = true;
-    server.send(200, "application/json", "{\"status\":\"pending\"}");
+  if (!available) {
+    server.sendHeader("X-Scan-Status", scanning ? "pending" : "no_result");
+    server.send(204);
     return;
   }
 
-  // FTP is connected and file exists - now we can start streaming HTTP response
-  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-  server.send(200, "application/json", "");
-
-  // Send JSON prefix
-  String band = scanState.band;
-  band.replace("\"", "\\\"");
-  server.sendContent("{\"csv\":\"");
-
-  // Stream CSV via FTP (already connected), escaping special JSON characters on the fly
-  {
-    // Stream and escape
-    unsigned long start = millis();
-    uint8_t buffer[256];
-    String chunk;  // Accumulate escaped data before sending
-    chunk.reserve(512);  // Pre-allocate to reduce reallocations
-
-    while ((ftpDataClient.connected() || ftpDataClient.available()) && (millis() - start < 8000)) {
-      if (ftpDataClient.available()) {
-        int bytesRead = ftpDataClient.read(buffer, sizeof(buffer));
-        if (bytesRead > 0) {
-          // Escape JSON special characters: \ " \n \r \t
-          for (int i = 0; i < bytesRead; i++) {
-            char c = buffer[i];
-            if (c == '\\' || c == '\"') {
-              chunk += '\\';
-              chunk += c;
-            } else if (c == '\n') {
-              chunk += "\\n";
-            } else if (c == '\r') {
-              chunk += "\\r";
-            } else if (c == '\t') {
-              chunk += "\\t";
-            } else {
-              chunk += c;
-            }
-            csvBytes++;
-
-            // Send chunk every 256 bytes to avoid too much buffering
-            if (chunk.length() >= 256) {
-              server.sendContent(chunk);
-              chunk = "";
-            }
-          }
-          start = millis();
-        }
-      } else {
-        delay(1);
-      }
-    }
-
-    // Send any remaining data
-    if (chunk.length() > 0) {
-      server.sendContent(chunk);
-    }
-
-    ftpDataClient.stop();
-    ftpClient.print("QUIT\r\n");
-    ftpClient.stop();
+  server.sendHeader("ETag", etag);
+  server.sendHeader("Cache-Control", "no-cache");
+  if (notModified) {
+    server.send(304);
+    return;
   }
+  server.setContentLength(length);
+  server.send(200, "application/octet-stream", "");
+  server.sendContent(reinterpret_cast<const char*>(buffer), length);
+}
 
-  Serial.printf("  Streamed %d CSV bytes\n", csvBytes);
-
-  // Send JSON suffix
-  server.sendContent("\",\"band\":\"" + band + "\",\"profiles\":" + profilesJson + "}");
+// Per-step timing of a connect, returned to the client
+struct ConnectStepLog {
+  JsonArray steps;
+  unsigned long stepStartedAt = 0;
+  unsigned long requestsAtStart = 0;
 
-  // Mark scan complete
-  scanState.isScanning = false;
-  scanState.hasResult = false;  // Don't cache streamed responses
+  void begin() {
+    stepStartedAt = millis();
+    requestsAtStart = mikrotikSession().requestCount;
+  }
 
-  // Note: CSV file is kept on MikroTik for multiple clients to retrieve
-  // It will be overwritten on next scan (same filename)
-}
+  void end(const char* name, const String& action) {
+    JsonObject step = steps.createNestedObject();
+    step["step"] = name;
+    step["action"] = action;
+    step["ms"] = millis() - stepStartedAt;
+    step["requests"] = mikrotikSession().requestCount - requestsAtStart;
+    begin();
+  }
+};
 
+// Connect in three phases: read the current state (profile/connect-list index
+// plus one filtered interface lookup), diff it against the request, then send
+// only the writes that change something.
 void handleConnect() {
   if (!ensureOperationAllowed()) return;
-  String body = server.arg("plain");
+  String body = apiArg("plain");
 
   DynamicJsonDocument doc(JSON_BUFFER_CONNECT_REQUEST);
   deserializeJson(doc, body);
@@ -1310,67 +5003,81 @@ void handleConnect() {
   bool connectToSpecificAp = doc["connectToSpecificAp"] | false;
   String apMacAddress = doc["apMacAddress"] | "";
 
-  // Create or update security profile
-  String profileNameResult = ensureSecurityProfile(ssid, password, requiresPassword, known, profileName);
-
-  String wlanId;
-  String currentBand;
-  if (!fetchConfiguredWirelessInterface(wlanId, currentBand)) {
-    server.send(404, "application/json", "{\"error\":\"Configured WLAN interface not found\"}");
+  unsigned long startMs = millis();
+  unsigned long requestsBefore = mikrotikSession().requestCount;
+  DynamicJsonDocument responseDoc(JSON_BUFFER_CONNECT_RESPONSE);
+  ConnectStepLog log;
+  log.steps = responseDoc.createNestedArray("steps");
+  log.begin();
+
+  // 1. Current state
+  bool indexReady = managedIndexEnsure();
+  WirelessInterfaceState iface;
+  bool ifaceCached = wirelessInterfaceCache().valid;
+  if (!getWirelessInterfaceState(iface)) {
+    apiSend(404, "application/json", "{\"error\":\"Configured WLAN interface not found\"}");
     return;
   }
+  log.end("state", !indexReady ? "index_unavailable" : ifaceCached ? "cached" : "loaded");
 
-  String wlanName = runtimeConfig.mikrotikWlanInterface;
+  // 2. Security profile
+  String profileAction;
+  String profileNameResult = ensureSecurityProfile(ssid, password, requiresPassword, known, profileName, profileAction);
+  log.end("profile", profileAction);
 
-  // Handle Connection List
-  if (connectToSpecificAp && apMacAddress.length() > 0) {
+  String wlanName = targetConfig().wlanInterface;
+  bool useConnectList = connectToSpecificAp && apMacAddress.length() > 0;
+
+  // 3. Connection list
+  if (useConnectList) {
     // Connect to specific AP using Connection List
     Serial.println("  Connecting to specific AP via Connection List");
-    ensureConnectionList(ssid, apMacAddress, wlanName, profileNameResult);
-
-    // Configure interface with station-roaming disabled (required for connect-list)
-    DynamicJsonDocument configDoc(JSON_BUFFER_CONNECT_PAYLOAD);
-    configDoc["mode"] = "station";
-    configDoc["band"] = band;
-    configDoc["security-profile"] = profileNameResult;
-    configDoc["station-roaming"] = "disabled";
-    configDoc["disabled"] = "no";
-
-    String config;
-    serializeJson(configDoc, config);
-    mikrotikRequest("PATCH", "/interface/wireless/" + wlanId, config);
+    String listAction;
+    ensureConnectionList(ssid, apMacAddress, wlanName, profileNameResult, listAction);
+    log.end("connect_list", listAction);
   } else {
-    // Normal connection (no specific AP)
+    // Normal connection (no specific AP): drop any connection list for this SSID
     Serial.println("  Connecting to any AP for SSID");
+    log.end("connect_list", deleteConnectionList(ssid) > 0 ? "deleted" : "unchanged");
+  }
 
-    // Delete any existing connection list for this SSID
-    deleteConnectionList(ssid);
-
-    // Configure interface with user's station-roaming preference
-    DynamicJsonDocument configDoc(JSON_BUFFER_CONNECT_PAYLOAD);
-    configDoc["mode"] = "station";
-    configDoc["ssid"] = ssid;
-    configDoc["band"] = band;
-    configDoc["security-profile"] = profileNameResult;
-    configDoc["station-roaming"] = runtimeConfig.stationRoaming ? "enabled" : "disabled";
-    configDoc["disabled"] = "no";
-
+  // 4. Interface: station-roaming must be off for connect-list, otherwise the user's preference
+  String desiredRoaming = useConnectList ? "disabled" : (runtimeConfig.stationRoaming ? "enabled" : "disabled");
+  DynamicJsonDocument configDoc(JSON_BUFFER_CONNECT_PAYLOAD);
+  if (iface.mode != "station") configDoc["mode"] = "station";
+  if (!useConnectList && iface.ssid != ssid) configDoc["ssid"] = ssid;
+  if (iface.band != band) configDoc["band"] = band;
+  if (iface.securityProfile != profileNameResult) configDoc["security-profile"] = profileNameResult;
+  if (iface.stationRoaming != desiredRoaming) configDoc["station-roaming"] = desiredRoaming;
+  if (iface.disabled) configDoc["disabled"] = "no";
+
+  if (configDoc.size() > 0) {
     String config;
     serializeJson(configDoc, config);
-    mikrotikRequest("PATCH", "/interface/wireless/" + wlanId, config);
+    String response = mikrotikRequest("PATCH", "/interface/wireless/" + iface.id, config);
+    wirelessInterfaceCacheAfterPatch(response, configDoc);
+    log.end("interface", mikrotikWriteSucceeded(response) ? "updated" : "failed");
+  } else {
+    log.end("interface", "unchanged");
   }
 
-  server.send(200, "application/json", "{\"success\":true}");
+  invalidateStatusCache();
+  responseDoc["success"] = true;
+  responseDoc["total_ms"] = millis() - startMs;
+  responseDoc["requests"] = mikrotikSession().requestCount - requestsBefore;
+  String response;
+  serializeJson(responseDoc, response);
+  apiSend(200, "application/json", response);
 }
 
 void handleDeleteProfile() {
   if (!ensureOperationAllowed()) return;
-  String body = server.arg("plain");
+  String body = apiArg("plain");
 
   DynamicJsonDocument doc(JSON_BUFFER_CONNECT_REQUEST);
   DeserializationError parseError = deserializeJson(doc, body);
   if (parseError) {
-    server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+    apiSend(400, "application/json", "{\"error\":\"Invalid JSON\"}");
     return;
   }
 
@@ -1378,53 +5085,60 @@ void handleDeleteProfile() {
   String ssid = doc["ssid"] | "";
 
   if (profileName.length() == 0 && ssid.length() == 0) {
-    server.send(400, "application/json", "{\"error\":\"Missing profileName or ssid\"}");
-    return;
-  }
-
-  DynamicJsonDocument profilesDoc(JSON_BUFFER_SECURITY_PROFILES);
-  String profilesResponse = mikrotikRequest("GET", "/interface/wireless/security-profiles");
-  DeserializationError error = deserializeJson(profilesDoc, profilesResponse);
-  if (error) {
-    Serial.printf("  ERROR: Failed to parse profiles for deletion: %s\n", error.c_str());
-    server.send(500, "application/json", "{\"error\":\"Failed to read profiles\"}");
+    apiSend(400, "application/json", "{\"error\":\"Missing profileName or ssid\"}");
     return;
   }
 
   String targetName = "";
   bool isManagedProfile = false;
-  if (profilesDoc.is<JsonArray>()) {
-    for (JsonObject profile : profilesDoc.as<JsonArray>()) {
-      String pName = profile["name"] | "";
-      String pComment = profile["comment"] | "";
-      bool matchesComment = pComment == String(PROFILE_COMMENT_PREFIX) + ssid;
-      if (profileName.length() > 0 && pName == profileName && matchesComment) {
-        targetName = pName;
-        isManagedProfile = true;
-        break;
-      }
-      if (ssid.length() > 0 && matchesComment) {
-        targetName = pName;
-        isManagedProfile = true;
-        break;
-      }
+  bool ok = managedIndexEnsure();
+  for (const IndexedProfile& profile : managedIndex().profiles) {
+    bool matchesComment = profile.ssid.length() > 0 && profile.ssid == ssid;
+    if ((profileName.length() > 0 && profile.name == profileName && matchesComment) ||
+        (ssid.length() > 0 && matchesComment)) {
+      targetName = profile.name;
+      isManagedProfile = true;
+      break;
     }
   }
+  if (!ok) {
+    Serial.println("  ERROR: Failed to read profiles for deletion");
+    apiSend(500, "application/json", "{\"error\":\"Failed to read profiles\"}");
+    return;
+  }
 
   if (targetName.length() == 0 || !isManagedProfile) {
-    server.send(404, "application/json", "{\"error\":\"Managed profile not found\"}");
+    apiSend(404, "application/json", "{\"error\":\"Managed profile not found\"}");
     return;
   }
 
   String response = mikrotikRequest("DELETE", "/interface/wireless/security-profiles/" + targetName, "");
 
-  if (response.indexOf("error") != -1) {
+  if (!mikrotikWriteSucceeded(response)) {
     Serial.printf("  ERROR: Failed to delete profile %s: %s\n", targetName.c_str(), response.c_str());
-    server.send(500, "application/json", "{\"error\":\"Failed to delete profile\"}");
+    apiSend(500, "application/json", "{\"error\":\"Failed to delete profile\"}");
+    return;
+  }
+
+  managedIndexRemoveProfile(targetName);
+  apiSend(200, "application/json", "{\"success\":true}");
+}
+
+// Force a resync of the managed profile / connect-list index
+void handleProfilesResync() {
+  if (!ensureOperationAllowed()) return;
+  if (!managedIndexSync()) {
+    apiSend(502, "application/json", "{\"error\":\"Failed to read profiles\"}");
     return;
   }
 
-  server.send(200, "application/json", "{\"success\":true}");
+  StaticJsonDocument<96> doc;
+  doc["success"] = true;
+  doc["profiles"] = managedIndex().profiles.size();
+  doc["connect_entries"] = managedIndex().connectList.size();
+  String json;
+  serializeJson(doc, json);
+  apiSend(200, "application/json", json);
 }
 
 void handleDisconnect() {
@@ -1432,15 +5146,21 @@ void handleDisconnect() {
   String wlanId;
   String currentBand;
   if (!fetchConfiguredWirelessInterface(wlanId, currentBand)) {
-    server.send(404, "application/json", "{\"error\":\"Configured WLAN interface not found\"}");
+    apiSend(404, "application/json", "{\"error\":\"Configured WLAN interface not found\"}");
     return;
   }
 
   // Disable all connection lists (keep them for reconnection, but disable them)
   disableAllConnectionLists();
 
-  mikrotikRequest("PATCH", "/interface/wireless/" + wlanId, "{\"disabled\":\"yes\"}");
-  server.send(200, "application/json", "{\"success\":true}");
+  StaticJsonDocument<64> patchDoc;
+  patchDoc["disabled"] = "yes";
+  String patch;
+  serializeJson(patchDoc, patch);
+  String response = mikrotikRequest("PATCH", "/interface/wireless/" + wlanId, patch);
+  wirelessInterfaceCacheAfterPatch(response, patchDoc);
+  invalidateStatusCache();
+  apiSend(200, "application/json", "{\"success\":true}");
 }
 
 void handleCORS() {
@@ -1462,24 +5182,59 @@ void handleNotFound() {
   server.send(404, "text/plain", "404: Not Found");
 }
 
+// Runs on the WiFi event task: only flags the outcome for handleWifiTasks().
+// Our own re-configuration shows up as ASSOC_LEAVE and is not a failure.
+void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED && info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE) {
+    wifiConnectFailed = true;
+  }
+}
+
+// The first attempt after boot or a lost link goes straight to the last
+// known AP (BSSID + channel, no scan); when that fails, the next one scans
+// for the SSID. WiFi.begin() re-configures a running STA itself, so the radio
+// is not switched off in between.
 void attemptWifiConnect() {
   if (runtimeConfig.wifiSsid.length() == 0) {
     Serial.println("No WiFi SSID configured, skipping connection attempt");
     return;
   }
 
-  WiFi.disconnect(true);
-  delay(100);
+  uint8_t bssid[6];
+  bool fast = wifiUseCachedAp && runtimeConfig.wifiChannel > 0 && parseMacAddress(runtimeConfig.wifiBssid.c_str(), bssid);
+  wifiUseCachedAp = false;
+  wifiAttemptFast = fast;
+  wifiConnectFailed = false;
 
-  if (runtimeConfig.wifiPassword.length() > 0) {
-    WiFi.begin(runtimeConfig.wifiSsid.c_str(), runtimeConfig.wifiPassword.c_str());
+  const char* password = runtimeConfig.wifiPassword.length() > 0 ? runtimeConfig.wifiPassword.c_str() : nullptr;
+  if (fast) {
+    Serial.printf("WiFi: connecting to %s on channel %d\n", runtimeConfig.wifiBssid.c_str(), runtimeConfig.wifiChannel);
+    WiFi.begin(runtimeConfig.wifiSsid.c_str(), password, runtimeConfig.wifiChannel, bssid);
   } else {
-    WiFi.begin(runtimeConfig.wifiSsid.c_str());
+    WiFi.begin(runtimeConfig.wifiSsid.c_str(), password);
   }
 
   lastReconnectAttempt = millis();
 }
 
+// Remember the AP we ended up on; the config is only marked dirty when it changed
+void rememberWifiAp() {
+  const uint8_t* current = WiFi.BSSID();
+  if (current == nullptr) {
+    return;
+  }
+  char bssid[18];
+  formatMacAddress(current, bssid);
+  int channel = WiFi.channel();
+  SharedStateLock lock;
+  if (runtimeConfig.wifiBssid == bssid && runtimeConfig.wifiChannel == channel) {
+    return;
+  }
+  runtimeConfig.wifiBssid = bssid;
+  runtimeConfig.wifiChannel = channel;
+  markConfigDirty();
+}
+
 void startCaptivePortal() {
   if (captivePortalActive) return;
   Serial.printf("Starting captive portal: SSID='%s'\n", CAPTIVE_PORTAL_SSID);
@@ -1501,12 +5256,14 @@ void handleWifiTasks() {
 
   wl_status_t status = WiFi.status();
   bool connected = status == WL_CONNECTED;
+  unsigned long now = millis();
 
   if (connected) {
     if (!lastConnected) {
-      Serial.println("WiFi connected!");
+      Serial.printf("WiFi connected after %lu ms%s\n", now - wifiDownSince, wifiAttemptFast ? " (cached AP)" : "");
       Serial.print("IP address: ");
       Serial.println(WiFi.localIP());
+      rememberWifiAp();
     }
     if (captivePortalActive) {
       stopCaptivePortal();
@@ -1521,6 +5278,10 @@ void handleWifiTasks() {
   if (lastConnected) {
     Serial.println("WiFi connection lost");
     otaServiceReady = false;
+    // Try the same AP again right away
+    wifiDownSince = now;
+    wifiUseCachedAp = true;
+    wifiReconnectPending = true;
   }
   lastConnected = false;
 
@@ -1531,119 +5292,415 @@ void handleWifiTasks() {
     return;
   }
 
-  if (!captivePortalActive) {
+  // Setup AP only once the station had its chance; switching to AP+STA
+  // would move the radio off the channel it is connecting on
+  if (!captivePortalActive && now - wifiDownSince >= WIFI_INITIAL_CONNECT_TIMEOUT_MS) {
+    Serial.println("WiFi not connected, enabling captive portal");
     startCaptivePortal();
   }
 
-  unsigned long now = millis();
-  if (wifiReconnectPending || now - lastReconnectAttempt > WIFI_RECONNECT_INTERVAL_MS) {
+  // A failed direct connect falls back to a scan at once
+  bool fastAttemptFailed = wifiAttemptFast && (wifiConnectFailed || now - lastReconnectAttempt > WIFI_FAST_CONNECT_TIMEOUT_MS);
+  if (wifiReconnectPending || fastAttemptFailed || now - lastReconnectAttempt > WIFI_RECONNECT_INTERVAL_MS) {
     attemptWifiConnect();
     wifiReconnectPending = false;
   }
 }
 
+// ==================== ROUTER I/O TASK ====================
+
+// Unit of work for the router task. work() runs there; done() (optional) runs
+// afterwards on loop(), for follow-ups that belong to the main task (WiFi, UI state).
+struct RouterCommand {
+  const char* name = "";
+  std::function<void()> work;
+  std::function<void()> done;
+  DeferredRequest* request = nullptr;  // HTTP request answered by work(), if any
+  unsigned long queuedAt = 0;
+  size_t target = currentTargetIndex();  // done() runs in this target's scope
+};
+
+// Queue of the current target's router task, nullptr when it has none
+QueueHandle_t routerTaskQueue() {
+  return routerTasks[currentTargetIndex()].queue;
+}
+
+// Queue work for the current target's router task. Without the task, work()
+// and done() run inline.
+bool routerSubmit(const char* name, std::function<void()> work, std::function<void()> done = nullptr) {
+  QueueHandle_t queue = routerTaskQueue();
+  if (queue == nullptr || onRouterTask()) {
+    work();
+    if (done) done();
+    return true;
+  }
+
+  RouterCommand* command = new RouterCommand();
+  command->name = name;
+  command->work = work;
+  command->done = done;
+  command->queuedAt = millis();
+  if (xQueueSend(queue, &command, 0) != pdTRUE) {
+    delete command;
+    routerTasks[currentTargetIndex()].rejected++;
+    return false;
+  }
+  return true;
+}
+
+// Run a follow-up on loop(): from a router task it is queued as a completion
+void runOnLoop(std::function<void()> fn) {
+  if (routerTaskIndex() < 0) {
+    fn();
+    return;
+  }
+  RouterCommand* command = new RouterCommand();
+  command->name = "loop";
+  command->done = fn;
+  if (xQueueSend(routerCompletionQueue, &command, pdMS_TO_TICKS(100)) != pdTRUE) {
+    Serial.println("  WARNING: completion queue full - follow-up dropped");
+    delete command;
+  }
+}
+
+// Hand the current request to the selected target's router task. Returns
+// false when the handler should just run here (no task, or already on it).
+bool deferToRouterTask(void (*handler)()) {
+  QueueHandle_t queue = routerTaskQueue();
+  if (queue == nullptr || onRouterTask()) {
+    return false;
+  }
+
+  DeferredRequest* request = new DeferredRequest();
+  request->handler = handler;
+  for (int i = 0; i < server.args(); i++) {
+    request->args.push_back({server.argName(i), server.arg(i)});
+  }
+  if (server.hasHeader("If-None-Match")) {
+    request->ifNoneMatch = server.header("If-None-Match");
+  }
+  request->queuedAt = millis();
+  // From here on the request is answered over its own client, and loop()
+  // can take the next connection right away
+  request->client = server.detachClient();
+  // Timing continues on the router task
+  request->metric = currentEndpointMetric;
+  request->startedUs = currentEndpointStartUs;
+  currentEndpointMetric = nullptr;
+
+  // Single flight: a GET identical to one still waiting for its answer (same
+  // target, URI, arguments and If-None-Match, so the same response) joins it
+  // instead of queueing another round of router requests
+  if (server.method() == HTTP_GET) {
+    String key = String(currentTargetIndex()) + " " + server.uri();
+    for (const auto& arg : request->args) {
+      key += "&" + arg.first + "=" + arg.second;
+    }
+    key += " " + request->ifNoneMatch;
+    SharedStateLock lock;
+    for (DeferredRequest* pending : joinableRequests) {
+      if (pending->coalesceKey == key) {
+        pending->followers.push_back(request->client);
+        routerTasks[currentTargetIndex()].coalesced++;
+        delete request;
+        return true;
+      }
+    }
+    request->coalesceKey = key;
+    joinableRequests.push_back(request);
+  }
+
+  RouterCommand* command = new RouterCommand();
+  command->name = server.uri().startsWith("/api/") ? "api" : "request";
+  command->request = request;
+  command->queuedAt = request->queuedAt;
+  if (xQueueSend(queue, &command, 0) != pdTRUE) {
+    routerTasks[currentTargetIndex()].rejected++;
+    // Also takes it off joinableRequests; nothing can have joined it yet
+    deferredRespond(*request, 503, "application/json", "{\"error\":\"busy\"}");
+    delete request;
+    delete command;
+  }
+  return true;
+}
+
+// Route wrapper that points the handler at the target named by ?target=
+// (index or name, default target 0)
+std::function<void()> targetRoute(std::function<void()> handler) {
+  return [handler]() {
+    int index = findRouterTarget(server.arg("target"));
+    if (index < 0) {
+      server.send(404, "application/json", "{\"error\":\"unknown_target\"}");
+      return;
+    }
+    TargetScope scope(static_cast<size_t>(index));
+    handler();
+  };
+}
+
+// Route wrapper for handlers that talk to the router
+std::function<void()> routerRoute(void (*handler)()) {
+  return targetRoute([handler]() {
+    if (!deferToRouterTask(handler)) {
+      handler();
+    }
+  });
+}
+
+void routerTaskRun(RouterTaskSlot& task, RouterCommand* command) {
+  unsigned long startMs = millis();
+  if (startMs - command->queuedAt > task.maxWaitMs) {
+    task.maxWaitMs = startMs - command->queuedAt;
+  }
+  task.lastCommand = command->name;
+  routerTargetSync();
+
+  if (command->request != nullptr) {
+    DeferredRequest* request = command->request;
+    task.activeRequest = request;
+    request->handler();
+    if (!request->responded) {
+      deferredRespond(*request, 500, "application/json", "{\"error\":\"No response\"}");
+    }
+    if (request->metric != nullptr) {
+      metricsRecord(request->metric->latency, micros() - request->startedUs);
+    }
+    task.activeRequest = nullptr;
+    delete request;
+    command->request = nullptr;
+  } else if (command->work) {
+    command->work();
+  }
+
+  unsigned long runMs = millis() - startMs;
+  if (runMs > task.maxRunMs) {
+    task.maxRunMs = runMs;
+  }
+  task.processed++;
+
+  if (!command->done || xQueueSend(routerCompletionQueue, &command, pdMS_TO_TICKS(100)) != pdTRUE) {
+    delete command;
+  }
+}
+
+// Background router traffic of the current target (status refresh, scan
+// download, scheduled scans); paused during OTA
+void routerTargetBackgroundTasks() {
+  routerTargetSync();
+  if (routerTaskPaused || !currentTarget().active) {
+    return;
+  }
+  handleStatusCacheTasks();
+  handleScanFetchTasks();
+  handleScanSchedulerTasks();
+}
+
+// One task per target: the targets' requests, refreshes and scans overlap,
+// each waiting only on its own router
+void routerTask(void* param) {
+  RouterTaskSlot& task = routerTasks[reinterpret_cast<uintptr_t>(param)];
+  for (;;) {
+    RouterCommand* command = nullptr;
+    if (xQueueReceive(task.queue, &command, pdMS_TO_TICKS(ROUTER_TASK_IDLE_MS)) == pdTRUE) {
+      routerTaskRun(task, command);
+      // Handlers go deepest: tell when ROUTER_TASK_STACK_SIZE leaves too little headroom
+      UBaseType_t stackFree = uxTaskGetStackHighWaterMark(nullptr);
+      if (!task.stackWarned && stackFree < ROUTER_TASK_STACK_MARGIN) {
+        task.stackWarned = true;
+        Serial.printf("WARNING: Router I/O task %u has %u bytes of stack left - raise ROUTER_TASK_STACK_SIZE\n",
+                      static_cast<unsigned>(reinterpret_cast<uintptr_t>(param)), static_cast<unsigned>(stackFree));
+      }
+    }
+    routerTargetBackgroundTasks();
+  }
+}
+
+// Completion callbacks of finished router commands, run from loop()
+void handleRouterCompletions() {
+  if (routerCompletionQueue == nullptr) {
+    return;
+  }
+  RouterCommand* command = nullptr;
+  while (xQueueReceive(routerCompletionQueue, &command, 0) == pdTRUE) {
+    if (command->done) {
+      TargetScope scope(command->target);
+      command->done();
+    }
+    delete command;
+  }
+}
+
+uint32_t routerTasksGeneration = 0;  // routerTargetsGeneration the tasks were last checked at
+
+// Start the tasks of newly configured targets. A removed target's task stays
+// and idles until the slot is configured again.
+void startRouterTasks() {
+  if (!ROUTER_TASK_ENABLED || routerTasksGeneration == routerTargetsGeneration) {
+    return;
+  }
+  routerTasksGeneration = routerTargetsGeneration;
+  if (routerCompletionQueue == nullptr) {
+    routerCompletionQueue = xQueueCreate(ROUTER_TASK_QUEUE_LENGTH * ROUTER_TARGETS_MAX, sizeof(RouterCommand*));
+    if (routerCompletionQueue == nullptr) {
+      Serial.println("ERROR: Router I/O tasks could not be started - handling router traffic in loop()");
+      return;
+    }
+  }
+
+  size_t count;
+  {
+    SharedStateLock lock;
+    count = routerTargetCount();
+  }
+  for (size_t i = 0; i < count; i++) {
+    RouterTaskSlot& task = routerTasks[i];
+    if (task.handle != nullptr) {
+      continue;
+    }
+    char name[16];
+    snprintf(name, sizeof(name), i == 0 ? "router-io" : "router-io-%u", static_cast<unsigned>(i));
+    task.queue = xQueueCreate(ROUTER_TASK_QUEUE_LENGTH, sizeof(RouterCommand*));
+    if (task.queue == nullptr ||
+        xTaskCreate(routerTask, name, ROUTER_TASK_STACK_SIZE, reinterpret_cast<void*>(static_cast<uintptr_t>(i)), 1,
+                    &task.handle) != pdPASS) {
+      Serial.printf("ERROR: Router I/O task %u could not be started - handling its traffic in loop()\n",
+                    static_cast<unsigned>(i));
+      if (task.queue != nullptr) vQueueDelete(task.queue);
+      task.queue = nullptr;
+      task.handle = nullptr;
+      continue;
+    }
+    Serial.printf("Router I/O task started for target %u\n", static_cast<unsigned>(i));
+  }
+}
+
+// Targets without a task of their own run their background work from loop()
+void handleRouterTargetTasks() {
+  startRouterTasks();
+  size_t count;
+  {
+    SharedStateLock lock;
+    count = routerTargetCount();
+  }
+  for (size_t i = 0; i < ROUTER_TARGETS_MAX; i++) {
+    // Slots that were never configured have no state to work on
+    if (routerTasks[i].queue == nullptr && (i < count || routerTargets[i] != nullptr)) {
+      TargetScope scope(i);
+      routerTargetBackgroundTasks();
+    }
+  }
+}
+
 // ==================== SETUP & LOOP ====================
 
 void setup() {
   Serial.begin(115200);
-  delay(1000);  // Wait for USB-CDC connection
-
-  // Wait for Serial to become available (max 3 seconds)
+  // Boot does not wait for a serial monitor unless asked to
   unsigned long start = millis();
-  while (!Serial && (millis() - start < 3000)) {
-    delay(100);
+  while (!Serial && (millis() - start < SERIAL_WAIT_MS)) {
+    delay(10);
   }
 
   Serial.println("\n\n=== MikroTik WiFi Manager (ESP32-S2) ===");
+  sharedStateMutex = xSemaphoreCreateRecursiveMutex();
 
   // Initialize LittleFS
   Serial.println("Initializing LittleFS...");
-  bool fsAvailable = false;
   if (!LittleFS.begin(true)) {
     Serial.println("ERROR: LittleFS mount failed!");
     Serial.println("Please run 'pio run --target uploadfs'!");
   } else {
     Serial.println("LittleFS mounted successfully");
-    fsAvailable = true;
     filesystemAvailable = true;
+    loadAssetManifest();
   }
 
-  if (fsAvailable) {
-    if (!loadRuntimeConfigFromFile()) {
-      Serial.println("Using default configuration values (config file missing or invalid)");
-    }
-  } else {
-    applyDefaultConfig(runtimeConfig);
+  if (!loadRuntimeConfig()) {
+    Serial.println("Using default configuration values (config store missing or invalid)");
   }
 
+  // The station connects in the background (handleWifiTasks); the web server
+  // is up right away, and the captive portal follows if the link does not come
+  WiFi.persistent(false);
   WiFi.mode(WIFI_STA);
   WiFi.setAutoReconnect(false);
+  WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+  wifiDownSince = millis();
 
   if (runtimeConfig.wifiSsid.length() > 0) {
     attemptWifiConnect();
-    unsigned long connectStart = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - connectStart < WIFI_INITIAL_CONNECT_TIMEOUT_MS) {
-      delay(250);
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("WiFi connected!");
-      Serial.print("IP address: ");
-      Serial.println(WiFi.localIP());
-      lastReconnectAttempt = millis();
-
-      if (OTA_ENABLE) {
-        setupArduinoOTA();
-      }
-    } else {
-      Serial.println("Initial WiFi connection failed, enabling captive portal");
-      startCaptivePortal();
-      wifiReconnectPending = true;
-    }
   } else {
     Serial.println("No WiFi configuration found, enabling captive portal");
     startCaptivePortal();
   }
 
   // Register API routes
-  server.on("/api/config", HTTP_GET, handleConfig);
-  server.on("/api/status", HTTP_GET, handleStatus);
-  server.on("/api/scan/start", HTTP_POST, handleScanStart);
-  server.on("/api/scan/result", HTTP_GET, handleScanResult);
-  server.on("/api/connect", HTTP_POST, handleConnect);
-  server.on("/api/disconnect", HTTP_POST, handleDisconnect);
-  server.on("/api/profile/delete", HTTP_POST, handleDeleteProfile);
-  server.on("/api/settings", HTTP_GET, handleSettingsGet);
-  server.on("/api/settings", HTTP_POST, handleSettingsUpdate);
+  server.on("/api/config", HTTP_GET, metered("/api/config", targetRoute(handleConfig)));
+  server.on("/api/status", HTTP_GET, metered("/api/status", targetRoute(handleStatus)));
+  server.on("/api/scan/start", HTTP_POST, metered("/api/scan/start", routerRoute(handleScanStart)));
+  server.on("/api/scan/result", HTTP_GET, metered("/api/scan/result", targetRoute(handleScanResult)));
+  server.on("/api/scan/networks", HTTP_GET, metered("/api/scan/networks", targetRoute(handleScanNetworks)));
+  server.on("/api/scan/result.bin", HTTP_GET, metered("/api/scan/result.bin", targetRoute(handleScanResultBinary)));
+  server.on("/api/connect", HTTP_POST, metered("/api/connect", routerRoute(handleConnect)));
+  server.on("/api/disconnect", HTTP_POST, metered("/api/disconnect", routerRoute(handleDisconnect)));
+  server.on("/api/profile/delete", HTTP_POST, metered("/api/profile/delete", routerRoute(handleDeleteProfile)));
+  server.on("/api/profiles/resync", HTTP_POST, metered("/api/profiles/resync", routerRoute(handleProfilesResync)));
+  server.on("/api/settings", HTTP_GET, metered("/api/settings", handleSettingsGet));
+  server.on("/api/settings", HTTP_POST, metered("POST /api/settings", routerRoute(handleSettingsUpdate)));
+  server.on("/api/diagnostics", HTTP_GET, metered("/api/diagnostics", routerRoute(handleDiagnostics)));
+  server.on("/api/events", HTTP_GET, metered("/api/events", targetRoute(handleEvents)));
+  server.on("/api/metrics", HTTP_GET, handleMetrics);
+  server.on("/api/history", HTTP_GET, metered("/api/history", targetRoute(handleHistory)));
+  server.on("/api/bench", HTTP_POST, metered("/api/bench", routerRoute(handleBench)));
 
   // CORS preflight handlers
   server.on("/api/config", HTTP_OPTIONS, handleCORS);
   server.on("/api/status", HTTP_OPTIONS, handleCORS);
   server.on("/api/scan/start", HTTP_OPTIONS, handleCORS);
   server.on("/api/scan/result", HTTP_OPTIONS, handleCORS);
+  server.on("/api/scan/networks", HTTP_OPTIONS, handleCORS);
+  server.on("/api/scan/result.bin", HTTP_OPTIONS, handleCORS);
   server.on("/api/connect", HTTP_OPTIONS, handleCORS);
   server.on("/api/disconnect", HTTP_OPTIONS, handleCORS);
   server.on("/api/profile/delete", HTTP_OPTIONS, handleCORS);
+  server.on("/api/profiles/resync", HTTP_OPTIONS, handleCORS);
   server.on("/api/settings", HTTP_OPTIONS, handleCORS);
+  server.on("/api/diagnostics", HTTP_OPTIONS, handleCORS);
+  server.on("/api/events", HTTP_OPTIONS, handleCORS);
+  server.on("/api/metrics", HTTP_OPTIONS, handleCORS);
+  server.on("/api/history", HTTP_OPTIONS, handleCORS);
+  server.on("/api/bench", HTTP_OPTIONS, handleCORS);
+
+  // Request headers needed for conditional responses
+  static const char* collectedHeaders[] = {"If-None-Match", "Accept-Encoding", "Accept", "Accept-Language"};
+  server.collectHeaders(collectedHeaders, sizeof(collectedHeaders) / sizeof(collectedHeaders[0]));
 
   // Catch-all for static files
-  server.onNotFound(handleNotFound);
+  server.onNotFound(metered("static", handleNotFound));
 
   server.begin();
   Serial.printf("Web server started on port %d\n", WEB_PORT);
-  Serial.println("\n=== Ready! ===");
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.printf("Open: http://%s/\n\n", WiFi.localIP().toString().c_str());
+  startRouterTasks();
+  Serial.printf("\n=== Ready after %lu ms ===\n", millis());
+  if (runtimeConfig.wifiSsid.length() > 0) {
+    Serial.printf("Connecting to '%s' in the background (captive portal after %lu s)\n\n",
+                  runtimeConfig.wifiSsid.c_str(), WIFI_INITIAL_CONNECT_TIMEOUT_MS / 1000);
   } else {
     Serial.printf("Configure via captive portal SSID '%s' (default IP 192.168.4.1)\n\n", CAPTIVE_PORTAL_SSID);
   }
 }
 
 void loop() {
+  unsigned long iterationStartUs = micros();
   server.handleClient();
   handleWifiTasks();
+  handleRouterCompletions();
+  handleEventTasks();
+  handleRouterTargetTasks();
+  handleConfigTasks();
   if (OTA_ENABLE && otaServiceReady) {
     ArduinoOTA.handle();
   }
+  metricsRecord(loopMetrics, micros() - iterationStartUs);
   delay(2);
 }
@@ -0,0 +1,85 @@
+// BasicJsonWriter escaping and chunking
+
+#include <unity.h>
+
+#include <string>
+
+#include "JsonWriter.h"
+
+namespace {
+
+struct StringSink : JsonSink {
+  std::string out;
+  size_t writes = 0;
+  void write(const char* data, size_t length) override {
+    out.append(data, length);
+    writes++;
+  }
+};
+
+std::string quoted(const char* text) {
+  StringSink sink;
+  {
+    BasicJsonWriter<64> json(sink);
+    json.string(text);
+  }
+  return sink.out;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_plain_string_is_quoted() {
+  TEST_ASSERT_EQUAL_STRING("\"Home WiFi\"", quoted("Home WiFi").c_str());
+  TEST_ASSERT_EQUAL_STRING("\"\"", quoted("").c_str());
+}
+
+void test_quotes_and_backslashes_are_escaped() {
+  TEST_ASSERT_EQUAL_STRING("\"say \\\"hi\\\" \\\\o/\"", quoted("say \"hi\" \\o/").c_str());
+}
+
+void test_control_bytes_are_escaped() {
+  TEST_ASSERT_EQUAL_STRING("\"a\\nb\\rc\\td\"", quoted("a\nb\rc\td").c_str());
+  TEST_ASSERT_EQUAL_STRING("\"\\u0001\\u001f\\u0008\\u000c\"", quoted("\x01\x1f\b\f").c_str());
+  // DEL is not a control byte for JSON
+  TEST_ASSERT_EQUAL_STRING("\"\x7f\"", quoted("\x7f").c_str());
+}
+
+void test_utf8_passes_through_unchanged() {
+  // Multi-byte sequences are copied byte for byte, not \u-escaped
+  TEST_ASSERT_EQUAL_STRING("\"Caf\xc3\xa9 \xe2\x98\x95 \xf0\x9f\x93\xb6\"",
+                           quoted("Caf\xc3\xa9 \xe2\x98\x95 \xf0\x9f\x93\xb6").c_str());
+  TEST_ASSERT_EQUAL_STRING("\"\xc3\xbc\\n\xc3\xb6\"", quoted("\xc3\xbc\n\xc3\xb6").c_str());
+}
+
+void test_output_is_split_into_chunks() {
+  StringSink sink;
+  {
+    BasicJsonWriter<4> json(sink);
+    json.raw("{").key("ssid").string("a\"b").raw(",").key("n").number(-42L).raw("}");
+  }
+  TEST_ASSERT_EQUAL_STRING("{\"ssid\":\"a\\\"b\",\"n\":-42}", sink.out.c_str());
+  TEST_ASSERT_EQUAL(static_cast<size_t>((sink.out.size() + 3) / 4), sink.writes);
+}
+
+void test_numbers_and_booleans() {
+  StringSink sink;
+  {
+    BasicJsonWriter<64> json(sink);
+    json.number(0UL).raw(",").number(4294967295UL).raw(",").boolean(true).raw(",").boolean(false);
+  }
+  TEST_ASSERT_EQUAL_STRING("0,4294967295,true,false", sink.out.c_str());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_plain_string_is_quoted);
+  RUN_TEST(test_quotes_and_backslashes_are_escaped);
+  RUN_TEST(test_control_bytes_are_escaped);
+  RUN_TEST(test_utf8_passes_through_unchanged);
+  RUN_TEST(test_output_is_split_into_chunks);
+  RUN_TEST(test_numbers_and_booleans);
+  return UNITY_END();
+}
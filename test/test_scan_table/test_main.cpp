@@ -0,0 +1,142 @@
+// Scan CSV line parsing and the de-duplicating scan table
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "ScanTable.h"
+
+namespace {
+
+ScanNetwork parsed;
+
+bool parse(const char* text) {
+  char line[SCAN_CSV_LINE_MAX];
+  strncpy(line, text, sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\0';
+  return scanCsvParseLine(line, parsed);
+}
+
+ScanNetwork network(uint8_t id, int8_t signal, const char* ssid = "net") {
+  ScanNetwork entry = {};
+  entry.bssid[0] = 0x02;
+  entry.bssid[5] = id;
+  entry.signal = signal;
+  strncpy(entry.ssid, ssid, sizeof(entry.ssid) - 1);
+  return entry;
+}
+
+bool contains(const ScanTable& table, uint8_t id) {
+  for (size_t i = 0; i < table.count; i++) {
+    if (table.entries[i].bssid[5] == id) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_csv_line_fields() {
+  TEST_ASSERT_TRUE(parse("AA:BB:CC:DD:EE:01,Home,2412/20-Ce/gn,-61,-95,privacy"));
+  const uint8_t expected[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x01};
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, parsed.bssid, 6);
+  TEST_ASSERT_EQUAL_STRING("Home", parsed.ssid);
+  TEST_ASSERT_EQUAL_UINT16(2412, parsed.frequency);
+  TEST_ASSERT_EQUAL_INT8(-61, parsed.signal);
+  TEST_ASSERT_EQUAL_UINT8(SCAN_FLAG_PRIVACY, parsed.flags);
+
+  TEST_ASSERT_TRUE(parse("aa:bb:cc:dd:ee:02, Open ,5180/20/ac,-70,-96,"));
+  TEST_ASSERT_EQUAL_STRING("Open", parsed.ssid);
+  TEST_ASSERT_EQUAL_UINT8(0, parsed.flags);
+}
+
+void test_csv_quoted_ssid_keeps_embedded_commas() {
+  TEST_ASSERT_TRUE(parse("AA:BB:CC:DD:EE:03,\"Cafe, upstairs\",2437/20/gn,-55,-95,privacy"));
+  TEST_ASSERT_EQUAL_STRING("Cafe, upstairs", parsed.ssid);
+  TEST_ASSERT_EQUAL_INT8(-55, parsed.signal);
+  TEST_ASSERT_EQUAL_UINT8(SCAN_FLAG_PRIVACY, parsed.flags);
+
+  // Quote characters only toggle quoting and are dropped
+  TEST_ASSERT_TRUE(parse("AA:BB:CC:DD:EE:04,'Bob''s,net',2462/20/gn,-80,-95,"));
+  TEST_ASSERT_EQUAL_STRING("Bobs,net", parsed.ssid);
+  TEST_ASSERT_EQUAL_INT8(-80, parsed.signal);
+}
+
+void test_csv_rejects_hidden_and_malformed_lines() {
+  TEST_ASSERT_FALSE(parse("AA:BB:CC:DD:EE:05,,2412/20/gn,-60,-95,privacy"));
+  TEST_ASSERT_FALSE(parse("AA:BB:CC:DD:EE:06,\"\",2412/20/gn,-60,-95,privacy"));
+  TEST_ASSERT_FALSE(parse("AA:BB:CC:DD:EE:07,   ,2412/20/gn,-60,-95,privacy"));
+  TEST_ASSERT_FALSE(parse("address,ssid,channel,sig,nf,privacy"));
+  TEST_ASSERT_FALSE(parse("AA:BB:CC:DD:EE:08,Short,2412"));
+  TEST_ASSERT_FALSE(parse(""));
+}
+
+void test_csv_signal_is_clamped() {
+  TEST_ASSERT_TRUE(parse("AA:BB:CC:DD:EE:09,Far,2412/20/gn,-200,-95,"));
+  TEST_ASSERT_EQUAL_INT8(-128, parsed.signal);
+}
+
+void test_table_dedupes_by_bssid_keeping_the_strongest() {
+  ScanTableBuffer<4> table;
+  scanTableAdd(table, network(1, -70, "weak"));
+  scanTableAdd(table, network(1, -50, "strong"));
+  scanTableAdd(table, network(1, -60, "middle"));
+  TEST_ASSERT_EQUAL(1, table.count);
+  TEST_ASSERT_EQUAL_INT8(-50, table.entries[0].signal);
+  TEST_ASSERT_EQUAL_STRING("strong", table.entries[0].ssid);
+  TEST_ASSERT_EQUAL(0, table.dropped);
+}
+
+void test_full_table_evicts_the_weakest() {
+  ScanTableBuffer<3> table;
+  scanTableAdd(table, network(1, -60));
+  scanTableAdd(table, network(2, -80));
+  scanTableAdd(table, network(3, -70));
+
+  // Stronger than the weakest entry: takes its slot
+  scanTableAdd(table, network(4, -65));
+  TEST_ASSERT_EQUAL(3, table.count);
+  TEST_ASSERT_FALSE(contains(table, 2));
+  TEST_ASSERT_TRUE(contains(table, 4));
+  TEST_ASSERT_EQUAL(1, table.dropped);
+
+  // Weaker than everything: ignored, still counted as dropped
+  scanTableAdd(table, network(5, -90));
+  TEST_ASSERT_FALSE(contains(table, 5));
+  TEST_ASSERT_EQUAL(2, table.dropped);
+
+  // A known BSSID merges even when the table is full
+  scanTableAdd(table, network(3, -40));
+  TEST_ASSERT_EQUAL(3, table.count);
+  TEST_ASSERT_EQUAL(2, table.dropped);
+
+  scanTableClear(table);
+  TEST_ASSERT_EQUAL(0, table.count);
+  TEST_ASSERT_EQUAL(0, table.dropped);
+}
+
+void test_parse_csv_line_into_table() {
+  ScanTableBuffer<4> table;
+  char first[] = "AA:BB:CC:DD:EE:0A,Home,2412/20/gn,-70,-95,privacy";
+  char second[] = "AA:BB:CC:DD:EE:0A,Home,2412/20/gn,-58,-95,privacy";
+  char hidden[] = "AA:BB:CC:DD:EE:0B,,2412/20/gn,-40,-95,privacy";
+  scanTableParseCsvLine(table, first);
+  scanTableParseCsvLine(table, second);
+  scanTableParseCsvLine(table, hidden);
+  TEST_ASSERT_EQUAL(1, table.count);
+  TEST_ASSERT_EQUAL_INT8(-58, table.entries[0].signal);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_csv_line_fields);
+  RUN_TEST(test_csv_quoted_ssid_keeps_embedded_commas);
+  RUN_TEST(test_csv_rejects_hidden_and_malformed_lines);
+  RUN_TEST(test_csv_signal_is_clamped);
+  RUN_TEST(test_table_dedupes_by_bssid_keeping_the_strongest);
+  RUN_TEST(test_full_table_evicts_the_weakest);
+  RUN_TEST(test_parse_csv_line_into_table);
+  return UNITY_END();
+}
@@ -0,0 +1,110 @@
+// Signal history ring and its downsampling
+
+#include <unity.h>
+
+#include "SignalHistory.h"
+
+namespace {
+
+HistorySample sample(uint16_t time, int8_t signal, uint8_t ccq = HISTORY_NO_CCQ, uint16_t rate = 0) {
+  return HistorySample{time, signal, ccq, rate, rate};
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_ring_overwrites_the_oldest() {
+  SignalHistoryBuffer<3> history;
+  for (uint16_t t = 1; t <= 5; t++) {
+    signalHistoryAdd(history, sample(t * 10, -60));
+  }
+  TEST_ASSERT_EQUAL(3, history.count);
+  TEST_ASSERT_EQUAL_UINT16(30, signalHistoryAt(history, 0).time);
+  TEST_ASSERT_EQUAL_UINT16(50, signalHistoryAt(history, 2).time);
+}
+
+void test_downsample_averages_into_buckets() {
+  SignalHistoryBuffer<8> history;
+  signalHistoryAdd(history, sample(10, -60, 80, 50));
+  signalHistoryAdd(history, sample(20, -70, HISTORY_NO_CCQ, 70));
+  signalHistoryAdd(history, sample(30, HISTORY_NO_SIGNAL));
+  signalHistoryAdd(history, sample(40, HISTORY_NO_SIGNAL));
+
+  HistoryBucket buckets[4];
+  TEST_ASSERT_EQUAL(2, signalHistoryDownsample(history, 40, 0, buckets, 2));
+  TEST_ASSERT_EQUAL_UINT16(2, buckets[0].samples);
+  TEST_ASSERT_EQUAL_UINT16(2, buckets[0].linked);
+  TEST_ASSERT_EQUAL_INT8(-65, buckets[0].signalAvg);
+  TEST_ASSERT_EQUAL_INT8(-70, buckets[0].signalMin);
+  TEST_ASSERT_EQUAL_UINT16(1, buckets[0].ccqSamples);
+  TEST_ASSERT_EQUAL_UINT8(80, buckets[0].ccqAvg);
+  TEST_ASSERT_EQUAL_UINT16(60, buckets[0].txRateAvg);
+  TEST_ASSERT_EQUAL_UINT16(20, buckets[0].ageS);
+
+  // No link in the whole bucket
+  TEST_ASSERT_EQUAL_UINT16(0, buckets[1].linked);
+  TEST_ASSERT_EQUAL_INT8(HISTORY_NO_SIGNAL, buckets[1].signalMin);
+  TEST_ASSERT_EQUAL_UINT16(0, buckets[1].ageS);
+
+  // Fewer samples than points: one bucket per sample
+  TEST_ASSERT_EQUAL(4, signalHistoryDownsample(history, 40, 0, buckets, 4));
+  TEST_ASSERT_EQUAL(0, signalHistoryDownsample(history, 40, 0, buckets, 0));
+}
+
+void test_downsample_window_keeps_the_newest_samples() {
+  SignalHistoryBuffer<16> history;
+  for (uint16_t t = 0; t < 10; t++) {
+    signalHistoryAdd(history, sample(100 + t * 10, static_cast<int8_t>(-50 - t)));
+  }
+
+  HistoryBucket buckets[16];
+  // now = 200: samples at 170..190 are within 30 s
+  TEST_ASSERT_EQUAL(3, signalHistoryDownsample(history, 200, 30, buckets, 16));
+  TEST_ASSERT_EQUAL_INT8(-57, buckets[0].signalAvg);
+  TEST_ASSERT_EQUAL_UINT16(10, buckets[2].ageS);
+
+  // Window older than every sample
+  TEST_ASSERT_EQUAL(0, signalHistoryDownsample(history, 1000, 30, buckets, 16));
+}
+
+void test_downsample_window_across_time_wrap() {
+  SignalHistoryBuffer<8> history;
+  // Seconds since boot modulo 65536: the last two samples come after the wrap
+  signalHistoryAdd(history, sample(65500, -80));
+  signalHistoryAdd(history, sample(65520, -60));
+  signalHistoryAdd(history, sample(4, -55));
+  signalHistoryAdd(history, sample(24, -50));
+
+  HistoryBucket buckets[8];
+  TEST_ASSERT_EQUAL(3, signalHistoryDownsample(history, 30, 50, buckets, 8));
+  TEST_ASSERT_EQUAL_INT8(-60, buckets[0].signalAvg);
+  TEST_ASSERT_EQUAL_UINT16(46, buckets[0].ageS);
+  TEST_ASSERT_EQUAL_UINT16(6, buckets[2].ageS);
+}
+
+void test_downsample_over_a_wrapped_ring() {
+  SignalHistoryBuffer<4> history;
+  for (uint16_t t = 1; t <= 6; t++) {
+    signalHistoryAdd(history, sample(t, static_cast<int8_t>(-40 - t)));
+  }
+
+  // Ring holds t = 3..6 with the oldest in the middle of the storage
+  HistoryBucket buckets[2];
+  TEST_ASSERT_EQUAL(2, signalHistoryDownsample(history, 6, 0, buckets, 2));
+  TEST_ASSERT_EQUAL_INT8(-43, buckets[0].signalAvg);  // -43, -44 truncated toward zero
+  TEST_ASSERT_EQUAL_INT8(-44, buckets[0].signalMin);
+  TEST_ASSERT_EQUAL_INT8(-46, buckets[1].signalMin);
+  TEST_ASSERT_EQUAL_UINT16(0, buckets[1].ageS);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ring_overwrites_the_oldest);
+  RUN_TEST(test_downsample_averages_into_buckets);
+  RUN_TEST(test_downsample_window_keeps_the_newest_samples);
+  RUN_TEST(test_downsample_window_across_time_wrap);
+  RUN_TEST(test_downsample_over_a_wrapped_ring);
+  return UNITY_END();
+}
@@ -0,0 +1,131 @@
+// Status digest fallbacks over hand-written RouterOS responses
+
+#include <ArduinoJson.h>
+#include <unity.h>
+
+#include "StatusDigest.h"
+
+namespace {
+
+StaticJsonDocument<1024> interfaces;
+StaticJsonDocument<1024> registrations;
+StaticJsonDocument<512> out;
+
+const char* digest(const char* interfacesJson, const char* registrationsJson) {
+  TEST_ASSERT_FALSE(deserializeJson(interfaces, interfacesJson));
+  TEST_ASSERT_FALSE(deserializeJson(registrations, registrationsJson));
+  out.clear();
+  return statusDigestLink(interfaces.as<JsonArrayConst>(), registrations.as<JsonArrayConst>(), out);
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_registration_marks_the_link() {
+  const char* active = digest(
+      "[{\"name\":\"wlan1\",\"ssid\":\"Home\",\"band\":\"2ghz-b/g/n\",\"running\":\"true\"}]",
+      "[{\"interface\":\"wlan1\",\"signal-strength\":\"-61@HT20-7\",\"signal-to-noise\":\"34\"}]");
+  TEST_ASSERT_EQUAL_STRING("wlan1", active);
+  TEST_ASSERT_TRUE(out["connected"].as<bool>());
+  TEST_ASSERT_EQUAL_STRING("Home", out["ssid"].as<const char*>());
+  TEST_ASSERT_EQUAL(-61, out["signal"].as<int>());
+  TEST_ASSERT_EQUAL(34, out["snr"].as<int>());
+  TEST_ASSERT_EQUAL_STRING("2ghz-b/g/n", out["band"].as<const char*>());
+}
+
+void test_registration_ssid_fallbacks() {
+  digest("[{\"name\":\"wlan1\"}]", "[{\"interface\":\"wlan1\",\"ssid\":\"FromRegistration\"}]");
+  TEST_ASSERT_EQUAL_STRING("FromRegistration", out["ssid"].as<const char*>());
+  TEST_ASSERT_FALSE(out.containsKey("signal"));
+
+  digest("[{\"name\":\"wlan1\"}]", "[{\"interface\":\"wlan1\",\"radio-name\":\"AP-Radio\"}]");
+  TEST_ASSERT_EQUAL_STRING("AP-Radio", out["ssid"].as<const char*>());
+}
+
+void test_registration_on_other_interface_is_ignored() {
+  const char* active = digest(
+      "[{\"name\":\"ether1\",\"running\":\"true\"},{\"name\":\"wlan1\",\"running\":\"false\",\"disabled\":\"false\"}]",
+      "[{\"interface\":\"ether1\",\"ssid\":\"Wired\"}]");
+  TEST_ASSERT_EQUAL_STRING("", active);
+  TEST_ASSERT_FALSE(out.containsKey("connected"));
+  TEST_ASSERT_FALSE(out.containsKey("connecting"));
+}
+
+void test_missing_registration_falls_back_to_running_flag() {
+  const char* active = digest(
+      "[{\"name\":\"WLAN2\",\"ssid\":\"Office\",\"band\":\"5ghz-a/n/ac\",\"running\":\"yes\"}]", "[]");
+  TEST_ASSERT_EQUAL_STRING("WLAN2", active);
+  TEST_ASSERT_TRUE(out["connected"].as<bool>());
+  TEST_ASSERT_TRUE(out["running"].as<bool>());
+  TEST_ASSERT_EQUAL_STRING("Office", out["ssid"].as<const char*>());
+  TEST_ASSERT_EQUAL_STRING("5ghz-a/n/ac", out["band"].as<const char*>());
+}
+
+void test_configured_but_not_running_is_connecting() {
+  const char* active = digest("[{\"name\":\"wlan1\",\"ssid\":\"Home\",\"running\":\"false\"}]", "[]");
+  TEST_ASSERT_EQUAL_STRING("", active);
+  TEST_ASSERT_TRUE(out["connecting"].as<bool>());
+  TEST_ASSERT_FALSE(out.containsKey("connected"));
+  TEST_ASSERT_FALSE(out["running"].as<bool>());
+  TEST_ASSERT_EQUAL_STRING("wlan1", out["interface"].as<const char*>());
+}
+
+void test_disabled_interface_only_reports_its_band() {
+  const char* active = digest(
+      "[{\"name\":\"wlan1\",\"ssid\":\"Home\",\"band\":\"2ghz-g/n\",\"running\":\"true\",\"disabled\":\" Yes \"},"
+      "{\"name\":\"wlan2\",\"band\":\"5ghz-a/n\",\"running\":\"false\",\"disabled\":\"false\"}]",
+      "[]");
+  TEST_ASSERT_EQUAL_STRING("", active);
+  TEST_ASSERT_FALSE(out.containsKey("connected"));
+  TEST_ASSERT_FALSE(out.containsKey("connecting"));
+  TEST_ASSERT_EQUAL_STRING("2ghz-g/n", out["band"].as<const char*>());
+}
+
+void test_string_booleans_other_than_truthy_words_are_false() {
+  digest("[{\"name\":\"wlan1\",\"ssid\":\"\",\"running\":\"no\"}]", "[]");
+  TEST_ASSERT_FALSE(out.containsKey("connected"));
+  digest("[{\"name\":\"wlan1\",\"ssid\":\"\",\"running\":\"enabled\"}]", "[]");
+  TEST_ASSERT_TRUE(out["connected"].as<bool>());
+}
+
+void test_link_sample_without_registration() {
+  TEST_ASSERT_FALSE(deserializeJson(registrations, "[{\"interface\":\"wlan2\",\"signal-strength\":\"-50\"}]"));
+  HistorySample none = statusDigestLinkSample(registrations.as<JsonArrayConst>(), "wlan1");
+  TEST_ASSERT_EQUAL_INT8(HISTORY_NO_SIGNAL, none.signal);
+  TEST_ASSERT_EQUAL_UINT8(HISTORY_NO_CCQ, none.ccq);
+  none = statusDigestLinkSample(registrations.as<JsonArrayConst>(), "");
+  TEST_ASSERT_EQUAL_INT8(HISTORY_NO_SIGNAL, none.signal);
+
+  // RouterOS wifi packages report no CCQ
+  HistorySample sample = statusDigestLinkSample(registrations.as<JsonArrayConst>(), "wlan2");
+  TEST_ASSERT_EQUAL_INT8(-50, sample.signal);
+  TEST_ASSERT_EQUAL_UINT8(HISTORY_NO_CCQ, sample.ccq);
+  TEST_ASSERT_EQUAL_UINT16(0, sample.txRate);
+}
+
+void test_link_sample_reads_rates_and_ccq() {
+  TEST_ASSERT_FALSE(deserializeJson(registrations,
+                                    "[{\"interface\":\"wlan1\",\"signal-strength\":\"-62@HT20-7\",\"tx-ccq\":\"140\","
+                                    "\"tx-rate\":\"65Mbps-20MHz/1S/SGI\",\"rx-rate\":\"58.5Mbps\"}]"));
+  HistorySample sample = statusDigestLinkSample(registrations.as<JsonArrayConst>(), "wlan1");
+  TEST_ASSERT_EQUAL_INT8(-62, sample.signal);
+  TEST_ASSERT_EQUAL_UINT8(100, sample.ccq);
+  TEST_ASSERT_EQUAL_UINT16(65, sample.txRate);
+  TEST_ASSERT_EQUAL_UINT16(59, sample.rxRate);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_registration_marks_the_link);
+  RUN_TEST(test_registration_ssid_fallbacks);
+  RUN_TEST(test_registration_on_other_interface_is_ignored);
+  RUN_TEST(test_missing_registration_falls_back_to_running_flag);
+  RUN_TEST(test_configured_but_not_running_is_connecting);
+  RUN_TEST(test_disabled_interface_only_reports_its_band);
+  RUN_TEST(test_string_booleans_other_than_truthy_words_are_false);
+  RUN_TEST(test_link_sample_without_registration);
+  RUN_TEST(test_link_sample_reads_rates_and_ccq);
+  return UNITY_END();
+}